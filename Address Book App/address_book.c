@@ -3,6 +3,8 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #define MAX_CONTACTS 100
 #define FILENAME "address_book.dat"
@@ -14,12 +16,24 @@ typedef struct {
     char address[100];
 } Contact;
 
+typedef struct {
+    const char *filename;
+    size_t recordSize;
+    int savedCount;
+    bool *dirty;
+} TableFile;
+
 Contact contacts[MAX_CONTACTS];
 int contactCount = 0;
+bool contactDirty[MAX_CONTACTS];
+TableFile contactTable = { FILENAME, sizeof(Contact), -1, contactDirty };
 
 // Function prototypes
 void loadContacts();
 void saveContacts();
+int loadTable(TableFile *table, void *records, int maxRecords);
+void markDirty(TableFile *table, int index);
+void saveTable(TableFile *table, const void *records, int count);
 void displayMenu();
 void addContact();
 void viewAllContacts();
@@ -54,19 +68,81 @@ int main() {
 }
 
 void loadContacts() {
-    FILE *file = fopen(FILENAME, "rb");
-    if (file != NULL) {
-        contactCount = fread(contacts, sizeof(Contact), MAX_CONTACTS, file);
-        fclose(file);
-    }
+    contactCount = loadTable(&contactTable, contacts, MAX_CONTACTS);
 }
 
 void saveContacts() {
-    FILE *file = fopen(FILENAME, "wb");
-    if (file != NULL) {
-        fwrite(contacts, sizeof(Contact), contactCount, file);
-        fclose(file);
+    saveTable(&contactTable, contacts, contactCount);
+}
+
+int loadTable(TableFile *table, void *records, int maxRecords) {
+    FILE *file = fopen(table->filename, "rb");
+    if (file == NULL) {
+        table->savedCount = -1;
+        return 0;
+    }
+    
+    int count = fread(records, table->recordSize, maxRecords, file);
+    table->savedCount = fgetc(file) == EOF ? count : -1;
+    fclose(file);
+    return count;
+}
+
+void markDirty(TableFile *table, int index) {
+    table->dirty[index] = true;
+}
+
+void saveTable(TableFile *table, const void *records, int count) {
+    const unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    
+    int fd = -1;
+    if (table->savedCount >= 0 && count >= table->savedCount) {
+        fd = open(table->filename, O_WRONLY);
+    }
+    if (fd != -1) {
+        bool ok = true;
+        int i = 0;
+        while (i < count && ok) {
+            if (i < table->savedCount && !table->dirty[i]) {
+                i++;
+                continue;
+            }
+            
+            int end = i + 1;
+            while (end < count && (end >= table->savedCount || table->dirty[end])) {
+                end++;
+            }
+            size_t length = (end - i) * size;
+            ok = pwrite(fd, bytes + i * size, length, (off_t)i * size) == (ssize_t)length;
+            i = end;
+        }
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        
+        if (ok) {
+            memset(table->dirty, 0, count * sizeof(bool));
+            table->savedCount = count;
+            return;
+        }
     }
+    
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", table->filename);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return;
+    }
+    fwrite(records, size, count, file);
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempName, table->filename) != 0) {
+        remove(tempName);
+        return;
+    }
+    
+    memset(table->dirty, 0, count * sizeof(bool));
+    table->savedCount = count;
 }
 
 void displayMenu() {
@@ -106,6 +182,7 @@ void addContact() {
     fgets(newContact.address, sizeof(newContact.address), stdin);
     newContact.address[strcspn(newContact.address, "\n")] = '\0';
     
+    markDirty(&contactTable, contactCount);
     contacts[contactCount++] = newContact;
     printf("\nContact added successfully!\n");
 }
@@ -225,6 +302,7 @@ void editContact() {
         strcpy(contacts[foundIndex].address, input);
     }
     
+    markDirty(&contactTable, foundIndex);
     printf("\nContact updated successfully!\n");
 }
 
@@ -260,6 +338,7 @@ void deleteContact() {
     // Shift all contacts after this one forward
     for (int i = foundIndex; i < contactCount - 1; i++) {
         contacts[i] = contacts[i + 1];
+        markDirty(&contactTable, i);
     }
     contactCount--;
     
@@ -4,85 +4,4180 @@
 #include <time.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <strings.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
 
-#define MAX_ACCOUNTS 100
+#define ACCOUNT_CHUNK_SHIFT 12
+#define ACCOUNT_CHUNK_SIZE (1 << ACCOUNT_CHUNK_SHIFT)
+#define ACCOUNT_CHUNK_MASK (ACCOUNT_CHUNK_SIZE - 1)
 #define FILENAME "bank_data.dat"
+#define TEMP_FILENAME "bank_data.dat.tmp"
+#define SNAPSHOT_MAGIC 0x4B4E4142U // "BANK"
+#define SNAPSHOT_VERSION 1
+#define JOURNAL_FILENAME "bank_journal.dat"
+#define JOURNAL_MAGIC 0x324E524AU // "JRN2"
+#define JOURNAL_BUFFER_RECORDS 256
+#define JOURNAL_SYNC_INTERVAL 32 // records per fsync on the interactive path
+#define CHECKPOINT_INTERVAL 10000 // journal records before the snapshot is rewritten
+#define LEDGER_FILENAME "bank_ledger.dat"
+#define LEDGER_MAGIC 0x5247444CU // "LDGR"
+#define LEDGER_SEGMENT_MAGIC 0x4745534CU // "LSEG"
+#define LEDGER_VERSION 1
+#define LEDGER_SEGMENT_ROWS 65536 // tail rows kept in memory before a segment is written
+#define AUDIT_FILENAME "bank_audit.dat" // active segment; closed ones are bank_audit.NNNNNN.raw/.lz
+#define AUDIT_MAGIC 0x54445541U // "AUDT"
+#define AUDIT_ARCHIVE_MAGIC 0x5A445541U // "AUDZ", a compressed closed segment
+#define AUDIT_SEGMENT_BYTES (1 << 20) // the active segment is rotated once it reaches this size
+#define AUDIT_BLOCK_SIZE 65536 // compression block; match offsets are 16 bits
+#define AUDIT_HASH_BITS 12
+#define AUDIT_MIN_MATCH 4
+#define BATCH_MAGIC 0x32585442U // "BTX2", first four bytes of a binary batch file
+#define BATCH_READ_BUFFER (1 << 20)
+#define BATCH_SYNC_INTERVAL 65536 // records per fsync while ingesting a batch
+#define LOCK_STRIPES 4096 // power of two; accounts hash onto these mutexes
+#define STRESS_ACCOUNTS 100000
+#define STRESS_TRANSFERS 2000000
+#define INTEREST_BENCH_ACCOUNTS 10000000
+#define BENCH_MAX_ACCOUNTS 10000000
+#define BENCH_OPERATIONS 1000000 // lookups, deposits and transfers per account set
+#define MAX_INTEREST_RATE 10000 // 100.00% a year, in hundredths of a percent
+#define REPORT_DEFAULT_TOP 10
+#define REPORT_MAX_TOP 100
+#define REPORT_MAX_THREADS 64
+#define REPORT_BUCKETS 8 // balance histogram: <= $0, then powers of ten up to $1M+
+#define SERVICE_BUFFER_SIZE 16384 // per connection, each way
+#define SERVICE_MAX_EVENTS 256
+#define SERVICE_BACKLOG 128
+#define SERVICE_MAX_PAYLOAD ((int)sizeof(AccountProfile)) // create: four NUL-terminated fields
+#define VELOCITY_WINDOWS 3 // outflows over the last minute, hour and day
+#define VELOCITY_BUCKETS 12 // per window; a window slides one bucket at a time
 #define ADMIN_USERNAME "admin"
 #define ADMIN_PASSWORD "admin123"
+#define TABLE_BUFFER_SIZE 65536 // formatted rows handed to each write()
+#define PAGE_ROWS 20 // rows per page in list views
+#define DATE_CACHE_SIZE 64 // minutes of formatted dates kept by tableDate, a power of two
+#define INDEX_INITIAL_CAPACITY 256
+#define INDEX_EMPTY_SLOT 0
+#define PHONE_EMPTY_SLOT -1
+#define COMPACTION_RATIO 4 // compact at a checkpoint once 1/4 of the slots are deleted
+#define ACCOUNT_NUMBERS_FILENAME "bank_ids.dat"
+#define ACCOUNT_NUMBER_BLOCK 1024 // numbers reserved per write of the counter file
+#define FIRST_ACCOUNT_NUMBER 1000
+#define MONEY_TEXT_SIZE 24 // "-92233720368547758.08" and the terminator
 
+// Amounts in whole cents, so sums are exact and never drift
+typedef long long Money;
+_Static_assert(sizeof(Money) == sizeof(double), "legacy balances are converted in place");
+
+// A whole account as one record: the layout of legacy files, and the staging
+// copy filled in while creating an account
 typedef struct {
     int accountNumber;
     char name[100];
     char address[100];
     char phone[15];
-    double balance;
+    Money balance;
     char accountType[20]; // "savings" or "current"
     time_t lastTransaction;
 } Account;
 
-Account accounts[MAX_ACCOUNTS];
-int accountCount = 0;
+typedef enum {
+    ACCOUNT_OTHER = 0, // any other accountType text
+    ACCOUNT_SAVINGS,
+    ACCOUNT_CURRENT,
+    ACCOUNT_KINDS
+} AccountKind;
+
+// Hot fields of one chunk of accounts as parallel arrays. Balance scans only
+// touch these, never the profile strings.
+typedef struct {
+    Money balance[ACCOUNT_CHUNK_SIZE];
+    time_t lastTransaction[ACCOUNT_CHUNK_SIZE];
+    int accountNumber[ACCOUNT_CHUNK_SIZE];
+    unsigned char kind[ACCOUNT_CHUNK_SIZE]; // AccountKind parsed from accountType
+} AccountColumns;
+
+// Cold fields, read only when a single account is shown or edited
+typedef struct {
+    char name[100];
+    char address[100];
+    char phone[15];
+    char accountType[20]; // "savings" or "current"
+} AccountProfile;
+
+// One chunk in the snapshot: its columns, then its profiles (exactly 1 MiB)
+#define ACCOUNT_CHUNK_BYTES (sizeof(AccountColumns) + ACCOUNT_CHUNK_SIZE * sizeof(AccountProfile))
+
+// Snapshot file: SnapshotHeader, the hash index slots, then the accounts as
+// full-size chunk images so every chunk can be mapped in place. The header is
+// 64 bytes so the arrays stay aligned.
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int recordSize; // ACCOUNT_CHUNK_BYTES
+    int accountCount;
+    int indexCapacity;
+    int freeHead; // first deleted slot + 1, 0 when none
+    unsigned long long indexOffset;
+    unsigned long long accountsOffset;
+    int tombstoneCount;
+    int lastAccrualMonth; // yyyymm of the last interest run, 0 if never
+    int accrualMonth;     // yyyymm of an interest run still in progress, 0 if none
+    int accrualNext;      // first account position that run has not reached
+    long long accrualRate;
+} SnapshotHeader;
+_Static_assert(sizeof(SnapshotHeader) == 64, "snapshot arrays start 64-byte aligned");
+
+typedef enum {
+    TX_DEPOSIT = 1,
+    TX_WITHDRAW,
+    TX_TRANSFER,
+    TX_INTEREST,
+    TX_OPEN // followed in the journal by the new account's AccountProfile
+} TransactionType;
+
+typedef enum {
+    TX_OK = 0,
+    TX_INVALID_AMOUNT,
+    TX_INSUFFICIENT_FUNDS,
+    TX_SAME_ACCOUNT,
+    TX_BALANCE_OVERFLOW,
+    TX_VELOCITY_LIMIT
+} TransactionStatus;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int reserved;
+    unsigned long long baseSequence; // sequence number of the first record in the file
+} JournalHeader;
+
+// Redo record: carries the resulting balances, so replaying it twice is harmless
+typedef struct {
+    unsigned long long sequence;
+    int type;
+    int accountNumber;
+    int counterparty; // transfer recipient, 0 otherwise
+    unsigned int checksum;
+    Money amount;
+    Money balanceAfter;
+    Money counterpartyBalanceAfter;
+    time_t timestamp;
+} JournalRecord;
+
+typedef enum {
+    LEDGER_DEPOSIT = 1,
+    LEDGER_WITHDRAW,
+    LEDGER_TRANSFER_OUT,
+    LEDGER_TRANSFER_IN,
+    LEDGER_INTEREST
+} LedgerKind;
+
+// Ledger file: LedgerFileHeader, then segments. Each segment holds a sorted
+// per-account index followed by one column per field, so a statement reads
+// a single contiguous run from each column.
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+} LedgerFileHeader;
+
+typedef struct {
+    unsigned int magic;
+    int rowCount;
+    int accountCount;
+    int reserved;
+    unsigned long long lastSequence; // newest journal record folded into this segment
+} LedgerSegmentHeader;
+
+typedef struct {
+    int accountNumber;
+    int firstRow;
+    int rowCount;
+} LedgerIndexEntry;
+
+typedef struct {
+    off_t offset; // of the LedgerSegmentHeader
+    int rowCount;
+    int accountCount;
+} LedgerSegment;
+
+// In-memory tail row, not yet written to a segment
+typedef struct {
+    unsigned long long sequence;
+    int accountNumber;
+    int counterparty;
+    Money deltaCents;
+    time_t timestamp;
+    unsigned char kind;
+} LedgerRow;
+
+typedef enum {
+    AUDIT_OPENED,
+    AUDIT_MODIFIED,
+    AUDIT_CLOSED
+} AuditAction;
+
+// Before/after images of an account's profile. Text fields are zero padded,
+// so unused bytes compress away and no stale memory reaches the file.
+typedef struct {
+    time_t timestamp;
+    int accountNumber;
+    int action; // AuditAction
+    AccountProfile before; // all zero for AUDIT_OPENED
+    AccountProfile after;  // all zero for AUDIT_CLOSED
+    unsigned int checksum; // FNV-1a of everything before it
+} AuditRecord;
+
+// bank_audit.dat and .raw segments: this header, then AuditRecords
+typedef struct {
+    unsigned int magic;
+    int segment;
+} AuditSegmentHeader;
+
+// .lz segments: this header, then blocks of the record bytes, each an
+// AuditBlockHeader and its data (stored as is when compression does not help)
+typedef struct {
+    unsigned int magic;
+    int segment;
+    long long rawSize;
+} AuditArchiveHeader;
+
+typedef struct {
+    unsigned int rawSize;
+    unsigned int packedSize; // equal to rawSize for a stored block
+    unsigned int checksum;   // of the raw bytes
+} AuditBlockHeader;
+
+// Binary batch file: BATCH_MAGIC followed by these fixed-size records
+typedef struct {
+    int type; // TransactionType
+    int accountNumber;
+    int targetNumber; // transfers only
+    int reserved;
+    Money amount;
+} BatchRecord;
+
+typedef struct {
+    long long read;
+    long long applied;
+    long long malformed;
+    long long unknownAccount;
+    long long invalidAmount;
+    long long insufficientFunds;
+    long long sameAccount;
+    long long balanceOverflow;
+} BatchStats;
+
+// One account's withdrawals and outgoing transfers over each window. A window
+// is a ring of buckets plus running totals, so recording and checking an
+// outflow is O(1): sliding forward subtracts the buckets that drop out.
+typedef struct {
+    long long headBucket[VELOCITY_WINDOWS]; // time / bucket width of the newest bucket
+    int totalCount[VELOCITY_WINDOWS];
+    Money totalSum[VELOCITY_WINDOWS];
+    int count[VELOCITY_WINDOWS][VELOCITY_BUCKETS];
+    Money sum[VELOCITY_WINDOWS][VELOCITY_BUCKETS];
+} VelocityWindows;
+
+typedef enum {
+    SERVICE_CREATE = 1,
+    SERVICE_DEPOSIT,
+    SERVICE_WITHDRAW,
+    SERVICE_TRANSFER,
+    SERVICE_BALANCE
+} ServiceOperation;
+
+// Response codes beyond the TransactionStatus values
+typedef enum {
+    SERVICE_UNKNOWN_ACCOUNT = 16,
+    SERVICE_BAD_REQUEST,
+    SERVICE_FAILED
+} ServiceStatus;
+
+// --serve protocol: fixed-size frames in host byte order, since both ends are
+// on the same machine. A create request is followed by `length` bytes holding
+// the name, address, phone and account type, each NUL-terminated; no other
+// request carries a payload. Responses come back in request order.
+typedef struct {
+    unsigned int requestId;   // echoed in the response, so clients can pipeline
+    unsigned short operation; // ServiceOperation
+    unsigned short length;    // payload bytes that follow
+    int accountNumber;
+    int targetNumber;         // transfers only
+    Money amount;             // the initial deposit for a create
+} ServiceRequest;
+
+typedef struct {
+    unsigned int requestId;
+    int status;        // TransactionStatus or ServiceStatus
+    int accountNumber; // the new account's number after a create
+    int reserved;
+    Money balance;     // the account's balance after the request
+} ServiceResponse;
+
+typedef struct ServiceConnection {
+    int fd;
+    unsigned int events; // what epoll is currently watching for
+    bool closing;        // close once the output is sent
+    int inLength;
+    int outLength;
+    struct ServiceConnection *previous;
+    struct ServiceConnection *next;
+    unsigned char in[SERVICE_BUFFER_SIZE];
+    unsigned char out[SERVICE_BUFFER_SIZE];
+} ServiceConnection;
+
+// One mutex per cache line so neighbouring stripes don't false-share
+typedef struct {
+    pthread_mutex_t mutex;
+    char padding[64 - sizeof(pthread_mutex_t) % 64];
+} LockStripe;
+
+typedef struct {
+    unsigned int seed;
+    long long transfers;
+} StressWorker;
+
+// Report candidate; heaps of these keep the top N by key
+typedef struct {
+    long long key;
+    int index;
+} TopEntry;
+
+// One thread's share of a report: a run of chunks in, partial aggregates out
+typedef struct {
+    int firstChunk;
+    int endChunk;
+    const int *activity; // ledger rows per account position
+    int top;
+    long long accounts[ACCOUNT_KINDS];
+    Money balances[ACCOUNT_KINDS];
+    bool overflowed;
+    long long histogram[REPORT_BUCKETS];
+    TopEntry richest[REPORT_MAX_TOP];
+    int richestCount;
+    TopEntry busiest[REPORT_MAX_TOP];
+    int busiestCount;
+} ReportPartial;
+
+typedef struct {
+    long long savingsAccounts;
+    long long credited;
+    long long overflowed; // interest would not fit in the balance
+    Money totalInterest;
+} AccrualStats;
+
+// Persistent account number counter. The file only holds the end of the
+// reserved block, so creators take numbers under a short lock and touch the
+// disk once per ACCOUNT_NUMBER_BLOCK accounts; numbers reserved but unused
+// before an exit are skipped, never reused.
+typedef struct {
+    pthread_mutex_t lock;
+    int next;
+    int reservedEnd;
+} AccountNumberSequence;
+
+// List views format their rows into this buffer and hand it to write() in one
+// go instead of calling printf per row
+typedef struct {
+    char data[TABLE_BUFFER_SIZE];
+    size_t length;
+} TableBuffer;
+
+// Positions changed since the last checkpoint; flags dedupe, the list keeps
+// the save proportional to the number of changes
+typedef struct {
+    unsigned char *flags;
+    int flagCapacity;
+    int *positions;
+    int count;
+    int capacity;
+} DirtySet;
+
+// Open-addressing (linear probing) index: accountNumber -> account position
+typedef struct {
+    int accountNumber; // INDEX_EMPTY_SLOT marks a free slot
+    int accountIndex;
+} IndexSlot;
+
+// Exact-phone index: open addressing over account positions. Several accounts
+// may share a phone number, so lookups walk the whole probe chain.
+typedef struct {
+    unsigned int hash;
+    int accountIndex; // PHONE_EMPTY_SLOT marks a free slot
+} PhoneSlot;
+
+// Accounts live in fixed-size chunks, each split into hot columns and a cold
+// profile array; growing only reallocates the two chunk directories, so
+// existing records never move
+AccountColumns **columnChunks = NULL;
+AccountProfile **profileChunks = NULL;
+int chunkCount = 0;
+int chunkDirectoryCapacity = 0;
+int accountCount = 0; // slots in use, deleted ones included
+
+// Deleted accounts stay in place as tombstones chained into a free list
+// through their accountNumber (see releaseAccountSlot), so deletes never
+// move records and positions held by the index stay valid
+int freeAccountHead = -1;
+int tombstoneCount = 0;
+int lastAccrualMonth = 0;
+
+// Progress of an interest run, checkpointed with the accounts so a run cut
+// short is resumed instead of credited again. Accounts keep their positions
+// while it is set (no compaction).
+int accrualMonth = 0;
+int accrualNext = 0;
+long long accrualRate = 0;
+
+// Read-only view of bank_data.dat; chunks and the index may point into it
+// (MAP_PRIVATE, so in-memory changes never reach the file directly)
+unsigned char *snapshotMap = NULL;
+size_t snapshotMapSize = 0;
+
+// Shape of bank_data.dat as last written; saves patch it in place while it matches
+bool snapshotRewriteNeeded = true;
+int snapshotAccountCount = 0;
+int snapshotIndexCapacity = 0;
+DirtySet dirtyAccounts = { NULL, 0, NULL, 0, 0 }; // column changes
+DirtySet dirtyProfiles = { NULL, 0, NULL, 0, 0 };
+DirtySet dirtySlots = { NULL, 0, NULL, 0, 0 };
+
+IndexSlot *accountHashIndex = NULL;
+int indexCapacity = 0; // always a power of two
+int indexUsed = 0;
+
+// Secondary indexes for lookups by name prefix and phone. They are built on the
+// first such search and kept up to date from then on; anything that moves
+// accounts around (compaction, reloads) drops them until they are needed again.
+bool secondaryIndexesBuilt = false;
+int *nameIndex = NULL; // live positions sorted by name, ignoring case
+int nameIndexCount = 0;
+int nameIndexCapacity = 0;
+PhoneSlot *phoneIndex = NULL;
+int phoneIndexCapacity = 0; // always a power of two
+int phoneIndexUsed = 0;
+
+int journalFd = -1;
+unsigned long long nextJournalSequence = 1;
+// Appends fill one buffer while the thread that filled the other writes it out.
+// Slots are reserved under journalLock and copied into after it is released;
+// journalFilled counts the records that have landed in each buffer.
+JournalRecord journalBuffers[2][JOURNAL_BUFFER_RECORDS];
+int journalFilled[2] = { 0, 0 };
+int journalActive = 0;
+int journalBuffered = 0; // slots reserved in the active buffer
+int journalUnsynced = 0; // written to the file but not yet fsync'd
+int journalSinceCheckpoint = 0;
+int journalSyncInterval = JOURNAL_SYNC_INTERVAL;
+
+// Balance updates hold the stripe locks of the accounts involved and take their
+// journal sequence number under journalLock while those are still held, so
+// per-account journal order always matches balance order. journalWriteLock
+// lets one buffer at a time go to the file and the ledger, in sequence order.
+LockStripe accountLocks[LOCK_STRIPES];
+pthread_mutex_t journalLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t journalWriteLock = PTHREAD_MUTEX_INITIALIZER;
+
+AccountNumberSequence accountNumbers = { PTHREAD_MUTEX_INITIALIZER, FIRST_ACCOUNT_NUMBER, 0 };
+TableBuffer tableOut; // shared by all list views
+
+int ledgerFd = -1;
+off_t ledgerFileSize = 0;
+unsigned long long ledgerLastSequence = 0;
+LedgerSegment *ledgerSegments = NULL;
+int ledgerSegmentCount = 0;
+int ledgerSegmentCapacity = 0;
+LedgerRow ledgerTail[LEDGER_SEGMENT_ROWS];
+int ledgerTailCount = 0;
+
+// Appends go to the active segment from the menu thread only; closed segments
+// are compressed by a background thread, so rotation never waits on the codec
+int auditFd = -1;
+int auditSegment = 0;
+off_t auditSize = 0;
+pthread_t auditCompressor;
+bool auditCompressorRunning = false;
+
+// Outflow limits per window: the last minute, hour and day
+const int velocityWindowSeconds[VELOCITY_WINDOWS] = { 60, 3600, 86400 };
+const int velocityMaxCount[VELOCITY_WINDOWS] = { 5, 30, 100 };
+const Money velocityMaxSum[VELOCITY_WINDOWS] = { 500000, 2000000, 5000000 }; // $5K, $20K, $50K
+
+// Side table beside the account chunks: a block of pointers per chunk, and
+// windows only for accounts that have had an outflow. Only the menus and
+// --serve enforce limits; batch files, interest runs and benchmarks do not.
+VelocityWindows ***velocityChunks = NULL;
+int velocityChunkCount = 0;
+bool velocityLimitsEnabled = false;
+
+volatile sig_atomic_t serviceStopping = 0;
+ServiceConnection *serviceConnections = NULL;
+
+// Function prototypes
+int *accountNumberAt(int index);
+Money *balanceAt(int index);
+time_t *lastTransactionAt(int index);
+AccountProfile *profileAt(int index);
+void storeAccount(int index, const Account *account);
+void refreshKindColumn(int index);
+void moveAccount(int to, int from);
+bool reserveAccountSlots(int count);
+int appendAccount();
+bool isTombstone(int index);
+int allocateAccountSlot();
+void releaseAccountSlot(int index);
+void compactAccounts();
+void loadAccountNumbers();
+int allocateAccountNumber();
+void freeAccountStore();
+bool isInSnapshotMapping(const void *pointer);
+bool mapSnapshot();
+void loadLegacySnapshot();
+void importAccounts(const Account *records, int count);
+void loadData();
+void saveData();
+void fillSnapshotHeader(SnapshotHeader *header);
+bool writeSnapshot();
+bool patchSnapshot();
+bool patchAccountRuns(int fd, const SnapshotHeader *header, DirtySet *set, bool profiles);
+bool writeAccountRun(int fd, const SnapshotHeader *header, int first, int end, bool columns, bool profiles);
+bool writeAt(int fd, const void *data, size_t size, off_t offset);
+bool reserveDirty(DirtySet *set, int count);
+void markDirty(DirtySet *set, int position);
+void markSlotDirty(int slot);
+void clearDirty(DirtySet *set);
+void freeDirty(DirtySet *set);
+int compareInts(const void *a, const void *b);
+void openJournal();
+void writeJournalHeader();
+void replayJournal();
+int replayOpen(const JournalRecord *record, const AccountProfile *profile);
+void resetJournal();
+unsigned int journalChecksum(const JournalRecord *record, const AccountProfile *profile);
+void journalAppend(int type, int accountIndex, int counterpartyIndex, Money amount);
+void journalAppendOpen(int accountIndex);
+void journalWriteBuffer(int buffer, int count);
+void journalFlush(bool sync);
+void journalSync();
+void journalCommit();
+void closeJournal();
+void openLedger();
+void ledgerAddRow(unsigned long long sequence, int kind, int accountNumber, int counterparty,
+                  long long deltaCents, time_t timestamp);
+void ledgerAddTransaction(const JournalRecord *record);
+bool ledgerFlush();
+int compareLedgerRows(const void *a, const void *b);
+int ledgerFindAccount(const LedgerSegment *segment, int accountNumber, LedgerIndexEntry *entry);
+void printLedgerRow(time_t timestamp, int kind, long long deltaCents, int counterparty);
+void closeLedger();
+void openAudit();
+void startAuditSegment(int segment);
+void closeAudit();
+void auditAppend(int action, int accountNumber, const AccountProfile *before, const AccountProfile *after);
+void copyProfileText(AccountProfile *target, const AccountProfile *source);
+void rotateAudit();
+void startAuditCompressor();
+void *compressAuditSegments(void *arg);
+bool compressAuditSegment(int segment);
+void auditSegmentPath(char *path, size_t size, int segment, const char *kind);
+int listAuditSegments(int **segments);
+int readAuditSegment(int segment, AuditRecord **records);
+int readAuditRecords(int fd, off_t offset, AuditRecord **records);
+int intactAuditRecords(const AuditRecord *records, int count);
+unsigned int auditChecksum(const void *data, size_t size);
+int auditCompress(const unsigned char *source, int size, unsigned char *target);
+int auditEmitSequence(unsigned char *target, int out, const unsigned char *literals, int literalCount,
+                      int offset, int matchLength);
+int auditEmitLength(unsigned char *target, int out, int length);
+int auditDecompress(const unsigned char *source, int size, unsigned char *target, int capacity);
+int runAuditView(int accountNumber);
+void viewAuditTrail();
+void printAuditRecord(const AuditRecord *record);
+void initAccountLocks();
+int lockStripe(int accountIndex);
+void lockAccounts(int firstIndex, int secondIndex);
+void unlockAccounts(int firstIndex, int secondIndex);
+int applyDeposit(int accountIndex, Money amount);
+int applyWithdrawal(int accountIndex, Money amount);
+int applyTransfer(int fromIndex, int toIndex, Money amount);
+int runTransferStress(int maxThreads, long long totalTransfers);
+void *stressWorker(void *arg);
+int runBatch(const char *path);
+bool parseBatchLine(char *line, BatchRecord *record);
+void applyBatchRecord(const BatchRecord *record, BatchStats *stats, FILE *rejects, long long position);
+void printBatchSummary(const BatchStats *stats, double seconds, const char *rejectsPath);
+void enableVelocityLimits();
+void seedVelocityFromLedger(time_t cutoff);
+VelocityWindows **velocitySlot(int index);
+bool reserveVelocityChunks();
+void moveVelocity(int to, int from);
+void releaseVelocity(int index);
+void freeVelocity();
+void velocityAdvance(VelocityWindows *windows, int window, long long bucket);
+bool velocityAllows(int accountIndex, time_t now, Money amount);
+void velocityRecord(int accountIndex, time_t when, Money amount);
+int runService(const char *socketPath);
+void stopService(int signalNumber);
+void serviceAccept(int listener, int epollFd);
+bool serviceRead(ServiceConnection *connection);
+void serviceProcess(ServiceConnection *connection);
+void serviceHandle(const ServiceRequest *request, const unsigned char *payload, ServiceResponse *response);
+int serviceCreate(const ServiceRequest *request, const unsigned char *payload, int *accountNumber);
+bool parseServiceProfile(const unsigned char *payload, int length, Account *account);
+bool serviceWrite(ServiceConnection *connection);
+void serviceWatch(ServiceConnection *connection, int epollFd);
+void serviceClose(ServiceConnection *connection, int epollFd);
+int runInterestAccrual(const char *rateText);
+int runInterestBenchmark(long long accounts);
+int runBenchmarks(int count, char **sizes);
+bool benchAccountSet(int accounts);
+void benchReport(const char *name, int accounts, long long operations,
+                 const struct timespec *start, const struct timespec *end);
+void clearScratchDirectory();
+bool parseInterestRate(const char *text, long long *rate);
+void accrueInterest(long long rate, int from, AccrualStats *stats, bool checkpoints);
+void computeMonthlyInterest(const Money *balances, Money *interest, int count, long long rate);
+void printAccrualSummary(const AccrualStats *stats, long long rate, double seconds);
+int runReport(int top);
+int *countLedgerActivity();
+void *reportWorker(void *arg);
+void heapOffer(TopEntry *heap, int *count, int capacity, long long key, int index);
+int compareTopEntries(const void *a, const void *b);
+void printTopAccounts(const char *title, TopEntry *entries, int count, bool money);
+int authenticateAdmin();
+void mainMenu();
+void adminMenu();
+void customerMenu(int accountIndex);
+void createAccount();
+int addAccount(const Account *account);
+int insertAccount(const Account *account);
+void removeAccount(int index);
+void displayAllAccounts();
+void searchAccount();
+void searchByNumber();
+void searchByName();
+void searchByPhone();
+void printAccountTableHeader();
+void tableAccountRow(int index);
+void deposit(int accountIndex);
+void withdraw(int accountIndex);
+void transfer(int accountIndex);
+void viewBalance(int accountIndex);
+void viewTransactionHistory(int accountIndex);
+void deleteAccount();
+void modifyAccount();
+int findAccountByNumber(int accountNumber);
+unsigned int hashAccountNumber(int accountNumber);
+void releaseAccountIndex();
+void allocateAccountIndex(int capacity);
+void rebuildAccountIndex();
+void indexInsert(int accountNumber, int accountIndexValue);
+void indexRemove(int accountNumber);
+void buildSecondaryIndexes();
+void dropSecondaryIndexes();
+void indexProfile(int accountIndex);
+void unindexProfile(int accountIndex);
+int compareNamePositions(const void *a, const void *b);
+int nameLowerBound(const char *name, int accountIndex);
+int namePrefixBound(const char *prefix, bool pastMatches);
+void nameIndexInsert(int accountIndex);
+void nameIndexRemove(int accountIndex);
+unsigned int hashPhone(const char *phone);
+void resizePhoneIndex(int capacity);
+void phoneIndexInsert(int accountIndex);
+void phoneIndexRemove(int accountIndex);
+void clearInputBuffer();
+bool moneyAdd(Money a, Money b, Money *result);
+bool moneySub(Money a, Money b, Money *result);
+Money moneyFromDouble(double amount);
+bool parseMoney(const char *text, Money *amount);
+bool readMoney(Money *amount);
+char *formatMoney(Money amount, char *buffer);
+void tableText(TableBuffer *out, const char *text, int width);
+void tableInt(TableBuffer *out, long long value, int width);
+void tableChar(TableBuffer *out, char value, int width);
+void tableEndRow(TableBuffer *out);
+void tableFlush(TableBuffer *out);
+bool nextPage(int shown, int total);
+void tableMoney(TableBuffer *out, Money amount, int width);
+void tableDate(TableBuffer *out, time_t when);
+void printAccountDetails(int index);
+void printWelcomeArt();
+
+int main(int argc, char *argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--batch") == 0) {
+        loadData();
+        int status = runBatch(argv[2]);
+        saveData();
+        closeJournal();
+        closeLedger();
+        freeAccountStore();
+        return status;
+    }
+    if (argc >= 2 && argc <= 4 && strcmp(argv[1], "--stress-transfers") == 0) {
+        int threads = argc >= 3 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        long long transfers = argc >= 4 ? atoll(argv[3]) : STRESS_TRANSFERS;
+        return runTransferStress(threads, transfers);
+    }
+    if (argc == 3 && strcmp(argv[1], "--accrue-interest") == 0) {
+        loadData();
+        int status = runInterestAccrual(argv[2]);
+        saveData();
+        closeJournal();
+        closeLedger();
+        freeAccountStore();
+        return status;
+    }
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "--report") == 0) {
+        loadData();
+        int status = runReport(argc == 3 ? atoi(argv[2]) : REPORT_DEFAULT_TOP);
+        closeJournal();
+        closeLedger();
+        freeAccountStore();
+        return status;
+    }
+    if (argc == 3 && strcmp(argv[1], "--serve") == 0) {
+        loadData();
+        openAudit();
+        enableVelocityLimits();
+        int status = runService(argv[2]);
+        saveData();
+        closeJournal();
+        closeLedger();
+        closeAudit();
+        freeAccountStore();
+        return status;
+    }
+    if (argc == 3 && strcmp(argv[1], "--audit") == 0) {
+        return runAuditView(atoi(argv[2]));
+    }
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "--bench-interest") == 0) {
+        return runInterestBenchmark(argc == 3 ? atoll(argv[2]) : INTEREST_BENCH_ACCOUNTS);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        return runBenchmarks(argc - 2, argv + 2);
+    }
+    if (argc != 1) {
+        printf("Usage: %s [--batch <transactions.csv|transactions.bin>]\n", argv[0]);
+        printf("       %s --accrue-interest <annual rate %%>\n", argv[0]);
+        printf("       %s --report [top accounts]\n", argv[0]);
+        printf("       %s --audit <account number>\n", argv[0]);
+        printf("       %s --serve <socket path>\n", argv[0]);
+        printf("       %s --stress-transfers [threads] [transfers]\n", argv[0]);
+        printf("       %s --bench-interest [accounts]\n", argv[0]);
+        printf("       %s --bench [accounts ...]\n", argv[0]);
+        return 1;
+    }
+    
+    loadData();
+    openAudit();
+    enableVelocityLimits();
+    printWelcomeArt();
+    
+    if (authenticateAdmin()) {
+        mainMenu();
+    } else {
+        printf("Authentication failed. Exiting...\n");
+    }
+    
+    saveData();
+    closeJournal();
+    closeLedger();
+    closeAudit();
+    freeAccountStore();
+    return 0;
+}
+
+void printWelcomeArt() {
+    printf("\n");
+    printf("  ____              _        _   _           _\n");
+    printf(" |  _ \\            | |      | | | |         | |\n");
+    printf(" | |_) | __ _ _ __ | | __   | |_| | __ _ ___| |__\n");
+    printf(" |  _ < / _` | '_ \\| |/ /   |  _  |/ _` / __| '_ \\\n");
+    printf(" | |_) | (_| | | | |   <    | | | | (_| \\__ \\ | | |\n");
+    printf(" |____/ \\__,_|_| |_|_|\\_\\   \\_| |_/\\__,_|___/_| |_|\n");
+    printf("\n");
+}
+
+int *accountNumberAt(int index) {
+    return &columnChunks[index >> ACCOUNT_CHUNK_SHIFT]->accountNumber[index & ACCOUNT_CHUNK_MASK];
+}
+
+Money *balanceAt(int index) {
+    return &columnChunks[index >> ACCOUNT_CHUNK_SHIFT]->balance[index & ACCOUNT_CHUNK_MASK];
+}
+
+time_t *lastTransactionAt(int index) {
+    return &columnChunks[index >> ACCOUNT_CHUNK_SHIFT]->lastTransaction[index & ACCOUNT_CHUNK_MASK];
+}
+
+AccountProfile *profileAt(int index) {
+    return &profileChunks[index >> ACCOUNT_CHUNK_SHIFT][index & ACCOUNT_CHUNK_MASK];
+}
+
+// Scatters a whole record into the columns and the profile store
+void storeAccount(int index, const Account *account) {
+    *accountNumberAt(index) = account->accountNumber;
+    *balanceAt(index) = account->balance;
+    *lastTransactionAt(index) = account->lastTransaction;
+    
+    AccountProfile *profile = profileAt(index);
+    memcpy(profile->name, account->name, sizeof(profile->name));
+    memcpy(profile->address, account->address, sizeof(profile->address));
+    memcpy(profile->phone, account->phone, sizeof(profile->phone));
+    memcpy(profile->accountType, account->accountType, sizeof(profile->accountType));
+    refreshKindColumn(index);
+}
+
+// Call after changing a profile's accountType
+void refreshKindColumn(int index) {
+    const char *type = profileAt(index)->accountType;
+    size_t size = sizeof(profileAt(index)->accountType);
+    AccountKind kind = ACCOUNT_OTHER;
+    if (strncmp(type, "savings", size) == 0) {
+        kind = ACCOUNT_SAVINGS;
+    } else if (strncmp(type, "current", size) == 0) {
+        kind = ACCOUNT_CURRENT;
+    }
+    columnChunks[index >> ACCOUNT_CHUNK_SHIFT]->kind[index & ACCOUNT_CHUNK_MASK] = kind;
+}
+
+void moveAccount(int to, int from) {
+    AccountColumns *target = columnChunks[to >> ACCOUNT_CHUNK_SHIFT];
+    const AccountColumns *source = columnChunks[from >> ACCOUNT_CHUNK_SHIFT];
+    int targetSlot = to & ACCOUNT_CHUNK_MASK;
+    int sourceSlot = from & ACCOUNT_CHUNK_MASK;
+    target->balance[targetSlot] = source->balance[sourceSlot];
+    target->lastTransaction[targetSlot] = source->lastTransaction[sourceSlot];
+    target->accountNumber[targetSlot] = source->accountNumber[sourceSlot];
+    target->kind[targetSlot] = source->kind[sourceSlot];
+    *profileAt(to) = *profileAt(from);
+    moveVelocity(to, from);
+}
+// Makes sure chunks exist for the first `count` slots; only the directories are reallocated
+bool reserveAccountSlots(int count) {
+    while (chunkCount * ACCOUNT_CHUNK_SIZE < count) {
+        if (chunkCount == chunkDirectoryCapacity) {
+            int newCapacity = chunkDirectoryCapacity > 0 ? chunkDirectoryCapacity * 2 : 4;
+            AccountColumns **newColumns = realloc(columnChunks, newCapacity * sizeof(AccountColumns *));
+            if (newColumns == NULL) {
+                return false;
+            }
+            columnChunks = newColumns;
+            AccountProfile **newProfiles = realloc(profileChunks, newCapacity * sizeof(AccountProfile *));
+            if (newProfiles == NULL) {
+                return false;
+            }
+            profileChunks = newProfiles;
+            chunkDirectoryCapacity = newCapacity;
+        }
+        
+        // Zeroed, so the unused tail of the last chunk is written out deterministically
+        AccountColumns *columns = calloc(1, sizeof(AccountColumns));
+        AccountProfile *profiles = calloc(ACCOUNT_CHUNK_SIZE, sizeof(AccountProfile));
+        if (columns == NULL || profiles == NULL) {
+            free(columns);
+            free(profiles);
+            return false;
+        }
+        columnChunks[chunkCount] = columns;
+        profileChunks[chunkCount] = profiles;
+        chunkCount++;
+    }
+    if (velocityLimitsEnabled && !reserveVelocityChunks()) {
+        return false;
+    }
+    return reserveDirty(&dirtyAccounts, chunkCount * ACCOUNT_CHUNK_SIZE);
+}
+// Returns the new slot, or -1 when out of memory
+int appendAccount() {
+    if (!reserveAccountSlots(accountCount + 1)) {
+        return -1;
+    }
+    return accountCount++;
+}
+// Tombstones hold -(next free slot + 1), so a real account number is always positive
+bool isTombstone(int index) {
+    return *accountNumberAt(index) <= 0;
+}
+// Reuses a deleted slot when there is one, otherwise appends; -1 when out of memory
+int allocateAccountSlot() {
+    if (freeAccountHead != -1) {
+        int index = freeAccountHead;
+        freeAccountHead = -*accountNumberAt(index) - 1;
+        tombstoneCount--;
+        markDirty(&dirtyAccounts, index);
+        markDirty(&dirtyProfiles, index);
+        return index;
+    }
+    return appendAccount();
+}
+
+// O(1) delete: wipe the record and push it on the free list
+void releaseAccountSlot(int index) {
+    Account empty;
+    memset(&empty, 0, sizeof(empty));
+    empty.accountNumber = -(freeAccountHead + 1);
+    storeAccount(index, &empty);
+    releaseVelocity(index);
+    freeAccountHead = index;
+    tombstoneCount++;
+    markDirty(&dirtyAccounts, index);
+    markDirty(&dirtyProfiles, index);
+}
+// Squeezes out tombstones. Positions change, so the index is rebuilt and the
+// next save rewrites the snapshot; only called at a checkpoint.
+void compactAccounts() {
+    int live = 0;
+    for (int i = 0; i < accountCount; i++) {
+        if (isTombstone(i)) {
+            continue;
+        }
+        if (live != i) {
+            moveAccount(live, i);
+        }
+        live++;
+    }
+    accountCount = live;
+    freeAccountHead = -1;
+    tombstoneCount = 0;
+    snapshotRewriteNeeded = true;
+    rebuildAccountIndex();
+}
+
+// Reads the counter; without one (first run, or data from before the counter
+// existed) the live accounts are scanned once to start past the highest number
+void loadAccountNumbers() {
+    int reservedEnd = 0;
+    int fd = open(ACCOUNT_NUMBERS_FILENAME, O_RDONLY);
+    if (fd != -1) {
+        if (read(fd, &reservedEnd, sizeof(reservedEnd)) != sizeof(reservedEnd)) {
+            reservedEnd = 0;
+        }
+        close(fd);
+    }
+    
+    if (reservedEnd > 0) {
+        accountNumbers.next = reservedEnd;
+    } else {
+        accountNumbers.next = FIRST_ACCOUNT_NUMBER;
+        for (int i = 0; i < accountCount; i++) {
+            if (!isTombstone(i) && *accountNumberAt(i) >= accountNumbers.next) {
+                accountNumbers.next = *accountNumberAt(i) + 1;
+            }
+        }
+    }
+    accountNumbers.reservedEnd = reservedEnd;
+}
+
+// Next unused account number, or -1 if the counter file cannot be updated
+int allocateAccountNumber() {
+    pthread_mutex_lock(&accountNumbers.lock);
+    if (accountNumbers.next >= accountNumbers.reservedEnd) {
+        int reservedEnd = accountNumbers.next + ACCOUNT_NUMBER_BLOCK;
+        bool ok = false;
+        int fd = open(ACCOUNT_NUMBERS_FILENAME, O_WRONLY | O_CREAT, 0644);
+        if (fd != -1) {
+            ok = pwrite(fd, &reservedEnd, sizeof(reservedEnd), 0) == sizeof(reservedEnd);
+            ok = fsync(fd) == 0 && ok;
+            close(fd);
+        }
+        if (!ok) {
+            pthread_mutex_unlock(&accountNumbers.lock);
+            return -1;
+        }
+        accountNumbers.reservedEnd = reservedEnd;
+    }
+    int accountNumber = accountNumbers.next++;
+    pthread_mutex_unlock(&accountNumbers.lock);
+    return accountNumber;
+}
+
+void freeAccountStore() {
+    for (int i = 0; i < chunkCount; i++) {
+        if (!isInSnapshotMapping(columnChunks[i])) {
+            free(columnChunks[i]);
+            free(profileChunks[i]);
+        }
+    }
+    free(columnChunks);
+    free(profileChunks);
+    columnChunks = NULL;
+    profileChunks = NULL;
+    chunkCount = 0;
+    chunkDirectoryCapacity = 0;
+    accountCount = 0;
+    freeAccountHead = -1;
+    tombstoneCount = 0;
+    
+    releaseAccountIndex();
+    freeVelocity();
+    freeDirty(&dirtyAccounts);
+    freeDirty(&dirtyProfiles);
+    freeDirty(&dirtySlots);
+    if (snapshotMap != NULL) {
+        munmap(snapshotMap, snapshotMapSize);
+        snapshotMap = NULL;
+        snapshotMapSize = 0;
+    }
+}
+
+bool isInSnapshotMapping(const void *pointer) {
+    const unsigned char *bytes = pointer;
+    return snapshotMap != NULL && bytes >= snapshotMap && bytes < snapshotMap + snapshotMapSize;
+}
+
+// Maps a versioned snapshot and serves accounts and the index straight from
+// it, so pages are only faulted in when a lookup touches them. Snapshots from
+// before the column layout are copied into fresh chunks instead. Returns
+// false when there is no versioned snapshot to map.
+bool mapSnapshot() {
+    int fd = open(FILENAME, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    
+    SnapshotHeader header;
+    struct stat info;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != SNAPSHOT_MAGIC || fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    
+    int chunksNeeded = (header.accountCount + ACCOUNT_CHUNK_SIZE - 1) / ACCOUNT_CHUNK_SIZE;
+    unsigned long long accountsSize = (unsigned long long)chunksNeeded * ACCOUNT_CHUNK_BYTES;
+    unsigned long long indexSize = (unsigned long long)header.indexCapacity * sizeof(IndexSlot);
+    unsigned long long fileSize = info.st_size;
+    // The index and the accounts must lie inside the file, in that order and
+    // without overlapping, and a lookup needs at least one empty index slot
+    if (header.version != SNAPSHOT_VERSION || header.recordSize != ACCOUNT_CHUNK_BYTES ||
+        header.accountCount < 0 || header.indexCapacity < INDEX_INITIAL_CAPACITY ||
+        header.tombstoneCount < 0 || header.tombstoneCount > header.accountCount ||
+        header.freeHead < 0 || header.freeHead > header.accountCount ||
+        header.accrualNext < 0 || header.accrualNext > header.accountCount ||
+        (header.indexCapacity & (header.indexCapacity - 1)) != 0 ||
+        header.accountCount - header.tombstoneCount >= header.indexCapacity ||
+        header.indexOffset < sizeof(header) || header.indexOffset % _Alignof(IndexSlot) != 0 ||
+        header.indexOffset > header.accountsOffset ||
+        indexSize > header.accountsOffset - header.indexOffset ||
+        header.accountsOffset % _Alignof(AccountColumns) != 0 || header.accountsOffset > fileSize ||
+        accountsSize > fileSize - header.accountsOffset) {
+        printf("%s has an unsupported version or is damaged!\n", FILENAME);
+        exit(1);
+    }
+    
+    void *map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Could not map %s!\n", FILENAME);
+        exit(1);
+    }
+    snapshotMap = map;
+    snapshotMapSize = info.st_size;
+    
+    accountHashIndex = (IndexSlot *)(snapshotMap + header.indexOffset);
+    indexCapacity = header.indexCapacity;
+    indexUsed = header.accountCount - header.tombstoneCount;
+    
+    // Every chunk is stored full size, so even the last one can grow in place
+    // (the mapping is private)
+    chunkDirectoryCapacity = chunksNeeded > 4 ? chunksNeeded : 4;
+    columnChunks = malloc(chunkDirectoryCapacity * sizeof(AccountColumns *));
+    profileChunks = malloc(chunkDirectoryCapacity * sizeof(AccountProfile *));
+    if (columnChunks == NULL || profileChunks == NULL) {
+        printf("Out of memory while loading accounts!\n");
+        exit(1);
+    }
+    for (int i = 0; i < chunksNeeded; i++) {
+        unsigned char *chunk = snapshotMap + header.accountsOffset + (size_t)i * ACCOUNT_CHUNK_BYTES;
+        columnChunks[i] = (AccountColumns *)chunk;
+        profileChunks[i] = (AccountProfile *)(chunk + sizeof(AccountColumns));
+    }
+    chunkCount = chunksNeeded;
+    accountCount = header.accountCount;
+    if (!reserveDirty(&dirtyAccounts, chunkCount * ACCOUNT_CHUNK_SIZE)) {
+        printf("Out of memory while loading accounts!\n");
+        exit(1);
+    }
+    freeAccountHead = header.freeHead - 1;
+    tombstoneCount = header.tombstoneCount;
+    lastAccrualMonth = header.lastAccrualMonth;
+    accrualMonth = header.accrualMonth;
+    accrualNext = header.accrualNext;
+    accrualRate = header.accrualRate;
+    
+    snapshotRewriteNeeded = false;
+    snapshotAccountCount = header.accountCount;
+    snapshotIndexCapacity = header.indexCapacity;
+    return true;
+}
+
+// Headerless files written before the snapshot format was versioned
+void loadLegacySnapshot() {
+    FILE *file = fopen(FILENAME, "rb");
+    if (file != NULL) {
+        Account *records = malloc(ACCOUNT_CHUNK_SIZE * sizeof(Account));
+        if (records == NULL) {
+            printf("Out of memory while loading accounts!\n");
+            exit(1);
+        }
+        size_t read;
+        while ((read = fread(records, sizeof(Account), ACCOUNT_CHUNK_SIZE, file)) > 0) {
+            importAccounts(records, (int)read);
+        }
+        free(records);
+        fclose(file);
+    }
+    rebuildAccountIndex();
+}
+
+// Appends whole records to the store, converting the double balances they
+// were saved with. The next save rewrites the file in the column layout.
+void importAccounts(const Account *records, int count) {
+    if (!reserveAccountSlots(accountCount + count)) {
+        printf("Out of memory while loading accounts!\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        Account account = records[i];
+        double legacy;
+        memcpy(&legacy, &account.balance, sizeof(legacy));
+        account.balance = moneyFromDouble(legacy);
+        storeAccount(accountCount++, &account);
+    }
+    snapshotRewriteNeeded = true;
+}
+void loadData() {
+    initAccountLocks();
+    if (!mapSnapshot()) {
+        loadLegacySnapshot();
+    }
+    openLedger();
+    openJournal();
+    replayJournal();
+    loadAccountNumbers();
+    if (accrualMonth != 0) {
+        printf("Warning: the interest run for %04d-%02d was interrupted, run --accrue-interest to finish it.\n",
+               accrualMonth / 100, accrualMonth % 100);
+    }
+}
+
+// Checkpoint: atomically replace the snapshot, then start an empty journal
+void saveData() {
+    journalFlush(true);
+    if (!ledgerFlush()) {
+        printf("Could not write %s, keeping the journal!\n", LEDGER_FILENAME);
+        return;
+    }
+    
+    if (tombstoneCount > 0 && tombstoneCount * COMPACTION_RATIO >= accountCount && accrualMonth == 0) {
+        compactAccounts();
+    }
+    
+    // Patch changed records in place unless the file layout no longer fits
+    bool layoutChanged = snapshotRewriteNeeded || accountCount < snapshotAccountCount ||
+                         indexCapacity != snapshotIndexCapacity;
+    if ((layoutChanged || !patchSnapshot()) && !writeSnapshot()) {
+        printf("Could not write %s, keeping the journal!\n", FILENAME);
+        return;
+    }
+    
+    snapshotRewriteNeeded = false;
+    snapshotAccountCount = accountCount;
+    snapshotIndexCapacity = indexCapacity;
+    clearDirty(&dirtyAccounts);
+    clearDirty(&dirtyProfiles);
+    clearDirty(&dirtySlots);
+    resetJournal();
+}
+
+void fillSnapshotHeader(SnapshotHeader *header) {
+    memset(header, 0, sizeof(*header));
+    header->magic = SNAPSHOT_MAGIC;
+    header->version = SNAPSHOT_VERSION;
+    header->recordSize = ACCOUNT_CHUNK_BYTES;
+    header->accountCount = accountCount;
+    header->indexCapacity = indexCapacity;
+    header->freeHead = freeAccountHead + 1;
+    header->tombstoneCount = tombstoneCount;
+    header->lastAccrualMonth = lastAccrualMonth;
+    header->accrualMonth = accrualMonth;
+    header->accrualNext = accrualNext;
+    header->accrualRate = accrualRate;
+    header->indexOffset = sizeof(SnapshotHeader);
+    header->accountsOffset = header->indexOffset + (unsigned long long)indexCapacity * sizeof(IndexSlot);
+}
+
+// Full rewrite into a temp file that atomically replaces the snapshot
+bool writeSnapshot() {
+    FILE *file = fopen(TEMP_FILENAME, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    
+    SnapshotHeader header;
+    fillSnapshotHeader(&header);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(accountHashIndex, sizeof(IndexSlot), indexCapacity, file);
+    int chunks = (accountCount + ACCOUNT_CHUNK_SIZE - 1) / ACCOUNT_CHUNK_SIZE;
+    for (int i = 0; i < chunks; i++) {
+        int count = accountCount - i * ACCOUNT_CHUNK_SIZE < ACCOUNT_CHUNK_SIZE ? accountCount - i * ACCOUNT_CHUNK_SIZE
+                                                                               : ACCOUNT_CHUNK_SIZE;
+        fwrite(columnChunks[i], sizeof(AccountColumns), 1, file);
+        fwrite(profileChunks[i], sizeof(AccountProfile), count, file);
+    }
+    // Unused profiles of the last chunk stay a hole in the file
+    off_t size = header.accountsOffset + (off_t)chunks * ACCOUNT_CHUNK_BYTES;
+    bool ok = !ferror(file) && fflush(file) == 0 && ftruncate(fileno(file), size) == 0 &&
+              fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    
+    if (!ok || rename(TEMP_FILENAME, FILENAME) != 0) {
+        remove(TEMP_FILENAME);
+        return false;
+    }
+    return true;
+}
+
+// Writes dirty and appended records plus dirty index slots in place, then the
+// header, so a crash mid-way leaves new records beyond the recorded count.
+// The journal is only reset afterwards, so balances are replayed if needed.
+bool patchSnapshot() {
+    int fd = open(FILENAME, O_WRONLY);
+    if (fd == -1) {
+        return false;
+    }
+    
+    SnapshotHeader header;
+    fillSnapshotHeader(&header);
+    bool ok = true;
+    
+    for (int i = snapshotAccountCount; i < accountCount && ok; ) {
+        int end = (i | ACCOUNT_CHUNK_MASK) + 1;
+        if (end > accountCount) {
+            end = accountCount;
+        }
+        ok = writeAccountRun(fd, &header, i, end, true, true);
+        i = end;
+    }
+    ok = ok && patchAccountRuns(fd, &header, &dirtyAccounts, false);
+    ok = ok && patchAccountRuns(fd, &header, &dirtyProfiles, true);
+    
+    for (int i = 0; i < dirtySlots.count && ok; i++) {
+        int slot = dirtySlots.positions[i];
+        ok = writeAt(fd, &accountHashIndex[slot], sizeof(IndexSlot),
+                     header.indexOffset + (off_t)slot * sizeof(IndexSlot));
+    }
+    
+    // A newly started chunk must still cover a full chunk image
+    struct stat info;
+    off_t size = header.accountsOffset +
+                 (off_t)((accountCount + ACCOUNT_CHUNK_SIZE - 1) / ACCOUNT_CHUNK_SIZE) * ACCOUNT_CHUNK_BYTES;
+    ok = ok && fstat(fd, &info) == 0 && (info.st_size >= size || ftruncate(fd, size) == 0);
+    
+    ok = ok && fdatasync(fd) == 0;
+    ok = ok && writeAt(fd, &header, sizeof(header), 0) && fdatasync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+// Writes the dirty positions of `set` that were already in the file, coalescing
+// neighbours in the same chunk; profiles picks the profile store over the columns
+bool patchAccountRuns(int fd, const SnapshotHeader *header, DirtySet *set, bool profiles) {
+    if (set->count > 1) {
+        qsort(set->positions, set->count, sizeof(int), compareInts);
+    }
+    for (int i = 0; i < set->count; ) {
+        int first = set->positions[i];
+        int end = first + 1;
+        i++;
+        while (i < set->count && set->positions[i] == end && (end & ACCOUNT_CHUNK_MASK) != 0) {
+            end++;
+            i++;
+        }
+        if (first >= snapshotAccountCount) {
+            continue; // already written with the appended range
+        }
+        if (!writeAccountRun(fd, header, first, end, !profiles, profiles)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes accounts [first, end), which must share a chunk: one slice per column
+// and/or one slice of profiles
+bool writeAccountRun(int fd, const SnapshotHeader *header, int first, int end, bool columns, bool profiles) {
+    int chunk = first >> ACCOUNT_CHUNK_SHIFT;
+    int slot = first & ACCOUNT_CHUNK_MASK;
+    int count = end - first;
+    off_t base = header->accountsOffset + (off_t)chunk * ACCOUNT_CHUNK_BYTES;
+    const AccountColumns *source = columnChunks[chunk];
+    
+    bool ok = true;
+    if (columns) {
+        ok = writeAt(fd, &source->balance[slot], count * sizeof(Money),
+                     base + offsetof(AccountColumns, balance) + slot * sizeof(Money)) &&
+             writeAt(fd, &source->lastTransaction[slot], count * sizeof(time_t),
+                     base + offsetof(AccountColumns, lastTransaction) + slot * sizeof(time_t)) &&
+             writeAt(fd, &source->accountNumber[slot], count * sizeof(int),
+                     base + offsetof(AccountColumns, accountNumber) + slot * sizeof(int)) &&
+             writeAt(fd, &source->kind[slot], count,
+                     base + offsetof(AccountColumns, kind) + slot);
+    }
+    if (profiles) {
+        ok = ok && writeAt(fd, &profileChunks[chunk][slot], count * sizeof(AccountProfile),
+                           base + sizeof(AccountColumns) + slot * sizeof(AccountProfile));
+    }
+    return ok;
+}
+
+bool writeAt(int fd, const void *data, size_t size, off_t offset) {
+    return pwrite(fd, data, size, offset) == (ssize_t)size;
+}
+// Grows the set to cover positions below `count`. Marking a covered position
+// never allocates, which keeps allocation out of journalAppend.
+bool reserveDirty(DirtySet *set, int count) {
+    if (count <= set->flagCapacity) {
+        return true;
+    }
+    int newCapacity = set->flagCapacity > 0 ? set->flagCapacity : 1024;
+    while (newCapacity < count) {
+        newCapacity *= 2;
+    }
+    
+    // A position is listed at most once, so the list never outgrows the flags
+    int *positions = realloc(set->positions, newCapacity * sizeof(int));
+    if (positions == NULL) {
+        return false;
+    }
+    set->positions = positions;
+    set->capacity = newCapacity;
+    
+    unsigned char *flags = realloc(set->flags, newCapacity);
+    if (flags == NULL) {
+        return false;
+    }
+    memset(flags + set->flagCapacity, 0, newCapacity - set->flagCapacity);
+    set->flags = flags;
+    set->flagCapacity = newCapacity;
+    return true;
+}
+
+void markDirty(DirtySet *set, int position) {
+    if (!reserveDirty(set, position + 1)) {
+        snapshotRewriteNeeded = true;
+        return;
+    }
+    if (set->flags[position]) {
+        return;
+    }
+    set->flags[position] = 1;
+    set->positions[set->count++] = position;
+}
+
+// Slot changes only matter while the on-disk index has the same capacity
+void markSlotDirty(int slot) {
+    if (!snapshotRewriteNeeded && indexCapacity == snapshotIndexCapacity) {
+        markDirty(&dirtySlots, slot);
+    }
+}
+
+void clearDirty(DirtySet *set) {
+    for (int i = 0; i < set->count; i++) {
+        set->flags[set->positions[i]] = 0;
+    }
+    set->count = 0;
+}
+
+void freeDirty(DirtySet *set) {
+    free(set->flags);
+    free(set->positions);
+    memset(set, 0, sizeof(*set));
+}
+
+int compareInts(const void *a, const void *b) {
+    int left = *(const int *)a;
+    int right = *(const int *)b;
+    return (left > right) - (left < right);
+}
+
+void openJournal() {
+    journalFd = open(JOURNAL_FILENAME, O_RDWR | O_CREAT, 0644);
+    if (journalFd == -1) {
+        printf("Warning: could not open %s, transactions will not be journaled!\n", JOURNAL_FILENAME);
+    }
+}
+
+void writeJournalHeader() {
+    JournalHeader header = { JOURNAL_MAGIC, 0, nextJournalSequence };
+    if (ftruncate(journalFd, 0) != 0 ||
+        pwrite(journalFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        fsync(journalFd) != 0) {
+        printf("Warning: could not reset %s!\n", JOURNAL_FILENAME);
+    }
+    lseek(journalFd, sizeof(header), SEEK_SET);
+}
+
+// Re-applies every intact record; a torn or corrupt tail is cut off
+void replayJournal() {
+    if (journalFd == -1) {
+        return;
+    }
+    
+    JournalHeader header;
+    if (pread(journalFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != JOURNAL_MAGIC) {
+        // Carry on after the ledger so new sequences never repeat flushed ones
+        nextJournalSequence = ledgerLastSequence + 1;
+        writeJournalHeader();
+        return;
+    }
+    nextJournalSequence = header.baseSequence;
+    
+    off_t offset = sizeof(header);
+    JournalRecord record;
+    AccountProfile profile;
+    memset(&profile, 0, sizeof(profile));
+    while (pread(journalFd, &record, sizeof(record), offset) == (ssize_t)sizeof(record) &&
+           record.sequence == nextJournalSequence) {
+        off_t next = offset + sizeof(record);
+        if (record.type == TX_OPEN) {
+            if (pread(journalFd, &profile, sizeof(profile), next) != (ssize_t)sizeof(profile) ||
+                record.checksum != journalChecksum(&record, &profile)) {
+                break;
+            }
+            next += sizeof(profile);
+        } else if (record.checksum != journalChecksum(&record, NULL)) {
+            break;
+        }
+        
+        int index = findAccountByNumber(record.accountNumber);
+        if (index == -1 && record.type == TX_OPEN) {
+            index = replayOpen(&record, &profile); // opened after the last checkpoint
+        }
+        if (index != -1) {
+            *balanceAt(index) = record.balanceAfter;
+            *lastTransactionAt(index) = record.timestamp;
+            markDirty(&dirtyAccounts, index);
+            if (record.type == TX_INTEREST && accrualMonth != 0 && index >= accrualNext) {
+                accrualNext = index + 1; // credited after the last checkpoint
+            }
+        }
+        if (record.type == TX_TRANSFER) {
+            int target = findAccountByNumber(record.counterparty);
+            if (target != -1) {
+                *balanceAt(target) = record.counterpartyBalanceAfter;
+                *lastTransactionAt(target) = record.timestamp;
+                markDirty(&dirtyAccounts, target);
+            }
+        }
+        if (record.sequence > ledgerLastSequence) {
+            ledgerAddTransaction(&record);
+        }
+        nextJournalSequence++;
+        journalSinceCheckpoint++;
+        offset = next;
+    }
+    
+    if (ftruncate(journalFd, offset) != 0) {
+        printf("Warning: could not trim %s!\n", JOURNAL_FILENAME);
+    }
+    lseek(journalFd, offset, SEEK_SET);
+}
+
+// Recreates an account from its TX_OPEN record and profile
+int replayOpen(const JournalRecord *record, const AccountProfile *profile) {
+    Account account;
+    memset(&account, 0, sizeof(account));
+    account.accountNumber = record->accountNumber;
+    memcpy(account.name, profile->name, sizeof(account.name));
+    memcpy(account.address, profile->address, sizeof(account.address));
+    memcpy(account.phone, profile->phone, sizeof(account.phone));
+    memcpy(account.accountType, profile->accountType, sizeof(account.accountType));
+    account.balance = record->balanceAfter;
+    account.lastTransaction = record->timestamp;
+    
+    int index = insertAccount(&account);
+    if (index == -1) {
+        printf("Out of memory while replaying %s!\n", JOURNAL_FILENAME);
+        exit(1);
+    }
+    return index;
+}
+
+void resetJournal() {
+    if (journalFd != -1) {
+        writeJournalHeader();
+    }
+    journalSinceCheckpoint = 0;
+}
+
+unsigned int journalChecksum(const JournalRecord *record, const AccountProfile *profile) {
+    JournalRecord copy = *record;
+    copy.checksum = 0;
+    
+    // FNV-1a over the whole record, then the profile an open record carries
+    const unsigned char *bytes = (const unsigned char *)&copy;
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(copy); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    if (profile != NULL) {
+        const unsigned char *text = (const unsigned char *)profile;
+        for (size_t i = 0; i < sizeof(*profile); i++) {
+            hash = (hash ^ text[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// Only the sequence number, the buffer slot and the dirty flags are taken under
+// journalLock; the thread that fills a buffer writes it out after letting go
+void journalAppend(int type, int accountIndex, int counterpartyIndex, Money amount) {
+    JournalRecord record;
+    memset(&record, 0, sizeof(record)); // keep padding deterministic for the checksum
+    record.type = type;
+    record.accountNumber = *accountNumberAt(accountIndex);
+    record.amount = amount;
+    record.balanceAfter = *balanceAt(accountIndex);
+    record.timestamp = *lastTransactionAt(accountIndex);
+    if (counterpartyIndex != -1) {
+        record.counterparty = *accountNumberAt(counterpartyIndex);
+        record.counterpartyBalanceAfter = *balanceAt(counterpartyIndex);
+    }
+    
+    pthread_mutex_lock(&journalLock);
+    record.sequence = nextJournalSequence++;
+    int buffer = journalActive;
+    int slot = journalBuffered++;
+    markDirty(&dirtyAccounts, accountIndex);
+    if (counterpartyIndex != -1) {
+        markDirty(&dirtyAccounts, counterpartyIndex);
+    }
+    bool full = journalBuffered == JOURNAL_BUFFER_RECORDS;
+    if (full) {
+        // The other buffer is free again once its writer lets go of the lock
+        pthread_mutex_lock(&journalWriteLock);
+        journalActive = 1 - buffer;
+        journalBuffered = 0;
+    }
+    pthread_mutex_unlock(&journalLock);
+    
+    record.checksum = journalChecksum(&record, NULL);
+    journalBuffers[buffer][slot] = record;
+    __atomic_add_fetch(&journalFilled[buffer], 1, __ATOMIC_RELEASE);
+    
+    if (full) {
+        journalWriteBuffer(buffer, JOURNAL_BUFFER_RECORDS);
+        pthread_mutex_unlock(&journalWriteLock);
+    }
+}
+
+// Writes a TX_OPEN record and the account's profile straight to the journal,
+// after whatever is still buffered so replay sees the account before its
+// transactions. Flushed and synced like any other record.
+void journalAppendOpen(int accountIndex) {
+    unsigned char bytes[sizeof(JournalRecord) + sizeof(AccountProfile)];
+    JournalRecord record;
+    AccountProfile profile;
+    memset(&record, 0, sizeof(record));
+    memset(&profile, 0, sizeof(profile));
+    record.type = TX_OPEN;
+    record.accountNumber = *accountNumberAt(accountIndex);
+    record.amount = *balanceAt(accountIndex);
+    record.balanceAfter = *balanceAt(accountIndex);
+    record.timestamp = *lastTransactionAt(accountIndex);
+    copyProfileText(&profile, profileAt(accountIndex));
+    
+    pthread_mutex_lock(&journalLock);
+    pthread_mutex_lock(&journalWriteLock);
+    int buffer = journalActive;
+    int count = journalBuffered;
+    journalActive = 1 - buffer;
+    journalBuffered = 0;
+    record.sequence = nextJournalSequence++;
+    pthread_mutex_unlock(&journalLock);
+    
+    journalWriteBuffer(buffer, count);
+    record.checksum = journalChecksum(&record, &profile);
+    memcpy(bytes, &record, sizeof(record));
+    memcpy(bytes + sizeof(record), &profile, sizeof(profile));
+    if (journalFd != -1) {
+        if (write(journalFd, bytes, sizeof(bytes)) != (ssize_t)sizeof(bytes)) {
+            printf("Warning: journal write failed!\n");
+        }
+        journalUnsynced++;
+    }
+    journalSinceCheckpoint++;
+    pthread_mutex_unlock(&journalWriteLock);
+}
+
+// Called with journalWriteLock held. Waits for appends still copying into the
+// reserved slots, then writes the records and hands them to the ledger.
+void journalWriteBuffer(int buffer, int count) {
+    while (__atomic_load_n(&journalFilled[buffer], __ATOMIC_ACQUIRE) < count) {
+        sched_yield();
+    }
+    
+    if (journalFd != -1 && count > 0) {
+        size_t bytes = count * sizeof(JournalRecord);
+        if (write(journalFd, journalBuffers[buffer], bytes) != (ssize_t)bytes) {
+            printf("Warning: journal write failed!\n");
+        }
+        journalUnsynced += count;
+    }
+    journalSinceCheckpoint += count;
+    for (int i = 0; i < count; i++) {
+        ledgerAddTransaction(&journalBuffers[buffer][i]);
+    }
+    __atomic_store_n(&journalFilled[buffer], 0, __ATOMIC_RELAXED);
+    
+    if (journalUnsynced >= journalSyncInterval) {
+        journalSync();
+    }
+}
+
+void journalFlush(bool sync) {
+    pthread_mutex_lock(&journalLock);
+    pthread_mutex_lock(&journalWriteLock);
+    int buffer = journalActive;
+    int count = journalBuffered;
+    journalActive = 1 - buffer;
+    journalBuffered = 0;
+    pthread_mutex_unlock(&journalLock);
+    
+    journalWriteBuffer(buffer, count);
+    if (sync) {
+        journalSync();
+    }
+    pthread_mutex_unlock(&journalWriteLock);
+}
+
+void journalSync() {
+    if (journalFd != -1 && journalUnsynced > 0) {
+        fdatasync(journalFd);
+        journalUnsynced = 0;
+    }
+}
+
+// Called once per interactive transaction: hand the record to the kernel right
+// away, fsync in batches, and fold the journal into the snapshot now and then
+void journalCommit() {
+    journalFlush(false);
+    if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+        saveData();
+    }
+}
+
+void closeJournal() {
+    if (journalFd != -1) {
+        close(journalFd);
+        journalFd = -1;
+    }
+}
+
+void openLedger() {
+    ledgerFd = open(LEDGER_FILENAME, O_RDWR | O_CREAT, 0644);
+    if (ledgerFd == -1) {
+        printf("Warning: could not open %s, history will not be kept!\n", LEDGER_FILENAME);
+        return;
+    }
+    
+    LedgerFileHeader header;
+    off_t fileSize = lseek(ledgerFd, 0, SEEK_END);
+    if (pread(ledgerFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != LEDGER_MAGIC || header.version != LEDGER_VERSION) {
+        LedgerFileHeader fresh = { LEDGER_MAGIC, LEDGER_VERSION };
+        if (ftruncate(ledgerFd, 0) != 0 ||
+            pwrite(ledgerFd, &fresh, sizeof(fresh), 0) != (ssize_t)sizeof(fresh)) {
+            printf("Warning: could not initialise %s!\n", LEDGER_FILENAME);
+        }
+        ledgerFileSize = sizeof(fresh);
+        return;
+    }
+    
+    // Only the segment headers are read; indexes and columns stay on disk
+    off_t offset = sizeof(header);
+    LedgerSegmentHeader segmentHeader;
+    while (pread(ledgerFd, &segmentHeader, sizeof(segmentHeader), offset) == (ssize_t)sizeof(segmentHeader) &&
+           segmentHeader.magic == LEDGER_SEGMENT_MAGIC) {
+        off_t size = sizeof(segmentHeader) +
+                     (off_t)segmentHeader.accountCount * sizeof(LedgerIndexEntry) +
+                     (off_t)segmentHeader.rowCount * (sizeof(long long) * 2 + sizeof(int) + 1);
+        if (offset + size > fileSize) {
+            break; // torn segment from an interrupted flush
+        }
+        
+        if (ledgerSegmentCount == ledgerSegmentCapacity) {
+            int newCapacity = ledgerSegmentCapacity > 0 ? ledgerSegmentCapacity * 2 : 16;
+            LedgerSegment *grown = realloc(ledgerSegments, newCapacity * sizeof(LedgerSegment));
+            if (grown == NULL) {
+                break;
+            }
+            ledgerSegments = grown;
+            ledgerSegmentCapacity = newCapacity;
+        }
+        ledgerSegments[ledgerSegmentCount].offset = offset;
+        ledgerSegments[ledgerSegmentCount].rowCount = segmentHeader.rowCount;
+        ledgerSegments[ledgerSegmentCount].accountCount = segmentHeader.accountCount;
+        ledgerSegmentCount++;
+        
+        ledgerLastSequence = segmentHeader.lastSequence;
+        offset += size;
+    }
+    
+    ledgerFileSize = offset;
+    if (offset < fileSize && ftruncate(ledgerFd, offset) != 0) {
+        printf("Warning: could not trim %s!\n", LEDGER_FILENAME);
+    }
+}
+
+void ledgerAddRow(unsigned long long sequence, int kind, int accountNumber, int counterparty,
+                  long long deltaCents, time_t timestamp) {
+    if (ledgerTailCount == LEDGER_SEGMENT_ROWS && !ledgerFlush()) {
+        // The journal keeps the row until the next checkpoint; replay restores it
+        return;
+    }
+    
+    LedgerRow *row = &ledgerTail[ledgerTailCount++];
+    row->sequence = sequence;
+    row->kind = kind;
+    row->accountNumber = accountNumber;
+    row->counterparty = counterparty;
+    row->deltaCents = deltaCents;
+    row->timestamp = timestamp;
+}
+
+void ledgerAddTransaction(const JournalRecord *record) {
+    Money cents = record->amount;
+    switch (record->type) {
+        case TX_DEPOSIT:
+            ledgerAddRow(record->sequence, LEDGER_DEPOSIT, record->accountNumber, 0,
+                         cents, record->timestamp);
+            break;
+        case TX_WITHDRAW:
+            ledgerAddRow(record->sequence, LEDGER_WITHDRAW, record->accountNumber, 0,
+                         -cents, record->timestamp);
+            break;
+        case TX_TRANSFER:
+            ledgerAddRow(record->sequence, LEDGER_TRANSFER_OUT, record->accountNumber,
+                         record->counterparty, -cents, record->timestamp);
+            ledgerAddRow(record->sequence, LEDGER_TRANSFER_IN, record->counterparty,
+                         record->accountNumber, cents, record->timestamp);
+            break;
+        case TX_INTEREST:
+            ledgerAddRow(record->sequence, LEDGER_INTEREST, record->accountNumber, 0,
+                         cents, record->timestamp);
+            break;
+    }
+}
+
+int compareLedgerRows(const void *a, const void *b) {
+    const LedgerRow *left = a;
+    const LedgerRow *right = b;
+    if (left->accountNumber != right->accountNumber) {
+        return left->accountNumber < right->accountNumber ? -1 : 1;
+    }
+    if (left->sequence != right->sequence) {
+        return left->sequence < right->sequence ? -1 : 1;
+    }
+    return left->kind - right->kind;
+}
+
+// Writes the tail as one segment: header, per-account index, then the
+// timestamp, delta, counterparty and kind columns
+bool ledgerFlush() {
+    if (ledgerTailCount == 0) {
+        return true;
+    }
+    if (ledgerFd == -1) {
+        ledgerTailCount = 0;
+        return true;
+    }
+    
+    // Never let the ledger get ahead of what the journal has made durable; its
+    // rows only come from records that were already written
+    journalSync();
+    
+    qsort(ledgerTail, ledgerTailCount, sizeof(LedgerRow), compareLedgerRows);
+    
+    int rows = ledgerTailCount;
+    int accountsInSegment = 0;
+    for (int i = 0; i < rows; i++) {
+        if (i == 0 || ledgerTail[i].accountNumber != ledgerTail[i - 1].accountNumber) {
+            accountsInSegment++;
+        }
+    }
+    
+    size_t indexBytes = accountsInSegment * sizeof(LedgerIndexEntry);
+    size_t columnBytes = rows * (sizeof(long long) * 2 + sizeof(int) + 1);
+    size_t totalBytes = sizeof(LedgerSegmentHeader) + indexBytes + columnBytes;
+    unsigned char *buffer = malloc(totalBytes);
+    if (buffer == NULL) {
+        return false;
+    }
+    
+    LedgerSegmentHeader *header = (LedgerSegmentHeader *)buffer;
+    LedgerIndexEntry *index = (LedgerIndexEntry *)(buffer + sizeof(LedgerSegmentHeader));
+    // The columns follow 12-byte index entries, so they are not always 8-byte aligned
+    unsigned char *timestamps = buffer + sizeof(LedgerSegmentHeader) + indexBytes;
+    unsigned char *deltas = timestamps + rows * sizeof(long long);
+    unsigned char *counterparties = deltas + rows * sizeof(long long);
+    unsigned char *kinds = counterparties + rows * sizeof(int);
+    
+    memset(header, 0, sizeof(*header));
+    header->magic = LEDGER_SEGMENT_MAGIC;
+    header->rowCount = rows;
+    header->accountCount = accountsInSegment;
+    
+    int entry = -1;
+    for (int i = 0; i < rows; i++) {
+        const LedgerRow *row = &ledgerTail[i];
+        if (entry == -1 || index[entry].accountNumber != row->accountNumber) {
+            entry++;
+            index[entry].accountNumber = row->accountNumber;
+            index[entry].firstRow = i;
+            index[entry].rowCount = 0;
+        }
+        index[entry].rowCount++;
+        
+        long long timestamp = row->timestamp;
+        memcpy(timestamps + i * sizeof(long long), &timestamp, sizeof(timestamp));
+        memcpy(deltas + i * sizeof(long long), &row->deltaCents, sizeof(row->deltaCents));
+        memcpy(counterparties + i * sizeof(int), &row->counterparty, sizeof(row->counterparty));
+        kinds[i] = row->kind;
+        if (row->sequence > header->lastSequence) {
+            header->lastSequence = row->sequence;
+        }
+    }
+    
+    bool ok = pwrite(ledgerFd, buffer, totalBytes, ledgerFileSize) == (ssize_t)totalBytes &&
+              fdatasync(ledgerFd) == 0;
+    unsigned long long lastSequence = header->lastSequence;
+    free(buffer);
+    if (!ok) {
+        return false;
+    }
+    
+    if (ledgerSegmentCount == ledgerSegmentCapacity) {
+        int newCapacity = ledgerSegmentCapacity > 0 ? ledgerSegmentCapacity * 2 : 16;
+        LedgerSegment *grown = realloc(ledgerSegments, newCapacity * sizeof(LedgerSegment));
+        if (grown == NULL) {
+            return false;
+        }
+        ledgerSegments = grown;
+        ledgerSegmentCapacity = newCapacity;
+    }
+    ledgerSegments[ledgerSegmentCount].offset = ledgerFileSize;
+    ledgerSegments[ledgerSegmentCount].rowCount = rows;
+    ledgerSegments[ledgerSegmentCount].accountCount = accountsInSegment;
+    ledgerSegmentCount++;
+    
+    ledgerFileSize += totalBytes;
+    ledgerLastSequence = lastSequence;
+    ledgerTailCount = 0;
+    return true;
+}
+
+// Binary search over the segment's on-disk index; returns 1 and fills entry if found
+int ledgerFindAccount(const LedgerSegment *segment, int accountNumber, LedgerIndexEntry *entry) {
+    off_t indexOffset = segment->offset + sizeof(LedgerSegmentHeader);
+    int low = 0;
+    int high = segment->accountCount - 1;
+    
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (pread(ledgerFd, entry, sizeof(*entry), indexOffset + (off_t)mid * sizeof(*entry)) !=
+            (ssize_t)sizeof(*entry)) {
+            return 0;
+        }
+        if (entry->accountNumber == accountNumber) {
+            return 1;
+        }
+        if (entry->accountNumber < accountNumber) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return 0;
+}
+
+void printLedgerRow(time_t timestamp, int kind, long long deltaCents, int counterparty) {
+    static const char *kindNames[] = { "", "Deposit", "Withdrawal", "Transfer Out", "Transfer In", "Interest" };
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&timestamp));
+    
+    char amount[MONEY_TEXT_SIZE];
+    printf("%-20s %-13s %c$%s", date, kind >= LEDGER_DEPOSIT && kind <= LEDGER_INTEREST ? kindNames[kind] : "?",
+           deltaCents < 0 ? '-' : '+', formatMoney(deltaCents < 0 ? -deltaCents : deltaCents, amount));
+    if (counterparty != 0) {
+        printf("  (%s %d)", kind == LEDGER_TRANSFER_OUT ? "to" : "from", counterparty);
+    }
+    printf("\n");
+}
+
+void closeLedger() {
+    if (ledgerFd != -1) {
+        close(ledgerFd);
+        ledgerFd = -1;
+    }
+    free(ledgerSegments);
+    ledgerSegments = NULL;
+    ledgerSegmentCount = 0;
+    ledgerSegmentCapacity = 0;
+}
+
+// Opens the active audit segment, trimming a torn tail, and starts compressing
+// any closed segments an earlier run left uncompressed
+void openAudit() {
+    auditFd = open(AUDIT_FILENAME, O_RDWR | O_CREAT, 0644);
+    if (auditFd == -1) {
+        printf("Warning: could not open %s, account changes will not be audited!\n", AUDIT_FILENAME);
+        return;
+    }
+    
+    AuditSegmentHeader header;
+    if (pread(auditFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || header.magic != AUDIT_MAGIC) {
+        // New file: carry on numbering after the last closed segment
+        int *segments;
+        int count = listAuditSegments(&segments);
+        int segment = count > 0 ? segments[count - 1] + 1 : 1;
+        free(segments);
+        close(auditFd);
+        startAuditSegment(segment);
+    } else {
+        AuditRecord *records;
+        int count = readAuditRecords(auditFd, sizeof(header), &records);
+        free(records);
+        auditSegment = header.segment;
+        auditSize = lseek(auditFd, 0, SEEK_END);
+        if (count != -1) {
+            auditSize = sizeof(header) + (off_t)count * sizeof(AuditRecord);
+            if (ftruncate(auditFd, auditSize) != 0) {
+                printf("Warning: could not trim %s!\n", AUDIT_FILENAME);
+            }
+            lseek(auditFd, auditSize, SEEK_SET);
+        }
+    }
+    startAuditCompressor();
+}
+
+// Replaces bank_audit.dat with an empty segment numbered `segment`
+void startAuditSegment(int segment) {
+    AuditSegmentHeader header = { AUDIT_MAGIC, segment };
+    auditFd = open(AUDIT_FILENAME, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (auditFd == -1 ||
+        write(auditFd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        fsync(auditFd) != 0) {
+        printf("Warning: could not start %s, account changes will not be audited!\n", AUDIT_FILENAME);
+        if (auditFd != -1) {
+            close(auditFd);
+            auditFd = -1;
+        }
+        return;
+    }
+    auditSegment = segment;
+    auditSize = sizeof(header);
+}
+
+void closeAudit() {
+    if (auditFd != -1) {
+        close(auditFd);
+        auditFd = -1;
+    }
+    if (auditCompressorRunning) {
+        pthread_join(auditCompressor, NULL);
+        auditCompressorRunning = false;
+    }
+}
+
+// One synchronous append per change; compression happens off this path
+void auditAppend(int action, int accountNumber, const AccountProfile *before, const AccountProfile *after) {
+    if (auditFd == -1) {
+        return;
+    }
+    
+    AuditRecord record;
+    memset(&record, 0, sizeof(record));
+    record.timestamp = time(NULL);
+    record.accountNumber = accountNumber;
+    record.action = action;
+    if (before != NULL) {
+        copyProfileText(&record.before, before);
+    }
+    if (after != NULL) {
+        copyProfileText(&record.after, after);
+    }
+    record.checksum = auditChecksum(&record, offsetof(AuditRecord, checksum));
+    
+    if (write(auditFd, &record, sizeof(record)) != (ssize_t)sizeof(record) || fdatasync(auditFd) != 0) {
+        printf("Warning: could not write to %s!\n", AUDIT_FILENAME);
+        // Drop any partial record so the next one starts on a record boundary
+        if (ftruncate(auditFd, auditSize) == 0) {
+            lseek(auditFd, auditSize, SEEK_SET);
+        }
+        return;
+    }
+    auditSize += sizeof(record);
+    if (auditSize >= AUDIT_SEGMENT_BYTES) {
+        rotateAudit();
+    }
+}
+
+// Copies the text up to each terminator into a zeroed profile
+void copyProfileText(AccountProfile *target, const AccountProfile *source) {
+    memcpy(target->name, source->name, strnlen(source->name, sizeof(source->name) - 1));
+    memcpy(target->address, source->address, strnlen(source->address, sizeof(source->address) - 1));
+    memcpy(target->phone, source->phone, strnlen(source->phone, sizeof(source->phone) - 1));
+    memcpy(target->accountType, source->accountType, strnlen(source->accountType, sizeof(source->accountType) - 1));
+}
+
+// Closes the active segment under its numbered .raw name and starts the next one
+void rotateAudit() {
+    char path[64];
+    auditSegmentPath(path, sizeof(path), auditSegment, "raw");
+    close(auditFd);
+    auditFd = -1;
+    
+    if (rename(AUDIT_FILENAME, path) != 0) {
+        printf("Warning: could not rotate %s!\n", AUDIT_FILENAME);
+        auditFd = open(AUDIT_FILENAME, O_RDWR);
+        if (auditFd != -1) {
+            lseek(auditFd, auditSize, SEEK_SET);
+        }
+        return;
+    }
+    startAuditSegment(auditSegment + 1);
+    startAuditCompressor();
+}
+
+// At most one compressor runs; a rotation that catches one still busy waits for it
+void startAuditCompressor() {
+    if (auditCompressorRunning) {
+        pthread_join(auditCompressor, NULL);
+        auditCompressorRunning = false;
+    }
+    auditCompressorRunning = pthread_create(&auditCompressor, NULL, compressAuditSegments, NULL) == 0;
+}
+
+// Compresses every closed segment that is still in .raw form
+void *compressAuditSegments(void *arg) {
+    (void)arg;
+    int *segments;
+    int count = listAuditSegments(&segments);
+    for (int i = 0; i < count; i++) {
+        char path[64];
+        auditSegmentPath(path, sizeof(path), segments[i], "raw");
+        if (access(path, F_OK) == 0 && !compressAuditSegment(segments[i])) {
+            printf("Warning: could not compress %s!\n", path);
+        }
+    }
+    free(segments);
+    return NULL;
+}
+
+// Writes bank_audit.N.lz through a temporary file, then removes the .raw segment
+bool compressAuditSegment(int segment) {
+    char rawPath[64];
+    char packedPath[64];
+    char tempPath[72];
+    auditSegmentPath(rawPath, sizeof(rawPath), segment, "raw");
+    auditSegmentPath(packedPath, sizeof(packedPath), segment, "lz");
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", packedPath);
+    
+    int input = open(rawPath, O_RDONLY);
+    if (input == -1) {
+        return false;
+    }
+    struct stat info;
+    AuditSegmentHeader header;
+    if (fstat(input, &info) != 0 ||
+        pread(input, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != AUDIT_MAGIC) {
+        close(input);
+        return false;
+    }
+    int output = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (output == -1) {
+        close(input);
+        return false;
+    }
+    
+    AuditArchiveHeader archive = { AUDIT_ARCHIVE_MAGIC, segment, info.st_size - (off_t)sizeof(header) };
+    unsigned char *raw = malloc(AUDIT_BLOCK_SIZE);
+    unsigned char *packed = malloc(AUDIT_BLOCK_SIZE + AUDIT_BLOCK_SIZE / 255 + 16);
+    bool ok = raw != NULL && packed != NULL &&
+              write(output, &archive, sizeof(archive)) == (ssize_t)sizeof(archive);
+    for (off_t offset = sizeof(header); ok && offset < info.st_size; ) {
+        ssize_t length = pread(input, raw, AUDIT_BLOCK_SIZE, offset);
+        if (length <= 0) {
+            ok = false;
+            break;
+        }
+        
+        int packedLength = auditCompress(raw, length, packed);
+        const unsigned char *data = packed;
+        if (packedLength >= length) {
+            packedLength = length; // stored
+            data = raw;
+        }
+        AuditBlockHeader block = { length, packedLength, auditChecksum(raw, length) };
+        ok = write(output, &block, sizeof(block)) == (ssize_t)sizeof(block) &&
+             write(output, data, packedLength) == packedLength;
+        offset += length;
+    }
+    ok = ok && fsync(output) == 0;
+    
+    free(raw);
+    free(packed);
+    close(input);
+    if (close(output) != 0 || !ok || rename(tempPath, packedPath) != 0) {
+        unlink(tempPath);
+        return false;
+    }
+    unlink(rawPath);
+    return true;
+}
+
+void auditSegmentPath(char *path, size_t size, int segment, const char *kind) {
+    snprintf(path, size, "bank_audit.%06d.%s", segment, kind);
+}
+
+// Sorted numbers of the closed segments, whether still .raw or already .lz
+int listAuditSegments(int **segments) {
+    *segments = NULL;
+    DIR *directory = opendir(".");
+    if (directory == NULL) {
+        return 0;
+    }
+    
+    int count = 0;
+    int capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL) {
+        int segment;
+        int consumed = 0;
+        char kind[4];
+        if (sscanf(entry->d_name, "bank_audit.%d.%3s%n", &segment, kind, &consumed) != 2 ||
+            entry->d_name[consumed] != '\0' ||
+            (strcmp(kind, "raw") != 0 && strcmp(kind, "lz") != 0)) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 16;
+            int *grown = realloc(*segments, capacity * sizeof(int));
+            if (grown == NULL) {
+                break;
+            }
+            *segments = grown;
+        }
+        (*segments)[count++] = segment;
+    }
+    closedir(directory);
+    
+    if (count == 0) {
+        return 0;
+    }
+    qsort(*segments, count, sizeof(int), compareInts);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || (*segments)[unique - 1] != (*segments)[i]) {
+            (*segments)[unique++] = (*segments)[i];
+        }
+    }
+    return unique;
+}
+
+// Records of a closed segment, from its .lz file when there is one; -1 if unreadable
+int readAuditSegment(int segment, AuditRecord **records) {
+    *records = NULL;
+    char path[64];
+    auditSegmentPath(path, sizeof(path), segment, "lz");
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        auditSegmentPath(path, sizeof(path), segment, "raw");
+        fd = open(path, O_RDONLY);
+        if (fd == -1) {
+            return -1;
+        }
+        int count = readAuditRecords(fd, sizeof(AuditSegmentHeader), records);
+        close(fd);
+        return count;
+    }
+    
+    AuditArchiveHeader archive;
+    unsigned char *raw = NULL;
+    unsigned char *packed = malloc(AUDIT_BLOCK_SIZE + AUDIT_BLOCK_SIZE / 255 + 16);
+    bool ok = packed != NULL &&
+              read(fd, &archive, sizeof(archive)) == (ssize_t)sizeof(archive) &&
+              archive.magic == AUDIT_ARCHIVE_MAGIC &&
+              archive.rawSize >= 0 && archive.rawSize <= INT_MAX &&
+              (raw = malloc(archive.rawSize + 1)) != NULL;
+    long long filled = 0;
+    while (ok && filled < archive.rawSize) {
+        AuditBlockHeader block;
+        ok = read(fd, &block, sizeof(block)) == (ssize_t)sizeof(block) &&
+             block.rawSize > 0 && block.rawSize <= AUDIT_BLOCK_SIZE &&
+             block.packedSize <= block.rawSize && filled + block.rawSize <= archive.rawSize &&
+             read(fd, packed, block.packedSize) == (ssize_t)block.packedSize;
+        if (!ok) {
+            break;
+        }
+        if (block.packedSize == block.rawSize) {
+            memcpy(raw + filled, packed, block.rawSize);
+        } else {
+            ok = auditDecompress(packed, block.packedSize, raw + filled, block.rawSize) == (int)block.rawSize;
+        }
+        ok = ok && auditChecksum(raw + filled, block.rawSize) == block.checksum;
+        filled += block.rawSize;
+    }
+    free(packed);
+    close(fd);
+    if (!ok) {
+        free(raw);
+        return -1;
+    }
+    
+    *records = (AuditRecord *)raw;
+    return intactAuditRecords(*records, archive.rawSize / sizeof(AuditRecord));
+}
+
+// Reads from `offset` to the end of the file; -1 when out of memory
+int readAuditRecords(int fd, off_t offset, AuditRecord **records) {
+    *records = NULL;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= offset) {
+        return 0;
+    }
+    
+    int capacity = (info.st_size - offset) / sizeof(AuditRecord);
+    *records = malloc((capacity + 1) * sizeof(AuditRecord));
+    if (*records == NULL) {
+        return -1;
+    }
+    ssize_t length = pread(fd, *records, capacity * sizeof(AuditRecord), offset);
+    return length > 0 ? intactAuditRecords(*records, length / sizeof(AuditRecord)) : 0;
+}
+
+// Number of leading records whose checksums hold; a torn or corrupt one ends the run
+int intactAuditRecords(const AuditRecord *records, int count) {
+    int intact = 0;
+    while (intact < count &&
+           records[intact].checksum == auditChecksum(&records[intact], offsetof(AuditRecord, checksum))) {
+        intact++;
+    }
+    return intact;
+}
+
+// FNV-1a
+unsigned int auditChecksum(const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// LZ77 block codec in the style of LZ4. Each sequence is a token (literal count
+// in the high nibble, match length - 4 in the low one, 15 meaning more length
+// bytes follow), the literals, then a 16-bit offset back into the output and
+// any extra match length bytes. The last sequence carries literals only.
+// `target` needs room for size + size / 255 + 16 bytes.
+int auditCompress(const unsigned char *source, int size, unsigned char *target) {
+    int table[1 << AUDIT_HASH_BITS];
+    memset(table, -1, sizeof(table));
+    
+    int anchor = 0;
+    int out = 0;
+    int i = 0;
+    while (i + AUDIT_MIN_MATCH <= size) {
+        unsigned int sequence;
+        memcpy(&sequence, source + i, sizeof(sequence));
+        unsigned int slot = (sequence * 2654435761u) >> (32 - AUDIT_HASH_BITS);
+        int candidate = table[slot];
+        table[slot] = i;
+        if (candidate < 0 || i - candidate > 65535 ||
+            memcmp(source + candidate, source + i, AUDIT_MIN_MATCH) != 0) {
+            i++;
+            continue;
+        }
+        
+        int length = AUDIT_MIN_MATCH;
+        while (i + length < size && source[candidate + length] == source[i + length]) {
+            length++;
+        }
+        out = auditEmitSequence(target, out, source + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+    return auditEmitSequence(target, out, source + anchor, size - anchor, 0, 0);
+}
+
+// A matchLength of 0 writes the closing literals-only sequence
+int auditEmitSequence(unsigned char *target, int out, const unsigned char *literals, int literalCount,
+                      int offset, int matchLength) {
+    int token = out++;
+    target[token] = (literalCount < 15 ? literalCount : 15) << 4;
+    if (literalCount >= 15) {
+        out = auditEmitLength(target, out, literalCount);
+    }
+    memcpy(target + out, literals, literalCount);
+    out += literalCount;
+    
+    if (matchLength > 0) {
+        int code = matchLength - AUDIT_MIN_MATCH;
+        target[out++] = offset & 0xFF;
+        target[out++] = offset >> 8;
+        target[token] |= code < 15 ? code : 15;
+        if (code >= 15) {
+            out = auditEmitLength(target, out, code);
+        }
+    }
+    return out;
+}
+
+// The part of a length beyond the nibble's 15: runs of 255, then the remainder
+int auditEmitLength(unsigned char *target, int out, int length) {
+    for (length -= 15; length >= 255; length -= 255) {
+        target[out++] = 255;
+    }
+    target[out++] = length;
+    return out;
+}
+
+// Returns the decoded size, or -1 for malformed input or output past capacity
+int auditDecompress(const unsigned char *source, int size, unsigned char *target, int capacity) {
+    int in = 0;
+    int out = 0;
+    while (in < size) {
+        int token = source[in++];
+        int literals = token >> 4;
+        if (literals == 15) {
+            int extra;
+            do {
+                if (in == size) {
+                    return -1;
+                }
+                extra = source[in++];
+                literals += extra;
+            } while (extra == 255);
+        }
+        if (literals > size - in || literals > capacity - out) {
+            return -1;
+        }
+        memcpy(target + out, source + in, literals);
+        in += literals;
+        out += literals;
+        if (in == size) {
+            break; // closing sequence
+        }
+        
+        if (size - in < 2) {
+            return -1;
+        }
+        int offset = source[in] | source[in + 1] << 8;
+        in += 2;
+        int length = (token & 15) + AUDIT_MIN_MATCH;
+        if ((token & 15) == 15) {
+            int extra;
+            do {
+                if (in == size) {
+                    return -1;
+                }
+                extra = source[in++];
+                length += extra;
+            } while (extra == 255);
+        }
+        if (offset == 0 || offset > out || length > capacity - out) {
+            return -1;
+        }
+        // Byte by byte: an offset shorter than the length repeats the pattern
+        for (int i = 0; i < length; i++, out++) {
+            target[out] = target[out - offset];
+        }
+    }
+    return out;
+}
+
+// Oldest first: the closed segments in order, then the active one
+int runAuditView(int accountNumber) {
+    printf("\n===== AUDIT TRAIL FOR ACCOUNT %d =====\n", accountNumber);
+    
+    int *segments;
+    int segmentCount = listAuditSegments(&segments);
+    int found = 0;
+    for (int i = 0; i <= segmentCount; i++) {
+        AuditRecord *records = NULL;
+        int count = 0;
+        if (i < segmentCount) {
+            count = readAuditSegment(segments[i], &records);
+            if (count == -1) {
+                printf("Warning: audit segment %d could not be read!\n", segments[i]);
+            }
+        } else {
+            int fd = open(AUDIT_FILENAME, O_RDONLY);
+            if (fd != -1) {
+                count = readAuditRecords(fd, sizeof(AuditSegmentHeader), &records);
+                close(fd);
+            }
+        }
+        
+        for (int j = 0; j < count; j++) {
+            if (records[j].accountNumber == accountNumber) {
+                printAuditRecord(&records[j]);
+                found++;
+            }
+        }
+        free(records);
+    }
+    free(segments);
+    
+    if (found == 0) {
+        printf("No audit records for this account.\n");
+    }
+    return 0;
+}
+
+void viewAuditTrail() {
+    int accNumber;
+    printf("\nEnter account number: ");
+    scanf("%d", &accNumber);
+    clearInputBuffer();
+    runAuditView(accNumber);
+}
+
+// Openings and closings list every field; modifications only the changed ones
+void printAuditRecord(const AuditRecord *record) {
+    static const char *actions[] = { "Opened", "Modified", "Closed" };
+    const char *labels[] = { "Name", "Address", "Phone", "Account Type" };
+    const char *before[] = { record->before.name, record->before.address,
+                             record->before.phone, record->before.accountType };
+    const char *after[] = { record->after.name, record->after.address,
+                            record->after.phone, record->after.accountType };
+    
+    bool known = record->action >= AUDIT_OPENED && record->action <= AUDIT_CLOSED;
+    printf("\n%.24s  %s\n", ctime(&record->timestamp), known ? actions[record->action] : "Unknown");
+    for (int i = 0; i < 4; i++) {
+        if (record->action == AUDIT_OPENED) {
+            printf("    %s: %s\n", labels[i], after[i]);
+        } else if (record->action == AUDIT_CLOSED) {
+            printf("    %s: %s\n", labels[i], before[i]);
+        } else if (strcmp(before[i], after[i]) != 0) {
+            printf("    %s: %s -> %s\n", labels[i], before[i], after[i]);
+        }
+    }
+}
+
+void initAccountLocks() {
+    for (int i = 0; i < LOCK_STRIPES; i++) {
+        pthread_mutex_init(&accountLocks[i].mutex, NULL);
+    }
+}
+
+// Stripes are keyed on the account number so they survive index shifts
+int lockStripe(int accountIndex) {
+    return hashAccountNumber(*accountNumberAt(accountIndex)) & (LOCK_STRIPES - 1);
+}
+
+// Takes both stripes in ascending stripe order, which rules out deadlock even
+// when unrelated accounts share a stripe; secondIndex may be -1
+void lockAccounts(int firstIndex, int secondIndex) {
+    int first = lockStripe(firstIndex);
+    int second = secondIndex != -1 ? lockStripe(secondIndex) : first;
+    
+    if (first > second) {
+        int swap = first;
+        first = second;
+        second = swap;
+    }
+    pthread_mutex_lock(&accountLocks[first].mutex);
+    if (second != first) {
+        pthread_mutex_lock(&accountLocks[second].mutex);
+    }
+}
+
+void unlockAccounts(int firstIndex, int secondIndex) {
+    int first = lockStripe(firstIndex);
+    int second = secondIndex != -1 ? lockStripe(secondIndex) : first;
+    
+    if (second != first) {
+        pthread_mutex_unlock(&accountLocks[second].mutex);
+    }
+    pthread_mutex_unlock(&accountLocks[first].mutex);
+}
+
+int applyDeposit(int accountIndex, Money amount) {
+    if (amount <= 0) {
+        return TX_INVALID_AMOUNT;
+    }
+    
+    lockAccounts(accountIndex, -1);
+    Money *balance = balanceAt(accountIndex);
+    if (!moneyAdd(*balance, amount, balance)) {
+        unlockAccounts(accountIndex, -1);
+        return TX_BALANCE_OVERFLOW;
+    }
+    *lastTransactionAt(accountIndex) = time(NULL);
+    journalAppend(TX_DEPOSIT, accountIndex, -1, amount);
+    unlockAccounts(accountIndex, -1);
+    return TX_OK;
+}
+
+int applyWithdrawal(int accountIndex, Money amount) {
+    if (amount <= 0) {
+        return TX_INVALID_AMOUNT;
+    }
+    
+    lockAccounts(accountIndex, -1);
+    Money *balance = balanceAt(accountIndex);
+    Money remaining;
+    if (!moneySub(*balance, amount, &remaining) || remaining < 0) {
+        unlockAccounts(accountIndex, -1);
+        return TX_INSUFFICIENT_FUNDS;
+    }
+    time_t now = time(NULL);
+    if (velocityLimitsEnabled && !velocityAllows(accountIndex, now, amount)) {
+        unlockAccounts(accountIndex, -1);
+        return TX_VELOCITY_LIMIT;
+    }
+    
+    *balance = remaining;
+    *lastTransactionAt(accountIndex) = now;
+    if (velocityLimitsEnabled) {
+        velocityRecord(accountIndex, now, amount);
+    }
+    journalAppend(TX_WITHDRAW, accountIndex, -1, amount);
+    unlockAccounts(accountIndex, -1);
+    return TX_OK;
+}
+
+// Safe to call from many threads at once as long as no account is being
+// created or deleted at the same time
+int applyTransfer(int fromIndex, int toIndex, Money amount) {
+    if (fromIndex == toIndex) {
+        return TX_SAME_ACCOUNT;
+    }
+    if (amount <= 0) {
+        return TX_INVALID_AMOUNT;
+    }
+    
+    lockAccounts(fromIndex, toIndex);
+    Money *fromBalance = balanceAt(fromIndex);
+    Money *toBalance = balanceAt(toIndex);
+    Money remaining;
+    if (!moneySub(*fromBalance, amount, &remaining) || remaining < 0) {
+        unlockAccounts(fromIndex, toIndex);
+        return TX_INSUFFICIENT_FUNDS;
+    }
+    time_t now = time(NULL);
+    if (velocityLimitsEnabled && !velocityAllows(fromIndex, now, amount)) {
+        unlockAccounts(fromIndex, toIndex);
+        return TX_VELOCITY_LIMIT;
+    }
+    if (!moneyAdd(*toBalance, amount, toBalance)) {
+        unlockAccounts(fromIndex, toIndex);
+        return TX_BALANCE_OVERFLOW;
+    }
+    
+    *fromBalance = remaining;
+    if (velocityLimitsEnabled) {
+        velocityRecord(fromIndex, now, amount);
+    }
+    
+    *lastTransactionAt(fromIndex) = now;
+    *lastTransactionAt(toIndex) = now;
+    journalAppend(TX_TRANSFER, fromIndex, toIndex, amount);
+    unlockAccounts(fromIndex, toIndex);
+    return TX_OK;
+}
+
+// Scaling benchmark for the concurrent transfer path. Runs on a synthetic,
+// in-memory account set with the journal and ledger detached, so the real
+// data files are never touched.
+int runTransferStress(int maxThreads, long long totalTransfers) {
+    if (maxThreads < 1 || totalTransfers < 1) {
+        printf("Thread and transfer counts must be positive!\n");
+        return 1;
+    }
+    
+    initAccountLocks();
+    Account account;
+    memset(&account, 0, sizeof(account));
+    strcpy(account.accountType, "savings");
+    account.balance = 100000;
+    for (int i = 0; i < STRESS_ACCOUNTS; i++) {
+        int index = appendAccount();
+        if (index == -1) {
+            printf("Out of memory!\n");
+            return 1;
+        }
+        account.accountNumber = 1000 + i;
+        storeAccount(index, &account);
+    }
+    rebuildAccountIndex();
+    Money expectedTotal = STRESS_ACCOUNTS * 100000LL;
+    
+    printf("\n===== TRANSFER STRESS TEST =====\n");
+    printf("%d accounts, %lld transfers per run, %d lock stripes\n",
+           STRESS_ACCOUNTS, totalTransfers, LOCK_STRIPES);
+    printf("%-8s %-10s %-14s %-8s %s\n", "Threads", "Seconds", "Transfers/s", "Speedup", "Balances");
+    
+    double baseline = 0;
+    int threads = 1;
+    for (;;) {
+        pthread_t *ids = malloc(threads * sizeof(pthread_t));
+        StressWorker *workers = malloc(threads * sizeof(StressWorker));
+        if (ids == NULL || workers == NULL) {
+            printf("Out of memory!\n");
+            free(ids);
+            free(workers);
+            return 1;
+        }
+        
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int t = 0; t < threads; t++) {
+            workers[t].seed = 2463534242u + t * 7919u;
+            workers[t].transfers = totalTransfers / threads + (t < totalTransfers % threads ? 1 : 0);
+            pthread_create(&ids[t], NULL, stressWorker, &workers[t]);
+        }
+        for (int t = 0; t < threads; t++) {
+            pthread_join(ids[t], NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        
+        Money total = 0;
+        for (int i = 0; i < accountCount; i++) {
+            total += *balanceAt(i);
+        }
+        
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        double rate = totalTransfers / seconds;
+        if (threads == 1) {
+            baseline = rate;
+        }
+        printf("%-8d %-10.3f %-14.0f %-8.2f %s\n", threads, seconds, rate,
+               baseline > 0 ? rate / baseline : 1.0, total == expectedTotal ? "OK" : "MISMATCH");
+        
+        free(ids);
+        free(workers);
+        if (threads == maxThreads) {
+            break;
+        }
+        threads = threads * 2 < maxThreads ? threads * 2 : maxThreads;
+    }
+    
+    freeAccountStore();
+    return 0;
+}
+
+void *stressWorker(void *arg) {
+    StressWorker *worker = arg;
+    unsigned int state = worker->seed;
+    
+    for (long long i = 0; i < worker->transfers; i++) {
+        // xorshift32: cheap per-thread randomness without shared state
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int from = state % STRESS_ACCOUNTS;
+        int to = (state >> 8) % STRESS_ACCOUNTS;
+        Money amount = (1 + (state >> 24) % 50) * 100;
+        
+        applyTransfer(from, to, amount);
+    }
+    return NULL;
+}
+
+// Non-interactive ingestion of a CSV or binary transaction file. CSV rows are
+// "deposit,<account>,<amount>", "withdraw,<account>,<amount>" or
+// "transfer,<account>,<amount>,<target>"; blank lines and '#' comments are
+// skipped. Rejected rows go to <path>.rejected with the reason.
+int runBatch(const char *path) {
+    FILE *input = fopen(path, "rb");
+    if (input == NULL) {
+        printf("Could not open %s!\n", path);
+        return 1;
+    }
+    
+    char rejectsPath[512];
+    snprintf(rejectsPath, sizeof(rejectsPath), "%s.rejected", path);
+    FILE *rejects = fopen(rejectsPath, "w");
+    
+    char *buffer = malloc(BATCH_READ_BUFFER + 1);
+    if (buffer == NULL) {
+        printf("Out of memory!\n");
+        fclose(input);
+        if (rejects != NULL) {
+            fclose(rejects);
+        }
+        return 1;
+    }
+    
+    BatchStats stats;
+    memset(&stats, 0, sizeof(stats));
+    journalSyncInterval = BATCH_SYNC_INTERVAL;
+    
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    unsigned int magic = 0;
+    size_t filled = fread(buffer, 1, BATCH_READ_BUFFER, input);
+    if (filled >= sizeof(magic)) {
+        memcpy(&magic, buffer, sizeof(magic));
+    }
+    
+    if (magic == BATCH_MAGIC) {
+        // Binary: whole records per block, carrying any partial record over
+        size_t used = sizeof(magic);
+        for (;;) {
+            while (filled - used >= sizeof(BatchRecord)) {
+                BatchRecord record;
+                memcpy(&record, buffer + used, sizeof(record));
+                used += sizeof(record);
+                applyBatchRecord(&record, &stats, rejects, stats.read + 1);
+            }
+            if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+                saveData();
+            }
+            
+            size_t leftover = filled - used;
+            memmove(buffer, buffer + used, leftover);
+            size_t got = fread(buffer + leftover, 1, BATCH_READ_BUFFER - leftover, input);
+            if (got == 0) {
+                if (leftover > 0) {
+                    stats.read++;
+                    stats.malformed++;
+                    if (rejects != NULL) {
+                        fprintf(rejects, "%lld,malformed,truncated record\n", stats.read);
+                    }
+                }
+                break;
+            }
+            filled = leftover + got;
+            used = 0;
+        }
+    } else {
+        // CSV: split complete lines in place, carry the trailing partial line over
+        long long lineNumber = 0;
+        size_t used = 0;
+        for (;;) {
+            bool atEof = filled < BATCH_READ_BUFFER;
+            for (;;) {
+                char *lineStart = buffer + used;
+                char *newline = memchr(lineStart, '\n', filled - used);
+                if (newline == NULL) {
+                    if (!atEof || used == filled) {
+                        break;
+                    }
+                    newline = buffer + filled; // last line without a newline
+                }
+                *newline = '\0';
+                used = newline - buffer + (newline < buffer + filled ? 1 : 0);
+                lineNumber++;
+                
+                BatchRecord record;
+                char *trimmed = lineStart;
+                while (*trimmed == ' ' || *trimmed == '\t' || *trimmed == '\r') {
+                    trimmed++;
+                }
+                if (*trimmed == '\0' || *trimmed == '#') {
+                    continue;
+                }
+                if (!parseBatchLine(trimmed, &record)) {
+                    for (char *c = trimmed; c < newline; c++) {
+                        if (*c == '\0') {
+                            *c = ','; // undo the field splitting for the report
+                        }
+                    }
+                    stats.read++;
+                    stats.malformed++;
+                    if (rejects != NULL) {
+                        fprintf(rejects, "%lld,malformed,%s\n", lineNumber, trimmed);
+                    }
+                    continue;
+                }
+                applyBatchRecord(&record, &stats, rejects, lineNumber);
+            }
+            if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+                saveData();
+            }
+            if (atEof) {
+                break;
+            }
+            
+            size_t leftover = filled - used;
+            if (leftover == BATCH_READ_BUFFER) {
+                // A single line longer than the whole buffer: skip to its end, so
+                // it is counted once and the line numbers after it stay right
+                lineNumber++;
+                stats.read++;
+                stats.malformed++;
+                if (rejects != NULL) {
+                    fprintf(rejects, "%lld,line too long,\n", lineNumber);
+                }
+                char *newline = NULL;
+                leftover = 0;
+                while (newline == NULL && (filled = fread(buffer, 1, BATCH_READ_BUFFER, input)) > 0) {
+                    newline = memchr(buffer, '\n', filled);
+                }
+                if (newline != NULL) {
+                    used = newline + 1 - buffer;
+                    leftover = filled - used;
+                }
+            }
+            memmove(buffer, buffer + used, leftover);
+            filled = leftover + fread(buffer + leftover, 1, BATCH_READ_BUFFER - leftover, input);
+            used = 0;
+        }
+    }
+    
+    journalFlush(true);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    journalSyncInterval = JOURNAL_SYNC_INTERVAL;
+    
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printBatchSummary(&stats, seconds, rejects != NULL ? rejectsPath : NULL);
+    
+    free(buffer);
+    fclose(input);
+    if (rejects != NULL) {
+        fclose(rejects);
+    }
+    return 0;
+}
+
+bool parseBatchLine(char *line, BatchRecord *record) {
+    char *fields[4];
+    int fieldCount = 0;
+    char *cursor = line;
+    
+    for (;;) {
+        if (fieldCount == 4) {
+            return false; // too many fields
+        }
+        fields[fieldCount++] = cursor;
+        char *comma = strchr(cursor, ',');
+        if (comma == NULL) {
+            break;
+        }
+        *comma = '\0';
+        cursor = comma + 1;
+    }
+    
+    memset(record, 0, sizeof(*record));
+    if (strcmp(fields[0], "deposit") == 0 || strcmp(fields[0], "D") == 0) {
+        record->type = TX_DEPOSIT;
+    } else if (strcmp(fields[0], "withdraw") == 0 || strcmp(fields[0], "W") == 0) {
+        record->type = TX_WITHDRAW;
+    } else if (strcmp(fields[0], "transfer") == 0 || strcmp(fields[0], "T") == 0) {
+        record->type = TX_TRANSFER;
+    } else {
+        return false;
+    }
+    if (fieldCount != (record->type == TX_TRANSFER ? 4 : 3)) {
+        return false;
+    }
+    
+    char *end;
+    long number = strtol(fields[1], &end, 10);
+    if (end == fields[1] || *end != '\0') {
+        return false;
+    }
+    record->accountNumber = (int)number;
+    
+    if (!parseMoney(fields[2], &record->amount)) {
+        return false;
+    }
+    
+    if (record->type == TX_TRANSFER) {
+        number = strtol(fields[3], &end, 10);
+        while (*end == ' ' || *end == '\r') {
+            end++;
+        }
+        if (end == fields[3] || *end != '\0') {
+            return false;
+        }
+        record->targetNumber = (int)number;
+    }
+    return true;
+}
+
+void applyBatchRecord(const BatchRecord *record, BatchStats *stats, FILE *rejects, long long position) {
+    static const char *typeNames[] = { "?", "deposit", "withdraw", "transfer" };
+    const char *reason = NULL;
+    stats->read++;
+    
+    int index = findAccountByNumber(record->accountNumber);
+    int status = TX_OK;
+    if (record->type < TX_DEPOSIT || record->type > TX_TRANSFER) {
+        stats->malformed++;
+        reason = "malformed";
+    } else if (index == -1) {
+        stats->unknownAccount++;
+        reason = "unknown account";
+    } else if (record->type == TX_DEPOSIT) {
+        status = applyDeposit(index, record->amount);
+    } else if (record->type == TX_WITHDRAW) {
+        status = applyWithdrawal(index, record->amount);
+    } else {
+        int target = findAccountByNumber(record->targetNumber);
+        if (target == -1) {
+            stats->unknownAccount++;
+            reason = "unknown target account";
+        } else {
+            status = applyTransfer(index, target, record->amount);
+        }
+    }
+    
+    if (reason == NULL) {
+        switch (status) {
+            case TX_OK: stats->applied++; return;
+            case TX_INVALID_AMOUNT: stats->invalidAmount++; reason = "invalid amount"; break;
+            case TX_INSUFFICIENT_FUNDS: stats->insufficientFunds++; reason = "insufficient balance"; break;
+            case TX_BALANCE_OVERFLOW: stats->balanceOverflow++; reason = "balance overflow"; break;
+            default: stats->sameAccount++; reason = "same account"; break;
+        }
+    }
+    
+    if (rejects != NULL) {
+        int type = record->type >= TX_DEPOSIT && record->type <= TX_TRANSFER ? record->type : 0;
+        char amount[MONEY_TEXT_SIZE];
+        fprintf(rejects, "%lld,%s,%s,%d,%s", position, reason, typeNames[type],
+                record->accountNumber, formatMoney(record->amount, amount));
+        if (record->type == TX_TRANSFER) {
+            fprintf(rejects, ",%d", record->targetNumber);
+        }
+        fprintf(rejects, "\n");
+    }
+}
+
+void printBatchSummary(const BatchStats *stats, double seconds, const char *rejectsPath) {
+    long long rejected = stats->read - stats->applied;
+    
+    printf("\n===== BATCH SUMMARY =====\n");
+    printf("Transactions read: %lld\n", stats->read);
+    printf("Applied: %lld\n", stats->applied);
+    printf("Rejected: %lld\n", rejected);
+    printf("  Malformed: %lld\n", stats->malformed);
+    printf("  Unknown account: %lld\n", stats->unknownAccount);
+    printf("  Invalid amount: %lld\n", stats->invalidAmount);
+    printf("  Insufficient balance: %lld\n", stats->insufficientFunds);
+    printf("  Same account: %lld\n", stats->sameAccount);
+    printf("  Balance overflow: %lld\n", stats->balanceOverflow);
+    printf("Elapsed: %.3f s\n", seconds);
+    printf("Throughput: %.0f tx/s\n", seconds > 0 ? stats->read / seconds : 0.0);
+    if (rejected > 0 && rejectsPath != NULL) {
+        printf("Rejected rows written to %s\n", rejectsPath);
+    }
+}
+
+// Turns on limit checks for this run. Counters live in memory only, so they
+// are rebuilt from the last day of the ledger first.
+void enableVelocityLimits() {
+    velocityLimitsEnabled = true;
+    if (!reserveVelocityChunks()) {
+        printf("Warning: not enough memory for velocity limits!\n");
+    }
+    seedVelocityFromLedger(time(NULL) - velocityWindowSeconds[VELOCITY_WINDOWS - 1]);
+}
+
+// Replays outflows newer than the cutoff: the in-memory tail, then segments
+// from the newest back until one holds nothing that recent
+void seedVelocityFromLedger(time_t cutoff) {
+    for (int i = 0; i < ledgerTailCount; i++) {
+        const LedgerRow *row = &ledgerTail[i];
+        int index = findAccountByNumber(row->accountNumber);
+        if (index != -1 && row->deltaCents < 0 && row->timestamp > cutoff) {
+            velocityRecord(index, row->timestamp, -row->deltaCents);
+        }
+    }
+    
+    for (int s = ledgerSegmentCount - 1; s >= 0; s--) {
+        const LedgerSegment *segment = &ledgerSegments[s];
+        size_t indexBytes = (size_t)segment->accountCount * sizeof(LedgerIndexEntry);
+        size_t bytes = indexBytes + (size_t)segment->rowCount * sizeof(long long) * 2;
+        unsigned char *buffer = malloc(bytes > 0 ? bytes : 1);
+        if (buffer == NULL ||
+            pread(ledgerFd, buffer, bytes, segment->offset + sizeof(LedgerSegmentHeader)) != (ssize_t)bytes) {
+            free(buffer);
+            return;
+        }
+        
+        // Columns follow 12-byte index entries, so they may be unaligned
+        const unsigned char *timestamps = buffer + indexBytes;
+        const unsigned char *deltas = timestamps + (size_t)segment->rowCount * sizeof(long long);
+        bool recent = false;
+        for (int e = 0; e < segment->accountCount; e++) {
+            LedgerIndexEntry entry;
+            memcpy(&entry, buffer + e * sizeof(LedgerIndexEntry), sizeof(entry));
+            int index = findAccountByNumber(entry.accountNumber);
+            int end = entry.firstRow + entry.rowCount;
+            for (int row = entry.firstRow; row < end && row < segment->rowCount; row++) {
+                long long timestamp, delta;
+                memcpy(&timestamp, timestamps + row * sizeof(long long), sizeof(timestamp));
+                memcpy(&delta, deltas + row * sizeof(long long), sizeof(delta));
+                if (timestamp <= cutoff) {
+                    continue;
+                }
+                recent = true;
+                if (index != -1 && delta < 0) {
+                    velocityRecord(index, timestamp, -delta);
+                }
+            }
+        }
+        free(buffer);
+        if (!recent) {
+            return;
+        }
+    }
+}
+
+// Where an account's windows pointer lives; NULL while limits are off. Never
+// allocates, so the account's stripe lock is all a caller needs.
+VelocityWindows **velocitySlot(int index) {
+    int chunk = index >> ACCOUNT_CHUNK_SHIFT;
+    if (chunk >= velocityChunkCount || velocityChunks[chunk] == NULL) {
+        return NULL;
+    }
+    return &velocityChunks[chunk][index & ACCOUNT_CHUNK_MASK];
+}
+
+// Gives every account chunk its pointer block. Grows with chunkCount, so it
+// only runs where accounts are created: never beside concurrent transfers.
+bool reserveVelocityChunks() {
+    if (velocityChunkCount < chunkCount) {
+        VelocityWindows ***grown = realloc(velocityChunks, chunkCount * sizeof(VelocityWindows **));
+        if (grown == NULL) {
+            return false;
+        }
+        memset(grown + velocityChunkCount, 0, (chunkCount - velocityChunkCount) * sizeof(VelocityWindows **));
+        velocityChunks = grown;
+        velocityChunkCount = chunkCount;
+    }
+    for (int chunk = 0; chunk < velocityChunkCount; chunk++) {
+        if (velocityChunks[chunk] == NULL) {
+            velocityChunks[chunk] = calloc(ACCOUNT_CHUNK_SIZE, sizeof(VelocityWindows *));
+            if (velocityChunks[chunk] == NULL) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Compaction moves records into deleted or already vacated slots
+void moveVelocity(int to, int from) {
+    VelocityWindows **source = velocitySlot(from);
+    if (source == NULL || *source == NULL) {
+        releaseVelocity(to);
+        return;
+    }
+    VelocityWindows **target = velocitySlot(to);
+    if (target != NULL) {
+        free(*target);
+        *target = *source;
+    } else {
+        free(*source); // no block for that chunk: this account starts counting afresh
+    }
+    *source = NULL;
+}
+
+void releaseVelocity(int index) {
+    VelocityWindows **slot = velocitySlot(index);
+    if (slot != NULL) {
+        free(*slot);
+        *slot = NULL;
+    }
+}
+
+void freeVelocity() {
+    for (int chunk = 0; chunk < velocityChunkCount; chunk++) {
+        if (velocityChunks[chunk] == NULL) {
+            continue;
+        }
+        for (int i = 0; i < ACCOUNT_CHUNK_SIZE; i++) {
+            free(velocityChunks[chunk][i]);
+        }
+        free(velocityChunks[chunk]);
+    }
+    free(velocityChunks);
+    velocityChunks = NULL;
+    velocityChunkCount = 0;
+}
+
+// Slides a window forward so `bucket` is the newest, dropping what falls out;
+// at most one lap of the ring is ever cleared
+void velocityAdvance(VelocityWindows *windows, int window, long long bucket) {
+    long long steps = bucket - windows->headBucket[window];
+    if (steps <= 0) {
+        return;
+    }
+    if (steps > VELOCITY_BUCKETS) {
+        steps = VELOCITY_BUCKETS;
+    }
+    for (long long step = 1; step <= steps; step++) {
+        int slot = (windows->headBucket[window] + step) % VELOCITY_BUCKETS;
+        windows->totalCount[window] -= windows->count[window][slot];
+        windows->totalSum[window] -= windows->sum[window][slot];
+        windows->count[window][slot] = 0;
+        windows->sum[window][slot] = 0;
+    }
+    windows->headBucket[window] = bucket;
+}
+
+// Whether one more outflow of `amount` stays within every window's limits.
+// Call with the account's stripe lock held.
+bool velocityAllows(int accountIndex, time_t now, Money amount) {
+    VelocityWindows **slot = velocitySlot(accountIndex);
+    VelocityWindows *windows = slot != NULL ? *slot : NULL;
+    for (int w = 0; w < VELOCITY_WINDOWS; w++) {
+        int count = 0;
+        Money sum = 0;
+        if (windows != NULL) {
+            velocityAdvance(windows, w, now / (velocityWindowSeconds[w] / VELOCITY_BUCKETS));
+            count = windows->totalCount[w];
+            sum = windows->totalSum[w];
+        }
+        if (count >= velocityMaxCount[w] || amount > velocityMaxSum[w] - sum) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Adds an outflow to the windows it still falls in. Times may arrive out of
+// order (seeding); ones older than a whole window are ignored for that window.
+void velocityRecord(int accountIndex, time_t when, Money amount) {
+    VelocityWindows **slot = velocitySlot(accountIndex);
+    if (slot == NULL) {
+        return;
+    }
+    if (*slot == NULL) {
+        *slot = calloc(1, sizeof(VelocityWindows));
+        if (*slot == NULL) {
+            return;
+        }
+    }
+    
+    VelocityWindows *windows = *slot;
+    for (int w = 0; w < VELOCITY_WINDOWS; w++) {
+        long long bucket = when / (velocityWindowSeconds[w] / VELOCITY_BUCKETS);
+        velocityAdvance(windows, w, bucket);
+        if (bucket <= windows->headBucket[w] - VELOCITY_BUCKETS) {
+            continue;
+        }
+        int position = bucket % VELOCITY_BUCKETS;
+        windows->count[w][position]++;
+        windows->sum[w][position] += amount;
+        windows->totalCount[w]++;
+        windows->totalSum[w] += amount;
+    }
+}
+
+// Local service mode: answers ServiceRequest frames on a Unix domain socket
+// from a single epoll loop over the resident account store. Each round of the
+// loop handles every ready connection, then makes the journal durable with
+// one fdatasync before any response of that round is sent (group commit).
+int runService(const char *socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("Socket path is too long!\n");
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+    
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == -1) {
+        printf("Could not create the service socket!\n");
+        return 1;
+    }
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        chmod(socketPath, 0660) != 0 || // owner and group only
+        listen(listener, SERVICE_BACKLOG) != 0 ||
+        fcntl(listener, F_SETFL, O_NONBLOCK) != 0) {
+        printf("Could not listen on %s!\n", socketPath);
+        close(listener);
+        return 1;
+    }
+    
+    int epollFd = epoll_create1(0);
+    struct epoll_event listenEvent = { EPOLLIN, { .ptr = NULL } }; // NULL marks the listener
+    if (epollFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &listenEvent) != 0) {
+        printf("Could not start the event loop!\n");
+        close(listener);
+        unlink(socketPath);
+        return 1;
+    }
+    
+    // No SA_RESTART, so a signal wakes epoll_wait and the loop can exit cleanly
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = stopService;
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+    
+    printf("Serving %d accounts on %s\n", accountCount - tombstoneCount, socketPath);
+    fflush(stdout);
+    
+    struct epoll_event events[SERVICE_MAX_EVENTS];
+    ServiceConnection *touched[SERVICE_MAX_EVENTS];
+    while (!serviceStopping) {
+        int ready = epoll_wait(epollFd, events, SERVICE_MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Event loop failed!\n");
+            break;
+        }
+        
+        int touchedCount = 0;
+        for (int i = 0; i < ready; i++) {
+            ServiceConnection *connection = events[i].data.ptr;
+            if (connection == NULL) {
+                serviceAccept(listener, epollFd);
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !serviceRead(connection)) {
+                serviceClose(connection, epollFd);
+                continue;
+            }
+            serviceProcess(connection);
+            touched[touchedCount++] = connection;
+        }
+        
+        journalFlush(true);
+        if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+            saveData();
+        }
+        for (int i = 0; i < touchedCount; i++) {
+            if (serviceWrite(touched[i])) {
+                serviceWatch(touched[i], epollFd);
+            } else {
+                serviceClose(touched[i], epollFd);
+            }
+        }
+    }
+    
+    while (serviceConnections != NULL) {
+        serviceClose(serviceConnections, epollFd);
+    }
+    close(epollFd);
+    close(listener);
+    unlink(socketPath);
+    printf("Service stopped.\n");
+    return 0;
+}
+
+void stopService(int signalNumber) {
+    (void)signalNumber;
+    serviceStopping = 1;
+}
+
+void serviceAccept(int listener, int epollFd) {
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd == -1) {
+            return; // nothing left to accept, or a transient error epoll will report again
+        }
+        
+        ServiceConnection *connection = calloc(1, sizeof(ServiceConnection));
+        struct epoll_event event = { EPOLLIN, { .ptr = connection } };
+        if (connection == NULL ||
+            fcntl(fd, F_SETFL, O_NONBLOCK) != 0 ||
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        connection->next = serviceConnections;
+        if (serviceConnections != NULL) {
+            serviceConnections->previous = connection;
+        }
+        serviceConnections = connection;
+    }
+}
+
+// False once the peer has gone away
+bool serviceRead(ServiceConnection *connection) {
+    int space = SERVICE_BUFFER_SIZE - connection->inLength;
+    if (space == 0) {
+        return true; // waiting for output room; see serviceWatch
+    }
+    ssize_t received = read(connection->fd, connection->in + connection->inLength, space);
+    if (received > 0) {
+        connection->inLength += received;
+        return true;
+    }
+    return received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+// Answers the complete requests in the input buffer while the output buffer
+// has room for the responses; the rest waits for the next round
+void serviceProcess(ServiceConnection *connection) {
+    int offset = 0;
+    while (!connection->closing &&
+           connection->inLength - offset >= (int)sizeof(ServiceRequest) &&
+           SERVICE_BUFFER_SIZE - connection->outLength >= (int)sizeof(ServiceResponse)) {
+        ServiceRequest request;
+        memcpy(&request, connection->in + offset, sizeof(request));
+        
+        ServiceResponse response;
+        if (request.length > SERVICE_MAX_PAYLOAD ||
+            (request.length > 0 && request.operation != SERVICE_CREATE)) {
+            // The framing can no longer be trusted: answer, then hang up
+            memset(&response, 0, sizeof(response));
+            response.requestId = request.requestId;
+            response.status = SERVICE_BAD_REQUEST;
+            connection->closing = true;
+        } else if (connection->inLength - offset < (int)sizeof(request) + request.length) {
+            break; // payload still on its way
+        } else {
+            serviceHandle(&request, connection->in + offset + sizeof(request), &response);
+        }
+        memcpy(connection->out + connection->outLength, &response, sizeof(response));
+        connection->outLength += sizeof(response);
+        offset += sizeof(request) + request.length;
+    }
+    
+    if (connection->closing) {
+        connection->inLength = 0;
+    } else {
+        memmove(connection->in, connection->in + offset, connection->inLength - offset);
+        connection->inLength -= offset;
+    }
+}
+
+void serviceHandle(const ServiceRequest *request, const unsigned char *payload, ServiceResponse *response) {
+    memset(response, 0, sizeof(*response));
+    response->requestId = request->requestId;
+    response->accountNumber = request->accountNumber;
+    
+    if (request->operation < SERVICE_CREATE || request->operation > SERVICE_BALANCE) {
+        response->status = SERVICE_BAD_REQUEST;
+        return;
+    }
+    if (request->operation == SERVICE_CREATE) {
+        response->accountNumber = 0;
+        response->status = serviceCreate(request, payload, &response->accountNumber);
+        if (response->status != TX_OK) {
+            return;
+        }
+    }
+    int index = findAccountByNumber(response->accountNumber);
+    if (index == -1) {
+        response->status = SERVICE_UNKNOWN_ACCOUNT;
+        return;
+    }
+    
+    switch (request->operation) {
+        case SERVICE_DEPOSIT:
+            response->status = applyDeposit(index, request->amount);
+            break;
+        case SERVICE_WITHDRAW:
+            response->status = applyWithdrawal(index, request->amount);
+            break;
+        case SERVICE_TRANSFER: {
+            int target = findAccountByNumber(request->targetNumber);
+            response->status = target == -1 ? SERVICE_UNKNOWN_ACCOUNT
+                                             : applyTransfer(index, target, request->amount);
+            break;
+        }
+    }
+    response->balance = *balanceAt(index);
+}
+
+int serviceCreate(const ServiceRequest *request, const unsigned char *payload, int *accountNumber) {
+    Account account;
+    if (!parseServiceProfile(payload, request->length, &account)) {
+        return SERVICE_BAD_REQUEST;
+    }
+    if (request->amount < 0) {
+        return TX_INVALID_AMOUNT;
+    }
+    
+    account.accountNumber = allocateAccountNumber();
+    if (account.accountNumber == -1) {
+        return SERVICE_FAILED;
+    }
+    account.balance = request->amount;
+    account.lastTransaction = time(NULL);
+    if (addAccount(&account) == -1) {
+        return SERVICE_FAILED;
+    }
+    *accountNumber = account.accountNumber;
+    return TX_OK;
+}
 
-// Function prototypes
-void loadData();
-void saveData();
-int authenticateAdmin();
-void mainMenu();
-void adminMenu();
-void customerMenu(int accountIndex);
-void createAccount();
-void displayAllAccounts();
-void searchAccount();
-void deposit(int accountIndex);
-void withdraw(int accountIndex);
-void transfer(int accountIndex);
-void viewBalance(int accountIndex);
-void viewTransactionHistory(int accountIndex);
-void deleteAccount();
-void modifyAccount();
-int findAccountByNumber(int accountNumber);
-void clearInputBuffer();
-void printAccountDetails(int index);
-void printWelcomeArt();
+// Exactly four NUL-terminated fields, each short enough for its Account field
+bool parseServiceProfile(const unsigned char *payload, int length, Account *account) {
+    memset(account, 0, sizeof(*account));
+    char *fields[] = { account->name, account->address, account->phone, account->accountType };
+    size_t sizes[] = { sizeof(account->name), sizeof(account->address),
+                       sizeof(account->phone), sizeof(account->accountType) };
+    
+    int offset = 0;
+    for (int i = 0; i < 4; i++) {
+        const unsigned char *end = memchr(payload + offset, '\0', length - offset);
+        if (end == NULL || (size_t)(end - (payload + offset)) >= sizes[i]) {
+            return false;
+        }
+        size_t fieldLength = end - (payload + offset);
+        memcpy(fields[i], payload + offset, fieldLength + 1);
+        offset += fieldLength + 1;
+    }
+    return offset == length;
+}
 
-int main() {
-    loadData();
-    printWelcomeArt();
+// False when the connection should be closed
+bool serviceWrite(ServiceConnection *connection) {
+    if (connection->outLength > 0) {
+        ssize_t sent = send(connection->fd, connection->out, connection->outLength, MSG_NOSIGNAL);
+        if (sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+        if (sent > 0) {
+            memmove(connection->out, connection->out + sent, connection->outLength - sent);
+            connection->outLength -= sent;
+        }
+    }
+    return !(connection->closing && connection->outLength == 0);
+}
+
+// Reads only while there is input room and waits for writability only while
+// output is pending, so a slow reader throttles its own requests. Requests
+// held back by a full output buffer also wait for writability, which brings
+// the connection round again to answer them.
+void serviceWatch(ServiceConnection *connection, int epollFd) {
+    bool requestWaiting = false;
+    if (connection->inLength >= (int)sizeof(ServiceRequest)) {
+        ServiceRequest next;
+        memcpy(&next, connection->in, sizeof(next));
+        requestWaiting = connection->inLength >= (int)sizeof(next) + next.length;
+    }
     
-    if (authenticateAdmin()) {
-        mainMenu();
+    unsigned int events = 0;
+    if (connection->inLength < SERVICE_BUFFER_SIZE && !connection->closing) {
+        events |= EPOLLIN;
+    }
+    if (connection->outLength > 0 || requestWaiting) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection->events) {
+        struct epoll_event event = { events, { .ptr = connection } };
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+void serviceClose(ServiceConnection *connection, int epollFd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    if (connection->previous != NULL) {
+        connection->previous->next = connection->next;
     } else {
-        printf("Authentication failed. Exiting...\n");
+        serviceConnections = connection->next;
+    }
+    if (connection->next != NULL) {
+        connection->next->previous = connection->previous;
+    }
+    free(connection);
+}
+
+// Month-end job: credits one month of interest at the given annual rate to
+// every savings account with a positive balance. Each credit is journaled
+// like a deposit and the run's progress is checkpointed with the accounts,
+// so after a crash the same command resumes where the run stopped (at the
+// interrupted run's rate) instead of crediting anyone twice.
+int runInterestAccrual(const char *rateText) {
+    long long rate;
+    if (!parseInterestRate(rateText, &rate)) {
+        printf("Interest rate must be between 0.01 and 100.00 percent!\n");
+        return 1;
+    }
+    
+    if (accrualMonth != 0) {
+        char text[MONEY_TEXT_SIZE];
+        printf("Resuming the interrupted interest run for %04d-%02d at %s%%.\n",
+               accrualMonth / 100, accrualMonth % 100, formatMoney(accrualRate, text));
+        rate = accrualRate;
+    } else {
+        time_t now = time(NULL);
+        struct tm *local = localtime(&now);
+        int month = (local->tm_year + 1900) * 100 + local->tm_mon + 1;
+        if (month == lastAccrualMonth) {
+            printf("Interest has already been accrued for %04d-%02d!\n", month / 100, month % 100);
+            return 1;
+        }
+        
+        // Checkpoint first so any compaction happens now and not under the
+        // sweep, which walks accounts by position; then record the run before
+        // the first credit
+        saveData();
+        accrualMonth = month;
+        accrualNext = 0;
+        accrualRate = rate;
+        saveData();
+    }
+    journalSyncInterval = BATCH_SYNC_INTERVAL;
+    
+    AccrualStats stats;
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    accrueInterest(rate, accrualNext, &stats, true);
+    journalFlush(true);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    journalSyncInterval = JOURNAL_SYNC_INTERVAL;
+    lastAccrualMonth = accrualMonth;
+    accrualMonth = 0;
+    accrualNext = 0;
+    accrualRate = 0;
+    
+    printAccrualSummary(&stats, rate, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    return 0;
+}
+
+// Times the sweep on a synthetic in-memory account set, journal and ledger
+// detached like the transfer stress test
+int runInterestBenchmark(long long accounts) {
+    if (accounts < 1 || accounts > INT_MAX - FIRST_ACCOUNT_NUMBER) {
+        printf("Account count must be between 1 and %d!\n", INT_MAX - FIRST_ACCOUNT_NUMBER);
+        return 1;
+    }
+    
+    initAccountLocks();
+    if (!reserveAccountSlots((int)accounts)) {
+        printf("Out of memory!\n");
+        freeAccountStore();
+        return 1;
+    }
+    Money expectedTotal = 0;
+    Account account;
+    memset(&account, 0, sizeof(account));
+    for (int i = 0; i < accounts; i++) {
+        account.accountNumber = FIRST_ACCOUNT_NUMBER + i;
+        account.balance = 10000 + (Money)(i % 1000) * 1234;
+        strcpy(account.accountType, i % 4 == 0 ? "current" : "savings");
+        storeAccount(appendAccount(), &account);
+        expectedTotal += account.balance;
+    }
+    
+    long long rate = 450; // 4.50% a year
+    AccrualStats stats;
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    accrueInterest(rate, 0, &stats, false);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    Money total = 0;
+    for (int i = 0; i < accountCount; i++) {
+        total += *balanceAt(i);
+    }
+    expectedTotal += stats.totalInterest;
+    
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("\n===== INTEREST ACCRUAL BENCHMARK =====\n");
+    printf("Accounts: %d\n", accountCount);
+    printAccrualSummary(&stats, rate, seconds);
+    printf("Accounts/s: %.0f\n", seconds > 0 ? accountCount / seconds : 0.0);
+    printf("Balances: %s\n", total == expectedTotal ? "OK" : "MISMATCH");
+    
+    freeAccountStore();
+    return 0;
+}
+
+// Machine-readable timings of the account store on synthetic account sets:
+// one CSV row per operation and size. Runs in a scratch directory under the
+// current one so existing data files are never touched.
+int runBenchmarks(int count, char **sizes) {
+    static const int defaultSizes[] = { 1000, 10000, 100000, 1000000 };
+    int accountSets[16];
+    int setCount = 0;
+    if (count == 0) {
+        setCount = sizeof(defaultSizes) / sizeof(defaultSizes[0]);
+        memcpy(accountSets, defaultSizes, sizeof(defaultSizes));
+    }
+    for (int i = 0; i < count; i++) {
+        long long accounts = atoll(sizes[i]);
+        if (setCount == (int)(sizeof(accountSets) / sizeof(accountSets[0])) ||
+            accounts < 1 || accounts > BENCH_MAX_ACCOUNTS) {
+            printf("Give up to 16 account counts between 1 and %d!\n", BENCH_MAX_ACCOUNTS);
+            return 1;
+        }
+        accountSets[setCount++] = (int)accounts;
+    }
+    
+    char scratch[] = "bank_bench.XXXXXX";
+    if (mkdtemp(scratch) == NULL || chdir(scratch) != 0) {
+        printf("Could not create a scratch directory!\n");
+        return 1;
+    }
+    
+    journalSyncInterval = BATCH_SYNC_INTERVAL;
+    printf("benchmark,accounts,operations,seconds,ns_per_op,ops_per_sec\n");
+    int status = 0;
+    for (int i = 0; i < setCount && status == 0; i++) {
+        status = benchAccountSet(accountSets[i]) ? 0 : 1;
+        closeJournal();
+        closeLedger();
+        freeAccountStore();
+        clearScratchDirectory();
+    }
+    journalSyncInterval = JOURNAL_SYNC_INTERVAL;
+    
+    if (chdir("..") != 0 || rmdir(scratch) != 0) {
+        printf("Could not remove %s!\n", scratch);
+    }
+    return status;
+}
+
+bool benchAccountSet(int accounts) {
+    struct timespec start;
+    struct timespec end;
+    
+    loadData(); // empty directory: fresh journal and ledger
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!reserveAccountSlots(accounts)) {
+        printf("Out of memory!\n");
+        return false;
     }
+    Account account;
+    memset(&account, 0, sizeof(account));
+    for (int i = 0; i < accounts; i++) {
+        account.accountNumber = FIRST_ACCOUNT_NUMBER + i;
+        snprintf(account.name, sizeof(account.name), "Customer %d", i);
+        snprintf(account.address, sizeof(account.address), "%d Market Street", i % 10000);
+        snprintf(account.phone, sizeof(account.phone), "555%07d", i);
+        strcpy(account.accountType, i % 4 == 0 ? "current" : "savings");
+        account.balance = 10000 + (Money)(i % 1000) * 1234;
+        storeAccount(appendAccount(), &account);
+    }
+    rebuildAccountIndex();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("generate", accounts, accounts, &start, &end);
+    
+    snapshotRewriteNeeded = true;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    saveData();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("save", accounts, accounts, &start, &end);
+    
+    closeJournal();
+    closeLedger();
+    freeAccountStore();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    loadData();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("load", accounts, accounts, &start, &end);
+    if (accountCount != accounts) {
+        printf("Loaded %d of %d accounts!\n", accountCount, accounts);
+        return false;
+    }
+    
+    // xorshift32, as in the stress test: cheap and the same sequence every run
+    unsigned int state = 2463534242u;
+    int found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        found += findAccountByNumber(FIRST_ACCOUNT_NUMBER + state % accounts) != -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("find_hit", accounts, BENCH_OPERATIONS, &start, &end);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        found += findAccountByNumber(FIRST_ACCOUNT_NUMBER + accounts + state % accounts) != -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("find_miss", accounts, BENCH_OPERATIONS, &start, &end);
+    if (found != BENCH_OPERATIONS) {
+        printf("Lookups found %d accounts, expected %d!\n", found, BENCH_OPERATIONS);
+        return false;
+    }
+    
+    // Applied the way a batch file is: fsync in batches, checkpoint on schedule
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        applyDeposit(state % accounts, 100 + (state >> 20));
+        if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+            saveData();
+        }
+    }
+    journalFlush(true);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("deposit", accounts, BENCH_OPERATIONS, &start, &end);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        applyTransfer(state % accounts, (state >> 8) % accounts, (1 + (state >> 24) % 50) * 100);
+        if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+            saveData();
+        }
+    }
+    journalFlush(true);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("transfer", accounts, BENCH_OPERATIONS, &start, &end);
+    
+    // Every row rendered as the account list would, written to /dev/null
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (savedStdout == -1 || devNull == -1) {
+        printf("Could not open /dev/null!\n");
+        return false;
+    }
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    printAccountTableHeader();
+    for (int i = 0; i < accountCount; i++) {
+        if (!isTombstone(i)) {
+            tableAccountRow(i);
+        }
+    }
+    tableFlush(&tableOut);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    benchReport("list", accounts, accounts, &start, &end);
+    
+    // Every tenth account, leaving the tombstones for the checkpoint below
+    int deletes = accounts >= 10 ? accounts / 10 : 1;
+    int stride = accounts / deletes;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < deletes; i++) {
+        int index = findAccountByNumber(FIRST_ACCOUNT_NUMBER + i * stride);
+        if (index != -1) {
+            removeAccount(index);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("delete", accounts, deletes, &start, &end);
     
+    clock_gettime(CLOCK_MONOTONIC, &start);
     saveData();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    benchReport("checkpoint", accounts, 1, &start, &end);
+    if (accountCount - tombstoneCount != accounts - deletes) {
+        printf("%d accounts left, expected %d!\n", accountCount - tombstoneCount, accounts - deletes);
+        return false;
+    }
+    return true;
+}
+
+void benchReport(const char *name, int accounts, long long operations,
+                 const struct timespec *start, const struct timespec *end) {
+    double seconds = (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+    printf("%s,%d,%lld,%.6f,%.1f,%.0f\n", name, accounts, operations, seconds,
+           seconds * 1e9 / operations, seconds > 0 ? operations / seconds : 0.0);
+    fflush(stdout);
+}
+
+// Removes the data files a benchmark run left in the scratch directory
+void clearScratchDirectory() {
+    DIR *directory = opendir(".");
+    if (directory == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            unlink(entry->d_name);
+        }
+    }
+    closedir(directory);
+}
+
+// Annual rate in percent with up to two decimals, returned in hundredths of a percent
+bool parseInterestRate(const char *text, long long *rate) {
+    Money value;
+    if (!parseMoney(text, &value) || value <= 0 || value > MAX_INTEREST_RATE) {
+        return false;
+    }
+    *rate = value;
+    return true;
+}
+
+// Sweeps the store from position `from` one chunk at a time, reading only
+// the hot columns: the balances of eligible accounts are masked into a
+// contiguous column, the interest for the whole column is computed in one
+// pass, and only the non-zero results are posted. With checkpoints, the
+// run's progress is saved along with the accounts.
+void accrueInterest(long long rate, int from, AccrualStats *stats, bool checkpoints) {
+    static Money balances[ACCOUNT_CHUNK_SIZE];
+    static Money interest[ACCOUNT_CHUNK_SIZE];
+    Money largestBalance = (LLONG_MAX - 60000) / rate; // keeps balance * rate from overflowing
+    time_t now = time(NULL);
+    memset(stats, 0, sizeof(*stats));
+    
+    for (int first = from; first < accountCount; ) {
+        int offset = first & (ACCOUNT_CHUNK_SIZE - 1);
+        int run = ACCOUNT_CHUNK_SIZE - offset;
+        if (run > accountCount - first) {
+            run = accountCount - first;
+        }
+        const AccountColumns *columns = columnChunks[first >> ACCOUNT_CHUNK_SHIFT];
+        
+        for (int i = 0; i < run; i++) {
+            balances[i] = 0;
+            if (columns->kind[offset + i] != ACCOUNT_SAVINGS || columns->accountNumber[offset + i] <= 0) {
+                continue;
+            }
+            stats->savingsAccounts++;
+            if (columns->balance[offset + i] > largestBalance) {
+                stats->overflowed++;
+            } else if (columns->balance[offset + i] > 0) {
+                balances[i] = columns->balance[offset + i];
+            }
+        }
+        
+        computeMonthlyInterest(balances, interest, run, rate);
+        
+        for (int i = 0; i < run; i++) {
+            if (interest[i] == 0) {
+                continue;
+            }
+            int index = first + i;
+            lockAccounts(index, -1);
+            Money *balance = balanceAt(index);
+            if (!moneyAdd(*balance, interest[i], balance)) {
+                unlockAccounts(index, -1);
+                stats->overflowed++;
+                continue;
+            }
+            *lastTransactionAt(index) = now;
+            journalAppend(TX_INTEREST, index, -1, interest[i]);
+            unlockAccounts(index, -1);
+            stats->credited++;
+            stats->totalInterest += interest[i];
+        }
+        first += run;
+        
+        if (checkpoints) {
+            accrualNext = first;
+            if (journalSinceCheckpoint >= CHECKPOINT_INTERVAL) {
+                saveData();
+            }
+        }
+    }
+}
+
+// One month at `rate` hundredths of a percent a year, rounded half up to the
+// cent. Branch-free over a plain array so the compiler can unroll and
+// vectorize it; callers make sure balance * rate fits.
+void computeMonthlyInterest(const Money *balances, Money *interest, int count, long long rate) {
+    for (int i = 0; i < count; i++) {
+        interest[i] = (balances[i] * rate + 60000) / 120000;
+    }
+}
+
+void printAccrualSummary(const AccrualStats *stats, long long rate, double seconds) {
+    char amount[MONEY_TEXT_SIZE];
+    printf("\n===== INTEREST ACCRUAL =====\n");
+    printf("Annual rate: %s%%\n", formatMoney(rate, amount));
+    printf("Savings accounts: %lld\n", stats->savingsAccounts);
+    printf("Accounts credited: %lld\n", stats->credited);
+    printf("Skipped (balance overflow): %lld\n", stats->overflowed);
+    printf("Total interest: $%s\n", formatMoney(stats->totalInterest, amount));
+    printf("Elapsed: %.3f s\n", seconds);
+}
+
+// Aggregate report: balances by account type, a balance histogram and the top
+// accounts by balance and by ledger activity. One pass over the hot columns,
+// split by chunk across threads that each keep partial aggregates and their
+// own top-N heaps; the partials are merged at the end.
+int runReport(int top) {
+    if (top < 1 || top > REPORT_MAX_TOP) {
+        printf("Top account count must be between 1 and %d!\n", REPORT_MAX_TOP);
+        return 1;
+    }
+    
+    struct timespec start;
+    struct timespec counted;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int *activity = countLedgerActivity();
+    if (activity == NULL) {
+        printf("Out of memory!\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &counted);
+    
+    int chunks = (accountCount + ACCOUNT_CHUNK_SIZE - 1) / ACCOUNT_CHUNK_SIZE;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > REPORT_MAX_THREADS) {
+        threads = REPORT_MAX_THREADS;
+    }
+    if (threads > chunks) {
+        threads = chunks;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    
+    ReportPartial *partials = calloc(threads, sizeof(ReportPartial));
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    if (partials == NULL || ids == NULL) {
+        printf("Out of memory!\n");
+        free(partials);
+        free(ids);
+        free(activity);
+        return 1;
+    }
+    for (int t = 0; t < threads; t++) {
+        partials[t].firstChunk = (int)((long long)chunks * t / threads);
+        partials[t].endChunk = (int)((long long)chunks * (t + 1) / threads);
+        partials[t].activity = activity;
+        partials[t].top = top;
+        pthread_create(&ids[t], NULL, reportWorker, &partials[t]);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    
+    // Fold everything into the first partial
+    ReportPartial *total = &partials[0];
+    for (int t = 1; t < threads; t++) {
+        const ReportPartial *part = &partials[t];
+        for (int k = 0; k < ACCOUNT_KINDS; k++) {
+            total->accounts[k] += part->accounts[k];
+            if (!moneyAdd(total->balances[k], part->balances[k], &total->balances[k])) {
+                total->overflowed = true;
+            }
+        }
+        total->overflowed = total->overflowed || part->overflowed;
+        for (int b = 0; b < REPORT_BUCKETS; b++) {
+            total->histogram[b] += part->histogram[b];
+        }
+        for (int i = 0; i < part->richestCount; i++) {
+            heapOffer(total->richest, &total->richestCount, top, part->richest[i].key, part->richest[i].index);
+        }
+        for (int i = 0; i < part->busiestCount; i++) {
+            heapOffer(total->busiest, &total->busiestCount, top, part->busiest[i].key, part->busiest[i].index);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    static const char *kindNames[] = { "Other", "Savings", "Current" };
+    static const char *bucketNames[] = { "$0 or less", "under $10", "$10 - $100", "$100 - $1K",
+                                         "$1K - $10K", "$10K - $100K", "$100K - $1M", "$1M and more" };
+    char amount[MONEY_TEXT_SIZE];
+    char text[MONEY_TEXT_SIZE + 1];
+    long long accounts = 0;
+    Money balances = 0;
+    
+    printf("\n===== BANK REPORT =====\n");
+    printf("%-10s %12s %22s\n", "Type", "Accounts", "Total Balance");
+    for (int k = 0; k < ACCOUNT_KINDS; k++) {
+        snprintf(text, sizeof(text), "$%s", formatMoney(total->balances[k], amount));
+        printf("%-10s %12lld %22s\n", kindNames[k], total->accounts[k], text);
+        accounts += total->accounts[k];
+        if (!moneyAdd(balances, total->balances[k], &balances)) {
+            total->overflowed = true;
+        }
+    }
+    snprintf(text, sizeof(text), "$%s", formatMoney(balances, amount));
+    printf("%-10s %12lld %22s\n", "All", accounts, text);
+    if (total->overflowed) {
+        printf("Warning: a total overflowed and is incomplete!\n");
+    }
+    
+    printf("\nBalance distribution:\n");
+    for (int b = 0; b < REPORT_BUCKETS; b++) {
+        int width = accounts > 0 ? (int)(total->histogram[b] * 40 / accounts) : 0;
+        printf("%-14s %12lld |%.*s\n", bucketNames[b], total->histogram[b], width,
+               "########################################");
+    }
+    
+    printTopAccounts("Richest accounts", total->richest, total->richestCount, true);
+    printTopAccounts("Most active accounts (ledger entries)", total->busiest, total->busiestCount, false);
+    
+    double countMs = (counted.tv_sec - start.tv_sec) * 1e3 + (counted.tv_nsec - start.tv_nsec) / 1e6;
+    double scanMs = (end.tv_sec - counted.tv_sec) * 1e3 + (end.tv_nsec - counted.tv_nsec) / 1e6;
+    printf("\nLedger activity counted in %.1f ms, %d accounts scanned in %.1f ms on %d thread(s)\n",
+           countMs, accountCount, scanMs, threads);
+    
+    free(partials);
+    free(ids);
+    free(activity);
     return 0;
 }
 
-void printWelcomeArt() {
-    printf("\n");
-    printf("  ____              _        _   _           _\n");
-    printf(" |  _ \\            | |      | | | |         | |\n");
-    printf(" | |_) | __ _ _ __ | | __   | |_| | __ _ ___| |__\n");
-    printf(" |  _ < / _` | '_ \\| |/ /   |  _  |/ _` / __| '_ \\\n");
-    printf(" | |_) | (_| | | | |   <    | | | | (_| \\__ \\ | | |\n");
-    printf(" |____/ \\__,_|_| |_|_|\\_\\   \\_| |_/\\__,_|___/_| |_|\n");
-    printf("\n");
+// Ledger rows per account position, read from the per-account index of each
+// segment (the row columns themselves are not touched) plus the in-memory tail
+int *countLedgerActivity() {
+    int *activity = calloc(accountCount > 0 ? accountCount : 1, sizeof(int));
+    if (activity == NULL) {
+        return NULL;
+    }
+    
+    for (int s = 0; s < ledgerSegmentCount; s++) {
+        const LedgerSegment *segment = &ledgerSegments[s];
+        size_t bytes = (size_t)segment->accountCount * sizeof(LedgerIndexEntry);
+        LedgerIndexEntry *entries = malloc(bytes > 0 ? bytes : 1);
+        if (entries == NULL) {
+            free(activity);
+            return NULL;
+        }
+        if (pread(ledgerFd, entries, bytes, segment->offset + sizeof(LedgerSegmentHeader)) == (ssize_t)bytes) {
+            for (int i = 0; i < segment->accountCount; i++) {
+                int index = findAccountByNumber(entries[i].accountNumber);
+                if (index != -1) {
+                    activity[index] += entries[i].rowCount;
+                }
+            }
+        }
+        free(entries);
+    }
+    
+    for (int i = 0; i < ledgerTailCount; i++) {
+        int index = findAccountByNumber(ledgerTail[i].accountNumber);
+        if (index != -1) {
+            activity[index]++;
+        }
+    }
+    return activity;
 }
 
-void loadData() {
-    FILE *file = fopen(FILENAME, "rb");
-    if (file != NULL) {
-        accountCount = fread(accounts, sizeof(Account), MAX_ACCOUNTS, file);
-        fclose(file);
+void *reportWorker(void *arg) {
+    ReportPartial *part = arg;
+    
+    for (int c = part->firstChunk; c < part->endChunk; c++) {
+        const AccountColumns *columns = columnChunks[c];
+        int first = c * ACCOUNT_CHUNK_SIZE;
+        int run = accountCount - first < ACCOUNT_CHUNK_SIZE ? accountCount - first : ACCOUNT_CHUNK_SIZE;
+        
+        for (int i = 0; i < run; i++) {
+            if (columns->accountNumber[i] <= 0) {
+                continue; // tombstone
+            }
+            Money balance = columns->balance[i];
+            int kind = columns->kind[i] < ACCOUNT_KINDS ? columns->kind[i] : ACCOUNT_OTHER;
+            part->accounts[kind]++;
+            if (!moneyAdd(part->balances[kind], balance, &part->balances[kind])) {
+                part->overflowed = true;
+            }
+            
+            int bucket = 0;
+            if (balance > 0) {
+                bucket = 1;
+                for (Money limit = 1000; balance >= limit && bucket < REPORT_BUCKETS - 1; limit *= 10) {
+                    bucket++;
+                }
+            }
+            part->histogram[bucket]++;
+            
+            // Most accounts lose against the heap root, so check before calling
+            if (part->richestCount < part->top || balance > part->richest[0].key) {
+                heapOffer(part->richest, &part->richestCount, part->top, balance, first + i);
+            }
+            int rows = part->activity[first + i];
+            if (rows > 0 && (part->busiestCount < part->top || rows > part->busiest[0].key)) {
+                heapOffer(part->busiest, &part->busiestCount, part->top, rows, first + i);
+            }
+        }
     }
+    return NULL;
 }
 
-void saveData() {
-    FILE *file = fopen(FILENAME, "wb");
-    if (file != NULL) {
-        fwrite(accounts, sizeof(Account), accountCount, file);
-        fclose(file);
+// Min-heap on key holding at most `capacity` entries: the root is the weakest
+// of the current top N and is replaced when a larger key arrives
+void heapOffer(TopEntry *heap, int *count, int capacity, long long key, int index) {
+    int position;
+    if (*count < capacity) {
+        position = (*count)++;
+        while (position > 0 && heap[(position - 1) / 2].key > key) {
+            heap[position] = heap[(position - 1) / 2];
+            position = (position - 1) / 2;
+        }
+    } else if (key > heap[0].key) {
+        position = 0;
+        for (;;) {
+            int child = position * 2 + 1;
+            if (child >= *count) {
+                break;
+            }
+            if (child + 1 < *count && heap[child + 1].key < heap[child].key) {
+                child++;
+            }
+            if (heap[child].key >= key) {
+                break;
+            }
+            heap[position] = heap[child];
+            position = child;
+        }
+    } else {
+        return;
+    }
+    heap[position].key = key;
+    heap[position].index = index;
+}
+
+// Largest key first
+int compareTopEntries(const void *a, const void *b) {
+    const TopEntry *left = a;
+    const TopEntry *right = b;
+    if (left->key != right->key) {
+        return left->key > right->key ? -1 : 1;
+    }
+    return 0;
+}
+
+void printTopAccounts(const char *title, TopEntry *entries, int count, bool money) {
+    printf("\n%s:\n", title);
+    if (count == 0) {
+        printf("None.\n");
+        return;
+    }
+    qsort(entries, count, sizeof(TopEntry), compareTopEntries);
+    char amount[MONEY_TEXT_SIZE];
+    for (int i = 0; i < count; i++) {
+        int index = entries[i].index;
+        printf("%3d. %-12d %-20s ", i + 1, *accountNumberAt(index), profileAt(index)->name);
+        if (money) {
+            printf("$%s\n", formatMoney(entries[i].key, amount));
+        } else {
+            printf("%lld\n", entries[i].key);
+        }
     }
 }
 
@@ -151,7 +4246,9 @@ void adminMenu() {
         printf("3. Search Account\n");
         printf("4. Modify Account\n");
         printf("5. Delete Account\n");
-        printf("6. Back to Main Menu\n");
+        printf("6. Reports\n");
+        printf("7. Audit Trail\n");
+        printf("8. Back to Main Menu\n");
         printf("======================\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
@@ -163,14 +4260,16 @@ void adminMenu() {
             case 3: searchAccount(); break;
             case 4: modifyAccount(); break;
             case 5: deleteAccount(); break;
-            case 6: printf("Returning to main menu...\n"); break;
+            case 6: runReport(REPORT_DEFAULT_TOP); break;
+            case 7: viewAuditTrail(); break;
+            case 8: printf("Returning to main menu...\n"); break;
             default: printf("Invalid choice. Please try again.\n");
         }
-    } while(choice != 6);
+    } while(choice != 8);
 }
 
 void customerMenu(int accountIndex) {
-    printf("\nWelcome, %s!\n", accounts[accountIndex].name);
+    printf("\nWelcome, %s!\n", profileAt(accountIndex)->name);
     
     int choice;
     do {
@@ -199,15 +4298,13 @@ void customerMenu(int accountIndex) {
 }
 
 void createAccount() {
-    if (accountCount >= MAX_ACCOUNTS) {
-        printf("Maximum number of accounts reached!\n");
-        return;
-    }
-    
     Account newAccount;
     
-    // Generate account number (1000 + current count)
-    newAccount.accountNumber = 1000 + accountCount;
+    newAccount.accountNumber = allocateAccountNumber();
+    if (newAccount.accountNumber == -1) {
+        printf("Could not reserve an account number, account not created!\n");
+        return;
+    }
     
     printf("\nEnter account details:\n");
     
@@ -224,8 +4321,10 @@ void createAccount() {
     newAccount.phone[strcspn(newAccount.phone, "\n")] = '\0';
     
     printf("Initial Deposit: ");
-    scanf("%lf", &newAccount.balance);
-    clearInputBuffer();
+    if (!readMoney(&newAccount.balance) || newAccount.balance < 0) {
+        printf("Invalid amount, account not created!\n");
+        return;
+    }
     
     printf("Account Type (savings/current): ");
     fgets(newAccount.accountType, sizeof(newAccount.accountType), stdin);
@@ -234,30 +4333,108 @@ void createAccount() {
     // Set last transaction time to now
     newAccount.lastTransaction = time(NULL);
     
-    accounts[accountCount++] = newAccount;
+    if (addAccount(&newAccount) == -1) {
+        printf("Out of memory, account not created!\n");
+        return;
+    }
+    journalCommit();
     
     printf("\nAccount created successfully!\n");
     printf("Account Number: %d\n", newAccount.accountNumber);
 }
 
+// Stores a fully filled-in account under its already allocated number and
+// journals it; returns its position, or -1 when out of memory
+int addAccount(const Account *account) {
+    int position = insertAccount(account);
+    if (position == -1) {
+        return -1;
+    }
+    auditAppend(AUDIT_OPENED, account->accountNumber, NULL, profileAt(position));
+    journalAppendOpen(position);
+    return position;
+}
+
+// Puts an account into a free slot and the indexes; returns its position, or
+// -1 when out of memory
+int insertAccount(const Account *account) {
+    int position = allocateAccountSlot();
+    if (position == -1) {
+        return -1;
+    }
+    storeAccount(position, account);
+    indexInsert(account->accountNumber, position);
+    indexProfile(position);
+    return position;
+}
+
+// Takes an account out of every index and frees its slot; the caller checkpoints
+void removeAccount(int index) {
+    int accountNumber = *accountNumberAt(index);
+    auditAppend(AUDIT_CLOSED, accountNumber, profileAt(index), NULL);
+    indexRemove(accountNumber);
+    unindexProfile(index);
+    releaseAccountSlot(index);
+}
+
 void displayAllAccounts() {
     printf("\n===== ALL ACCOUNTS =====\n");
+    printAccountTableHeader();
+    
+    // Rows are formatted a page at a time, so only what is shown gets rendered
+    int total = accountCount - tombstoneCount;
+    int shown = 0;
+    for (int i = 0; i < accountCount; i++) {
+        if (isTombstone(i)) {
+            continue;
+        }
+        if (shown > 0 && shown % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(shown, total)) {
+                return;
+            }
+        }
+        tableAccountRow(i);
+        shown++;
+    }
+    tableFlush(&tableOut);
+}
+
+void printAccountTableHeader() {
     printf("%-15s %-20s %-15s %-10s %-15s %s\n", 
            "Account No.", "Name", "Phone", "Type", "Balance", "Last Transaction");
     printf("--------------------------------------------------------------------------------\n");
+}
+
+void tableAccountRow(int index) {
+    tableInt(&tableOut, *accountNumberAt(index), 15);
+    tableText(&tableOut, profileAt(index)->name, 20);
+    tableText(&tableOut, profileAt(index)->phone, 15);
+    tableText(&tableOut, profileAt(index)->accountType, 10);
+    tableMoney(&tableOut, *balanceAt(index), 15);
+    tableDate(&tableOut, *lastTransactionAt(index));
+    tableEndRow(&tableOut);
+}
+
+void searchAccount() {
+    int choice = 0;
+    printf("\nSearch by:\n");
+    printf("1. Account Number\n");
+    printf("2. Name (or its beginning)\n");
+    printf("3. Phone Number\n");
+    printf("Enter your choice: ");
+    scanf("%d", &choice);
+    clearInputBuffer();
     
-    for (int i = 0; i < accountCount; i++) {
-        printf("%-15d %-20s %-15s %-10s $%-14.2f %s", 
-               accounts[i].accountNumber,
-               accounts[i].name,
-               accounts[i].phone,
-               accounts[i].accountType,
-               accounts[i].balance,
-               ctime(&accounts[i].lastTransaction));
+    switch(choice) {
+        case 1: searchByNumber(); break;
+        case 2: searchByName(); break;
+        case 3: searchByPhone(); break;
+        default: printf("Invalid choice.\n");
     }
 }
 
-void searchAccount() {
+void searchByNumber() {
     int accNumber;
     printf("\nEnter account number to search: ");
     scanf("%d", &accNumber);
@@ -271,48 +4448,122 @@ void searchAccount() {
     }
 }
 
+// Case-insensitive prefix match: "jo" finds "John Smith" and "joanna"
+void searchByName() {
+    char prefix[100];
+    printf("\nEnter name or the beginning of it: ");
+    fgets(prefix, sizeof(prefix), stdin);
+    prefix[strcspn(prefix, "\n")] = '\0';
+    if (prefix[0] == '\0') {
+        printf("Please enter at least one character.\n");
+        return;
+    }
+    
+    buildSecondaryIndexes();
+    int first = namePrefixBound(prefix, false);
+    int end = namePrefixBound(prefix, true);
+    if (first == end) {
+        printf("No accounts found!\n");
+        return;
+    }
+    
+    printf("\n%d account(s) found:\n", end - first);
+    printAccountTableHeader();
+    for (int i = first; i < end; i++) {
+        if (i > first && (i - first) % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(i - first, end - first)) {
+                return;
+            }
+        }
+        tableAccountRow(nameIndex[i]);
+    }
+    tableFlush(&tableOut);
+}
+
+void searchByPhone() {
+    char phone[100];
+    printf("\nEnter phone number: ");
+    fgets(phone, sizeof(phone), stdin);
+    phone[strcspn(phone, "\n")] = '\0';
+    
+    buildSecondaryIndexes();
+    unsigned int hash = hashPhone(phone);
+    unsigned int mask = phoneIndexCapacity - 1;
+    int found = 0;
+    for (unsigned int slot = hash & mask; phoneIndex[slot].accountIndex != PHONE_EMPTY_SLOT; slot = (slot + 1) & mask) {
+        int index = phoneIndex[slot].accountIndex;
+        if (phoneIndex[slot].hash != hash ||
+            strncmp(profileAt(index)->phone, phone, sizeof(profileAt(index)->phone)) != 0) {
+            continue;
+        }
+        if (found == 0) {
+            printf("\n");
+            printAccountTableHeader();
+        }
+        tableAccountRow(index);
+        found++;
+    }
+    tableFlush(&tableOut);
+    
+    if (found == 0) {
+        printf("No accounts found!\n");
+    }
+}
+
 void deposit(int accountIndex) {
-    double amount;
+    Money amount;
     printf("\nEnter amount to deposit: ");
-    scanf("%lf", &amount);
-    clearInputBuffer();
-    
-    if (amount <= 0) {
+    if (!readMoney(&amount)) {
         printf("Invalid amount!\n");
         return;
     }
     
-    accounts[accountIndex].balance += amount;
-    accounts[accountIndex].lastTransaction = time(NULL);
+    int status = applyDeposit(accountIndex, amount);
+    if (status == TX_INVALID_AMOUNT) {
+        printf("Invalid amount!\n");
+        return;
+    }
+    if (status == TX_BALANCE_OVERFLOW) {
+        printf("Deposit would exceed the maximum balance!\n");
+        return;
+    }
+    journalCommit();
     
-    printf("Deposit successful. New balance: $%.2f\n", accounts[accountIndex].balance);
+    char balance[MONEY_TEXT_SIZE];
+    printf("Deposit successful. New balance: $%s\n", formatMoney(*balanceAt(accountIndex), balance));
 }
 
 void withdraw(int accountIndex) {
-    double amount;
+    Money amount;
     printf("\nEnter amount to withdraw: ");
-    scanf("%lf", &amount);
-    clearInputBuffer();
-    
-    if (amount <= 0) {
+    if (!readMoney(&amount)) {
         printf("Invalid amount!\n");
         return;
     }
     
-    if (amount > accounts[accountIndex].balance) {
+    int status = applyWithdrawal(accountIndex, amount);
+    if (status == TX_INVALID_AMOUNT) {
+        printf("Invalid amount!\n");
+        return;
+    }
+    if (status == TX_INSUFFICIENT_FUNDS) {
         printf("Insufficient balance!\n");
         return;
     }
+    if (status == TX_VELOCITY_LIMIT) {
+        printf("Declined: this account has reached its withdrawal and transfer limits for now.\n");
+        return;
+    }
+    journalCommit();
     
-    accounts[accountIndex].balance -= amount;
-    accounts[accountIndex].lastTransaction = time(NULL);
-    
-    printf("Withdrawal successful. New balance: $%.2f\n", accounts[accountIndex].balance);
+    char balance[MONEY_TEXT_SIZE];
+    printf("Withdrawal successful. New balance: $%s\n", formatMoney(*balanceAt(accountIndex), balance));
 }
 
 void transfer(int accountIndex) {
     int targetAccNumber;
-    double amount;
+    Money amount;
     
     printf("\nEnter recipient account number: ");
     scanf("%d", &targetAccNumber);
@@ -330,38 +4581,108 @@ void transfer(int accountIndex) {
     }
     
     printf("Enter amount to transfer: ");
-    scanf("%lf", &amount);
-    clearInputBuffer();
-    
-    if (amount <= 0) {
+    if (!readMoney(&amount)) {
         printf("Invalid amount!\n");
         return;
     }
     
-    if (amount > accounts[accountIndex].balance) {
+    int status = applyTransfer(accountIndex, targetIndex, amount);
+    if (status == TX_INVALID_AMOUNT) {
+        printf("Invalid amount!\n");
+        return;
+    }
+    if (status == TX_INSUFFICIENT_FUNDS) {
         printf("Insufficient balance!\n");
         return;
     }
+    if (status == TX_BALANCE_OVERFLOW) {
+        printf("Transfer would exceed the recipient's maximum balance!\n");
+        return;
+    }
+    if (status == TX_VELOCITY_LIMIT) {
+        printf("Declined: this account has reached its withdrawal and transfer limits for now.\n");
+        return;
+    }
+    journalCommit();
     
-    accounts[accountIndex].balance -= amount;
-    accounts[targetIndex].balance += amount;
-    
-    time_t now = time(NULL);
-    accounts[accountIndex].lastTransaction = now;
-    accounts[targetIndex].lastTransaction = now;
-    
+    char balance[MONEY_TEXT_SIZE];
     printf("Transfer successful!\n");
-    printf("Your new balance: $%.2f\n", accounts[accountIndex].balance);
+    printf("Your new balance: $%s\n", formatMoney(*balanceAt(accountIndex), balance));
 }
 
 void viewBalance(int accountIndex) {
-    printf("\nAccount Balance: $%.2f\n", accounts[accountIndex].balance);
+    char balance[MONEY_TEXT_SIZE];
+    printf("\nAccount Balance: $%s\n", formatMoney(*balanceAt(accountIndex), balance));
 }
 
 void viewTransactionHistory(int accountIndex) {
+    int accountNumber = *accountNumberAt(accountIndex);
+    int shown = 0;
+    int unread = 0;
+    
     printf("\n===== TRANSACTION HISTORY =====\n");
     printAccountDetails(accountIndex);
-    printf("Last Transaction: %s", ctime(&accounts[accountIndex].lastTransaction));
+    printf("\n%-20s %-13s %s\n", "Date", "Type", "Amount");
+    printf("--------------------------------------------------------\n");
+    
+    // Segments are in chronological order; each contributes one run per column
+    for (int s = 0; s < ledgerSegmentCount; s++) {
+        LedgerIndexEntry entry;
+        if (!ledgerFindAccount(&ledgerSegments[s], accountNumber, &entry)) {
+            continue;
+        }
+        
+        const LedgerSegment *segment = &ledgerSegments[s];
+        off_t columns = segment->offset + sizeof(LedgerSegmentHeader) +
+                        (off_t)segment->accountCount * sizeof(LedgerIndexEntry);
+        off_t deltaColumn = columns + (off_t)segment->rowCount * sizeof(long long);
+        off_t counterpartyColumn = deltaColumn + (off_t)segment->rowCount * sizeof(long long);
+        off_t kindColumn = counterpartyColumn + (off_t)segment->rowCount * sizeof(int);
+        
+        size_t wideLength = entry.rowCount * sizeof(long long);
+        size_t intLength = entry.rowCount * sizeof(int);
+        long long *timestamps = malloc(wideLength);
+        long long *deltas = malloc(wideLength);
+        int *counterparties = malloc(intLength);
+        unsigned char *kinds = malloc(entry.rowCount);
+        if (timestamps == NULL || deltas == NULL || counterparties == NULL || kinds == NULL) {
+            printf("Not enough memory to read %d earlier transactions.\n", entry.rowCount);
+            unread += entry.rowCount;
+        } else if (pread(ledgerFd, timestamps, wideLength,
+                         columns + (off_t)entry.firstRow * sizeof(long long)) != (ssize_t)wideLength ||
+                   pread(ledgerFd, deltas, wideLength,
+                         deltaColumn + (off_t)entry.firstRow * sizeof(long long)) != (ssize_t)wideLength ||
+                   pread(ledgerFd, counterparties, intLength,
+                         counterpartyColumn + (off_t)entry.firstRow * sizeof(int)) != (ssize_t)intLength ||
+                   pread(ledgerFd, kinds, entry.rowCount,
+                         kindColumn + entry.firstRow) != (ssize_t)entry.rowCount) {
+            // A short read means the segment was cut off after it was indexed
+            printf("%s is truncated; %d earlier transactions could not be read.\n",
+                   LEDGER_FILENAME, entry.rowCount);
+            unread += entry.rowCount;
+        } else {
+            for (int i = 0; i < entry.rowCount; i++) {
+                printLedgerRow((time_t)timestamps[i], kinds[i], deltas[i], counterparties[i]);
+            }
+            shown += entry.rowCount;
+        }
+        free(timestamps);
+        free(deltas);
+        free(counterparties);
+        free(kinds);
+    }
+    
+    for (int i = 0; i < ledgerTailCount; i++) {
+        const LedgerRow *row = &ledgerTail[i];
+        if (row->accountNumber == accountNumber) {
+            printLedgerRow(row->timestamp, row->kind, row->deltaCents, row->counterparty);
+            shown++;
+        }
+    }
+    
+    if (shown == 0 && unread == 0) {
+        printf("No transactions recorded.\n");
+    }
 }
 
 void deleteAccount() {
@@ -372,11 +4693,8 @@ void deleteAccount() {
     
     int index = findAccountByNumber(accNumber);
     if (index != -1) {
-        // Shift all accounts after this one forward
-        for (int i = index; i < accountCount - 1; i++) {
-            accounts[i] = accounts[i + 1];
-        }
-        accountCount--;
+        removeAccount(index);
+        saveData();
         printf("Account deleted successfully!\n");
     } else {
         printf("Account not found!\n");
@@ -397,36 +4715,47 @@ void modifyAccount() {
         printf("\nEnter new details (leave blank to keep current):\n");
         
         char input[100];
+        AccountProfile before = *profileAt(index);
+        unindexProfile(index); // re-added below under the new name and phone
         
-        printf("Name [%s]: ", accounts[index].name);
+        printf("Name [%s]: ", profileAt(index)->name);
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = '\0';
         if (strlen(input) > 0) {
-            strcpy(accounts[index].name, input);
+            strcpy(profileAt(index)->name, input);
         }
         
-        printf("Address [%s]: ", accounts[index].address);
+        printf("Address [%s]: ", profileAt(index)->address);
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = '\0';
         if (strlen(input) > 0) {
-            strcpy(accounts[index].address, input);
+            strcpy(profileAt(index)->address, input);
         }
         
-        printf("Phone [%s]: ", accounts[index].phone);
+        printf("Phone [%s]: ", profileAt(index)->phone);
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = '\0';
         if (strlen(input) > 0) {
-            strcpy(accounts[index].phone, input);
+            strcpy(profileAt(index)->phone, input);
         }
         
-        printf("Account Type [%s]: ", accounts[index].accountType);
+        printf("Account Type [%s]: ", profileAt(index)->accountType);
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = '\0';
         if (strlen(input) > 0) {
-            strcpy(accounts[index].accountType, input);
+            strcpy(profileAt(index)->accountType, input);
+            refreshKindColumn(index);
+        }
+        
+        indexProfile(index);
+        if (memcmp(&before, profileAt(index), sizeof(before)) != 0) {
+            auditAppend(AUDIT_MODIFIED, accNumber, &before, profileAt(index));
         }
         
-        accounts[index].lastTransaction = time(NULL);
+        *lastTransactionAt(index) = time(NULL);
+        markDirty(&dirtyAccounts, index);
+        markDirty(&dirtyProfiles, index);
+        saveData();
         printf("\nAccount updated successfully!\n");
     } else {
         printf("Account not found!\n");
@@ -434,25 +4763,564 @@ void modifyAccount() {
 }
 
 int findAccountByNumber(int accountNumber) {
-    for (int i = 0; i < accountCount; i++) {
-        if (accounts[i].accountNumber == accountNumber) {
-            return i;
+    if (indexCapacity == 0 || accountNumber == INDEX_EMPTY_SLOT) {
+        return -1;
+    }
+    
+    unsigned int mask = indexCapacity - 1;
+    unsigned int slot = hashAccountNumber(accountNumber) & mask;
+    while (accountHashIndex[slot].accountNumber != INDEX_EMPTY_SLOT) {
+        if (accountHashIndex[slot].accountNumber == accountNumber) {
+            return accountHashIndex[slot].accountIndex;
         }
+        slot = (slot + 1) & mask;
     }
     return -1;
 }
 
+unsigned int hashAccountNumber(int accountNumber) {
+    // Fibonacci multiply, then fold the high bits down so the low-bit mask sees them
+    unsigned int h = (unsigned int)accountNumber * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+void releaseAccountIndex() {
+    if (!isInSnapshotMapping(accountHashIndex)) {
+        free(accountHashIndex);
+    }
+    accountHashIndex = NULL;
+    indexCapacity = 0;
+    indexUsed = 0;
+}
+
+void allocateAccountIndex(int capacity) {
+    releaseAccountIndex();
+    accountHashIndex = calloc(capacity, sizeof(IndexSlot));
+    if (accountHashIndex == NULL) {
+        printf("Out of memory while building account index!\n");
+        exit(1);
+    }
+    indexCapacity = capacity;
+    indexUsed = 0;
+}
+
+void rebuildAccountIndex() {
+    dropSecondaryIndexes(); // positions may have changed
+    
+    int capacity = INDEX_INITIAL_CAPACITY;
+    while (capacity < (accountCount - tombstoneCount) * 2) {
+        capacity *= 2;
+    }
+    
+    allocateAccountIndex(capacity);
+    for (int i = 0; i < accountCount; i++) {
+        if (!isTombstone(i)) {
+            indexInsert(*accountNumberAt(i), i);
+        }
+    }
+}
+
+// Inserts a new key or repoints an existing one; keeps load factor at or below 1/2
+void indexInsert(int accountNumber, int accountIndexValue) {
+    if ((indexUsed + 1) * 2 > indexCapacity) {
+        int oldCapacity = indexCapacity;
+        IndexSlot *oldSlots = accountHashIndex;
+        
+        accountHashIndex = NULL;
+        allocateAccountIndex(oldCapacity > 0 ? oldCapacity * 2 : INDEX_INITIAL_CAPACITY);
+        for (int i = 0; i < oldCapacity; i++) {
+            if (oldSlots[i].accountNumber != INDEX_EMPTY_SLOT) {
+                indexInsert(oldSlots[i].accountNumber, oldSlots[i].accountIndex);
+            }
+        }
+        if (!isInSnapshotMapping(oldSlots)) {
+            free(oldSlots);
+        }
+    }
+    
+    unsigned int mask = indexCapacity - 1;
+    unsigned int slot = hashAccountNumber(accountNumber) & mask;
+    while (accountHashIndex[slot].accountNumber != INDEX_EMPTY_SLOT) {
+        if (accountHashIndex[slot].accountNumber == accountNumber) {
+            accountHashIndex[slot].accountIndex = accountIndexValue;
+            markSlotDirty(slot);
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    accountHashIndex[slot].accountNumber = accountNumber;
+    accountHashIndex[slot].accountIndex = accountIndexValue;
+    markSlotDirty(slot);
+    indexUsed++;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+void indexRemove(int accountNumber) {
+    if (indexCapacity == 0) {
+        return;
+    }
+    
+    unsigned int mask = indexCapacity - 1;
+    unsigned int slot = hashAccountNumber(accountNumber) & mask;
+    while (accountHashIndex[slot].accountNumber != accountNumber) {
+        if (accountHashIndex[slot].accountNumber == INDEX_EMPTY_SLOT) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    unsigned int hole = slot;
+    unsigned int next = (hole + 1) & mask;
+    while (accountHashIndex[next].accountNumber != INDEX_EMPTY_SLOT) {
+        unsigned int home = hashAccountNumber(accountHashIndex[next].accountNumber) & mask;
+        // Move the entry back if its home slot does not lie in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            accountHashIndex[hole] = accountHashIndex[next];
+            markSlotDirty(hole);
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    accountHashIndex[hole].accountNumber = INDEX_EMPTY_SLOT;
+    markSlotDirty(hole);
+    indexUsed--;
+}
+
+// Sorts the live positions by name and hashes their phone numbers; a no-op
+// once built
+void buildSecondaryIndexes() {
+    if (secondaryIndexesBuilt) {
+        return;
+    }
+    
+    int live = accountCount - tombstoneCount;
+    nameIndexCapacity = live > INDEX_INITIAL_CAPACITY ? live : INDEX_INITIAL_CAPACITY;
+    nameIndex = malloc(nameIndexCapacity * sizeof(int));
+    if (nameIndex == NULL) {
+        printf("Out of memory while building search indexes!\n");
+        exit(1);
+    }
+    nameIndexCount = 0;
+    for (int i = 0; i < accountCount; i++) {
+        if (!isTombstone(i)) {
+            nameIndex[nameIndexCount++] = i;
+        }
+    }
+    qsort(nameIndex, nameIndexCount, sizeof(int), compareNamePositions);
+    
+    int capacity = INDEX_INITIAL_CAPACITY;
+    while (capacity < live * 2) {
+        capacity *= 2;
+    }
+    resizePhoneIndex(capacity);
+    for (int i = 0; i < nameIndexCount; i++) {
+        phoneIndexInsert(nameIndex[i]);
+    }
+    secondaryIndexesBuilt = true;
+}
+
+void dropSecondaryIndexes() {
+    free(nameIndex);
+    nameIndex = NULL;
+    nameIndexCount = 0;
+    nameIndexCapacity = 0;
+    free(phoneIndex);
+    phoneIndex = NULL;
+    phoneIndexCapacity = 0;
+    phoneIndexUsed = 0;
+    secondaryIndexesBuilt = false;
+}
+
+// Call once the account's profile is stored, and unindexProfile before it changes
+void indexProfile(int accountIndex) {
+    if (secondaryIndexesBuilt) {
+        nameIndexInsert(accountIndex);
+        phoneIndexInsert(accountIndex);
+    }
+}
+
+void unindexProfile(int accountIndex) {
+    if (secondaryIndexesBuilt) {
+        nameIndexRemove(accountIndex);
+        phoneIndexRemove(accountIndex);
+    }
+}
+
+// Name order ignoring case; equal names fall back to position so every entry has one place
+int compareNamePositions(const void *a, const void *b) {
+    int first = *(const int *)a;
+    int second = *(const int *)b;
+    int order = strcasecmp(profileAt(first)->name, profileAt(second)->name);
+    if (order != 0) {
+        return order;
+    }
+    return (first > second) - (first < second);
+}
+
+// First nameIndex position whose entry does not sort before (name, accountIndex)
+int nameLowerBound(const char *name, int accountIndex) {
+    int low = 0;
+    int high = nameIndexCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int order = strcasecmp(profileAt(nameIndex[middle])->name, name);
+        if (order < 0 || (order == 0 && nameIndex[middle] < accountIndex)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Names starting with a prefix are contiguous in nameIndex; returns the first
+// of them, or with pastMatches the position just after the last
+int namePrefixBound(const char *prefix, bool pastMatches) {
+    size_t length = strlen(prefix);
+    int low = 0;
+    int high = nameIndexCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int order = strncasecmp(profileAt(nameIndex[middle])->name, prefix, length);
+        if (order < 0 || (pastMatches && order == 0)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void nameIndexInsert(int accountIndex) {
+    if (nameIndexCount == nameIndexCapacity) {
+        int newCapacity = nameIndexCapacity * 2;
+        int *newIndex = realloc(nameIndex, newCapacity * sizeof(int));
+        if (newIndex == NULL) {
+            printf("Out of memory while updating search indexes!\n");
+            exit(1);
+        }
+        nameIndex = newIndex;
+        nameIndexCapacity = newCapacity;
+    }
+    
+    int position = nameLowerBound(profileAt(accountIndex)->name, accountIndex);
+    memmove(&nameIndex[position + 1], &nameIndex[position], (nameIndexCount - position) * sizeof(int));
+    nameIndex[position] = accountIndex;
+    nameIndexCount++;
+}
+
+void nameIndexRemove(int accountIndex) {
+    int position = nameLowerBound(profileAt(accountIndex)->name, accountIndex);
+    if (position == nameIndexCount || nameIndex[position] != accountIndex) {
+        return;
+    }
+    memmove(&nameIndex[position], &nameIndex[position + 1], (nameIndexCount - position - 1) * sizeof(int));
+    nameIndexCount--;
+}
+
+// FNV-1a over the stored characters
+unsigned int hashPhone(const char *phone) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(((AccountProfile *)0)->phone) && phone[i] != '\0'; i++) {
+        hash = (hash ^ (unsigned char)phone[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Replaces the table with an empty one of `capacity` slots and re-adds what was there
+void resizePhoneIndex(int capacity) {
+    PhoneSlot *oldSlots = phoneIndex;
+    int oldCapacity = phoneIndexCapacity;
+    
+    phoneIndex = malloc(capacity * sizeof(PhoneSlot));
+    if (phoneIndex == NULL) {
+        printf("Out of memory while building search indexes!\n");
+        exit(1);
+    }
+    for (int i = 0; i < capacity; i++) {
+        phoneIndex[i].accountIndex = PHONE_EMPTY_SLOT;
+    }
+    phoneIndexCapacity = capacity;
+    phoneIndexUsed = 0;
+    
+    unsigned int mask = capacity - 1;
+    for (int i = 0; i < oldCapacity; i++) {
+        if (oldSlots[i].accountIndex == PHONE_EMPTY_SLOT) {
+            continue;
+        }
+        unsigned int slot = oldSlots[i].hash & mask;
+        while (phoneIndex[slot].accountIndex != PHONE_EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
+        }
+        phoneIndex[slot] = oldSlots[i];
+        phoneIndexUsed++;
+    }
+    free(oldSlots);
+}
+
+// Keeps the load factor at or below 1/2, like the account number index
+void phoneIndexInsert(int accountIndex) {
+    if ((phoneIndexUsed + 1) * 2 > phoneIndexCapacity) {
+        resizePhoneIndex(phoneIndexCapacity > 0 ? phoneIndexCapacity * 2 : INDEX_INITIAL_CAPACITY);
+    }
+    
+    unsigned int hash = hashPhone(profileAt(accountIndex)->phone);
+    unsigned int mask = phoneIndexCapacity - 1;
+    unsigned int slot = hash & mask;
+    while (phoneIndex[slot].accountIndex != PHONE_EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    phoneIndex[slot].hash = hash;
+    phoneIndex[slot].accountIndex = accountIndex;
+    phoneIndexUsed++;
+}
+
+// Backward-shift deletion, as in indexRemove
+void phoneIndexRemove(int accountIndex) {
+    unsigned int mask = phoneIndexCapacity - 1;
+    unsigned int slot = hashPhone(profileAt(accountIndex)->phone) & mask;
+    while (phoneIndex[slot].accountIndex != accountIndex) {
+        if (phoneIndex[slot].accountIndex == PHONE_EMPTY_SLOT) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    unsigned int hole = slot;
+    unsigned int next = (hole + 1) & mask;
+    while (phoneIndex[next].accountIndex != PHONE_EMPTY_SLOT) {
+        unsigned int home = phoneIndex[next].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            phoneIndex[hole] = phoneIndex[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    phoneIndex[hole].accountIndex = PHONE_EMPTY_SLOT;
+    phoneIndexUsed--;
+}
+
 void printAccountDetails(int index) {
     printf("\n===== ACCOUNT DETAILS =====\n");
-    printf("Account Number: %d\n", accounts[index].accountNumber);
-    printf("Customer Name: %s\n", accounts[index].name);
-    printf("Address: %s\n", accounts[index].address);
-    printf("Phone Number: %s\n", accounts[index].phone);
-    printf("Account Type: %s\n", accounts[index].accountType);
-    printf("Current Balance: $%.2f\n", accounts[index].balance);
-    printf("Last Transaction: %s", ctime(&accounts[index].lastTransaction));
+    printf("Account Number: %d\n", *accountNumberAt(index));
+    printf("Customer Name: %s\n", profileAt(index)->name);
+    printf("Address: %s\n", profileAt(index)->address);
+    printf("Phone Number: %s\n", profileAt(index)->phone);
+    printf("Account Type: %s\n", profileAt(index)->accountType);
+    char balance[MONEY_TEXT_SIZE];
+    printf("Current Balance: $%s\n", formatMoney(*balanceAt(index), balance));
+    printf("Last Transaction: %s", ctime(lastTransactionAt(index)));
 }
 
 void clearInputBuffer() {
     while (getchar() != '\n');
 }
+
+// Pads `text` to `width` and adds the column separator; flushes first when full
+void tableText(TableBuffer *out, const char *text, int width) {
+    size_t length = strlen(text);
+    size_t padded = length < (size_t)width ? (size_t)width : length;
+    if (out->length + padded + 1 > sizeof(out->data)) {
+        tableFlush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    memset(out->data + out->length + length, ' ', padded - length + 1);
+    out->length += padded + 1;
+}
+
+void tableInt(TableBuffer *out, long long value, int width) {
+    char digits[24];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    *--cursor = '\0';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    tableText(out, cursor, width);
+}
+
+void tableChar(TableBuffer *out, char value, int width) {
+    char text[2] = { value, '\0' };
+    tableText(out, text, width);
+}
+
+// Turns the separator after the last column into the newline
+void tableEndRow(TableBuffer *out) {
+    if (out->length > 0) {
+        out->data[out->length - 1] = '\n';
+    }
+}
+
+void tableFlush(TableBuffer *out) {
+    fflush(stdout); // anything printed with stdio so far goes first
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t result = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    out->length = 0;
+}
+
+bool nextPage(int shown, int total) {
+    printf("-- %d of %d shown, Enter for more, q to stop -- ", shown, total);
+    char line[16];
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(line, '\n') == NULL && !feof(stdin)) {
+        clearInputBuffer();
+    }
+    return line[0] != 'q' && line[0] != 'Q';
+}
+
+void tableMoney(TableBuffer *out, Money amount, int width) {
+    char text[MONEY_TEXT_SIZE + 1] = "$";
+    formatMoney(amount, text + 1);
+    tableText(out, text, width);
+}
+
+// ctime() layout ("Sat Oct 17 23:34:45 2026") without a localtime() call per
+// row: all but the seconds is cached per minute in a direct-mapped table
+void tableDate(TableBuffer *out, time_t when) {
+    static struct {
+        bool used;
+        time_t minute;
+        char prefix[24]; // "Sat Oct 17 23:34:"
+        char year[8];    // " 2026"
+    } cache[DATE_CACHE_SIZE];
+    
+    time_t minute = when - ((when % 60) + 60) % 60;
+    int slot = (int)((unsigned long long)(minute / 60) & (DATE_CACHE_SIZE - 1));
+    if (!cache[slot].used || cache[slot].minute != minute) {
+        struct tm local;
+        localtime_r(&minute, &local);
+        strftime(cache[slot].prefix, sizeof(cache[slot].prefix), "%a %b %e %H:%M:", &local);
+        strftime(cache[slot].year, sizeof(cache[slot].year), " %Y", &local);
+        cache[slot].used = true;
+        cache[slot].minute = minute;
+    }
+    
+    char text[40];
+    size_t length = strlen(cache[slot].prefix);
+    int seconds = (int)(when - minute);
+    memcpy(text, cache[slot].prefix, length);
+    text[length++] = '0' + seconds / 10;
+    text[length++] = '0' + seconds % 10;
+    strcpy(text + length, cache[slot].year);
+    tableText(out, text, 0);
+}
+
+// Both leave *result untouched and return false on overflow
+bool moneyAdd(Money a, Money b, Money *result) {
+    Money sum;
+    if (__builtin_add_overflow(a, b, &sum)) {
+        return false;
+    }
+    *result = sum;
+    return true;
+}
+
+bool moneySub(Money a, Money b, Money *result) {
+    Money difference;
+    if (__builtin_sub_overflow(a, b, &difference)) {
+        return false;
+    }
+    *result = difference;
+    return true;
+}
+
+// Only for migrating amounts that were stored as doubles
+Money moneyFromDouble(double amount) {
+    return (Money)(amount * 100.0 + (amount < 0 ? -0.5 : 0.5));
+}
+
+// Accepts an optional sign, digits and at most two decimals ("12", "-3.5",
+// "0.07"); surrounding blanks are ignored
+bool parseMoney(const char *text, Money *amount) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    bool negative = *text == '-';
+    if (*text == '-' || *text == '+') {
+        text++;
+    }
+    
+    Money value = 0;
+    int digits = 0;
+    for (; isdigit((unsigned char)*text); text++, digits++) {
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            __builtin_add_overflow(value, *text - '0', &value)) {
+            return false;
+        }
+    }
+    
+    int decimals = 0;
+    if (*text == '.') {
+        for (text++; isdigit((unsigned char)*text); text++, decimals++) {
+            if (decimals == 2) {
+                return false; // sub-cent amounts are not representable
+            }
+            if (__builtin_mul_overflow(value, 10, &value) ||
+                __builtin_add_overflow(value, *text - '0', &value)) {
+                return false;
+            }
+        }
+    }
+    if (digits == 0 && decimals == 0) {
+        return false;
+    }
+    for (; decimals < 2; decimals++) {
+        if (__builtin_mul_overflow(value, 10, &value)) {
+            return false;
+        }
+    }
+    
+    while (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n') {
+        text++;
+    }
+    if (*text != '\0') {
+        return false;
+    }
+    *amount = negative ? -value : value;
+    return true;
+}
+
+// Reads one amount and discards the rest of the line
+bool readMoney(Money *amount) {
+    char text[32];
+    bool ok = scanf("%31s", text) == 1 && parseMoney(text, amount);
+    clearInputBuffer();
+    return ok;
+}
+
+// Writes the amount as "1234.56" into buffer (MONEY_TEXT_SIZE bytes) and returns it
+char *formatMoney(Money amount, char *buffer) {
+    char digits[MONEY_TEXT_SIZE];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = amount < 0 ? 0ULL - (unsigned long long)amount : (unsigned long long)amount;
+    
+    *--cursor = '\0';
+    *--cursor = '0' + magnitude % 10;
+    magnitude /= 10;
+    *--cursor = '0' + magnitude % 10;
+    magnitude /= 10;
+    *--cursor = '.';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (amount < 0) {
+        *--cursor = '-';
+    }
+    
+    memcpy(buffer, cursor, digits + sizeof(digits) - cursor);
+    return buffer;
+}
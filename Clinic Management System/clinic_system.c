@@ -4,6 +4,9 @@
 #include <time.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 // Define maximum capacities for patients, doctors, appointments, and medicines
 #define MAX_PATIENTS 100
@@ -13,13 +16,33 @@
 
 // Define filenames for data persistence
 #define FILENAME_PATIENTS "patients.dat"
-#define FILENAME_DOCTORS "doctors.dat"
-#define FILENAME_APPOINTMENTS "appointments.dat"
-#define FILENAME_MEDICINES "medicines.dat"
+#define FILENAME_DOCTORS "doctor_records.dat"
+#define FILENAME_APPOINTMENTS "appointment_records.dat"
+#define FILENAME_MEDICINES "medicine_records.dat"
+
+// Files from before fees and prices were stored in cents; converted when
+// the new file does not exist yet
+#define LEGACY_FILENAME_DOCTORS "doctors.dat"
+#define LEGACY_FILENAME_APPOINTMENTS "appointments.dat"
+#define LEGACY_FILENAME_MEDICINES "medicines.dat"
+
+// Deleted records keep their slot with this id until the table is compacted
+#define TOMBSTONE_ID 0
+
+// Id counter file, written once per ID_BLOCK_SIZE new ids
+#define FILENAME_IDS "clinic_ids.dat"
+#define ID_BLOCK_SIZE 32
 
 // Admin credentials for system login
 #define ADMIN_USERNAME "admin"
 #define ADMIN_PASSWORD "admin123"
+#define TABLE_BUFFER_SIZE 65536 // bytes of list output per write()
+#define PAGE_ROWS 20 // list rows shown before asking to continue
+
+#define MONEY_TEXT_SIZE 24 // "-92233720368547758.08" and the terminator
+
+// Fees and prices in whole cents, so bill totals are exact
+typedef long long Money;
 
 // Structure to hold patient information
 typedef struct {
@@ -41,7 +64,7 @@ typedef struct {
     char specialization[50];
     char phone[15];
     char schedule[100];      // Changed from availableDays/Hours to single schedule string
-    int consultationFee;     // Changed name from fee
+    Money consultationFee;   // Changed name from fee
 } Doctor;
 
 // Structure to hold appointment information
@@ -53,7 +76,7 @@ typedef struct {
     char time[10]; // HH:MM format
     char diagnosis[200];    // New field
     char prescription[500]; // New field, increased size
-    float fee;              // Changed name from purpose, now stores total fee
+    Money fee;              // Changed name from purpose, now stores total fee
     char status[20];        // "Scheduled", "Completed", "Cancelled"
 } Appointment;
 
@@ -62,11 +85,66 @@ typedef struct {
     int id;
     char name[50];
     char manufacturer[50];
-    float price;
+    Money price;
     int quantity;
     char expiryDate[20]; // DD/MM/YYYY format
 } Medicine;
 
+// Records as stored in the legacy files: whole-dollar fees, float amounts
+typedef struct {
+    int id;
+    char name[50];
+    char specialization[50];
+    char phone[15];
+    char schedule[100];
+    int consultationFee;
+} LegacyDoctor;
+
+typedef struct {
+    int id;
+    int patientId;
+    int doctorId;
+    char date[20];
+    char time[10];
+    char diagnosis[200];
+    char prescription[500];
+    float fee;
+    char status[20];
+} LegacyAppointment;
+
+typedef struct {
+    int id;
+    char name[50];
+    char manufacturer[50];
+    float price;
+    int quantity;
+    char expiryDate[20];
+} LegacyMedicine;
+
+// Structure to track which records of a table need saving
+typedef struct {
+    const char *filename;
+    size_t recordSize;
+    int savedCount; // Records saved in the file, -1 if it must be rewritten
+    bool *dirty;    // Changed since the last save
+    size_t idOffset; // Id field, zeroed when the record is deleted
+    int tombstones;  // Deleted records still in the table
+} TableFile;
+
+// Structure for the id counter every table draws from, so ids stay unique
+// across patients, doctors, appointments and medicines
+typedef struct {
+    int firstId;     // Starting id when there are no files yet
+    int next;        // Id the next record gets
+    int reservedEnd; // End of the block saved in FILENAME_IDS
+} IdSequence;
+
+// Structure to buffer list rows until they are written
+typedef struct {
+    char data[TABLE_BUFFER_SIZE];
+    size_t length;
+} TableBuffer;
+
 // Global arrays to store data in memory
 Patient patients[MAX_PATIENTS];
 Doctor doctors[MAX_DOCTORS];
@@ -79,11 +157,40 @@ int doctorCount = 0;
 int appointmentCount = 0;
 int medicineCount = 0; // New counter
 
+// Dirty flags and file bookkeeping for incremental saves
+bool patientDirty[MAX_PATIENTS];
+bool doctorDirty[MAX_DOCTORS];
+bool appointmentDirty[MAX_APPOINTMENTS];
+bool medicineDirty[MAX_MEDICINES];
+TableFile patientTable = { FILENAME_PATIENTS, sizeof(Patient), -1, patientDirty, offsetof(Patient, id), 0 };
+TableFile doctorTable = { FILENAME_DOCTORS, sizeof(Doctor), -1, doctorDirty, offsetof(Doctor, id), 0 };
+TableFile appointmentTable = { FILENAME_APPOINTMENTS, sizeof(Appointment), -1, appointmentDirty, offsetof(Appointment, id), 0 };
+TableFile medicineTable = { FILENAME_MEDICINES, sizeof(Medicine), -1, medicineDirty, offsetof(Medicine, id), 0 };
+
+// Id counter for new records
+IdSequence recordIds = { 1000, 0, 0 };
+TableBuffer tableOut; // used by every list view
+
 // --- Function Prototypes ---
 
 // Data management functions
 void loadData(); // Loads data from binary files into memory
 void saveData(); // Saves data from memory to binary files
+int loadTable(TableFile *table, void *records, int maxRecords); // Reads a table file into memory
+int loadLegacyTable(TableFile *table, const char *filename, size_t legacySize, void *records, int maxRecords,
+                    void (*convert)(const void *legacy, void *record)); // Converts an old-layout file
+void convertLegacyDoctor(const void *legacy, void *record); // Whole dollars to cents
+void convertLegacyAppointment(const void *legacy, void *record); // Float fee to cents
+void convertLegacyMedicine(const void *legacy, void *record); // Float price to cents
+Money moneyFromFloat(float amount); // Rounds a float amount to the nearest cent
+void markDirty(TableFile *table, int index); // Marks a record as changed
+void saveTable(TableFile *table, const void *records, int count); // Saves only the changed records
+bool isTombstone(const TableFile *table, const void *records, int index); // Checks for a deleted record
+void deleteRecord(TableFile *table, void *records, int index); // Marks a record deleted
+int compactTable(TableFile *table, void *records, int count); // Removes deleted records, returns the new count
+void loadIdSequence(IdSequence *sequence); // Reads the id counter
+void skipUsedIds(IdSequence *sequence, const TableFile *table, const void *records, int count); // Raises it above a table's ids
+int allocateId(IdSequence *sequence); // Returns a fresh id, or -1 on a write error
 
 // Authentication and menu functions
 int authenticateAdmin(); // Authenticates the admin user
@@ -132,6 +239,17 @@ int findMedicineById(int id);   // New: Finds a medicine's index by its ID
 
 // Utility functions
 void clearInputBuffer(); // Clears the standard input buffer
+bool moneyAdd(Money a, Money b, Money *result); // Overflow-checked addition
+bool parseMoney(const char *text, Money *amount); // Parses "12.50" into cents
+bool readMoney(Money *amount); // Reads one amount from its own input line
+char *formatMoney(Money amount, char *buffer); // Formats cents as "12.50"
+void tableText(TableBuffer *out, const char *text, int width); // Appends a left-aligned column
+void tableInt(TableBuffer *out, long long value, int width); // Appends an integer column
+void tableChar(TableBuffer *out, char value, int width); // Appends a one-character column
+void tableEndRow(TableBuffer *out); // Ends the current row
+void tableFlush(TableBuffer *out); // Flushes the rows to stdout
+bool nextPage(int shown, int total); // Asks whether to show the next page of a list
+void tableMoney(TableBuffer *out, Money amount, int width); // Appends a "$1234.56" column
 void printWelcomeArt();  // Prints ASCII art for welcome message
 
 // --- Helper Menu Functions (for better menu navigation) ---
@@ -172,70 +290,290 @@ void printWelcomeArt() {
 
 // Function to load data from binary files
 void loadData() {
-    FILE *file;
-    
-    // Load patients from file
-    file = fopen(FILENAME_PATIENTS, "rb");
-    if (file != NULL) {
-        patientCount = fread(patients, sizeof(Patient), MAX_PATIENTS, file);
-        fclose(file);
-    }
-    
-    // Load doctors from file
-    file = fopen(FILENAME_DOCTORS, "rb");
-    if (file != NULL) {
-        doctorCount = fread(doctors, sizeof(Doctor), MAX_DOCTORS, file);
-        fclose(file);
-    }
-    
-    // Load appointments from file
-    file = fopen(FILENAME_APPOINTMENTS, "rb");
-    if (file != NULL) {
-        appointmentCount = fread(appointments, sizeof(Appointment), MAX_APPOINTMENTS, file);
-        fclose(file);
+    patientCount = loadTable(&patientTable, patients, MAX_PATIENTS);
+    if (access(FILENAME_DOCTORS, F_OK) == 0) {
+        doctorCount = loadTable(&doctorTable, doctors, MAX_DOCTORS);
+    } else {
+        doctorCount = loadLegacyTable(&doctorTable, LEGACY_FILENAME_DOCTORS, sizeof(LegacyDoctor),
+                                      doctors, MAX_DOCTORS, convertLegacyDoctor);
     }
-    
-    // Load medicines from file (new)
-    file = fopen(FILENAME_MEDICINES, "rb");
-    if (file != NULL) {
-        medicineCount = fread(medicines, sizeof(Medicine), MAX_MEDICINES, file);
-        fclose(file);
+    if (access(FILENAME_APPOINTMENTS, F_OK) == 0) {
+        appointmentCount = loadTable(&appointmentTable, appointments, MAX_APPOINTMENTS);
+    } else {
+        appointmentCount = loadLegacyTable(&appointmentTable, LEGACY_FILENAME_APPOINTMENTS, sizeof(LegacyAppointment),
+                                           appointments, MAX_APPOINTMENTS, convertLegacyAppointment);
     }
+    if (access(FILENAME_MEDICINES, F_OK) == 0) {
+        medicineCount = loadTable(&medicineTable, medicines, MAX_MEDICINES);
+    } else {
+        medicineCount = loadLegacyTable(&medicineTable, LEGACY_FILENAME_MEDICINES, sizeof(LegacyMedicine),
+                                        medicines, MAX_MEDICINES, convertLegacyMedicine);
+    }
+    loadIdSequence(&recordIds);
+    skipUsedIds(&recordIds, &patientTable, patients, patientCount);
+    skipUsedIds(&recordIds, &doctorTable, doctors, doctorCount);
+    skipUsedIds(&recordIds, &medicineTable, medicines, medicineCount);
+    skipUsedIds(&recordIds, &appointmentTable, appointments, appointmentCount);
 }
 
 // Function to save data to binary files
 void saveData() {
-    FILE *file;
+    if (patientTable.tombstones * 4 > patientCount) {
+        patientCount = compactTable(&patientTable, patients, patientCount);
+    }
+    saveTable(&patientTable, patients, patientCount);
+    if (doctorTable.tombstones * 4 > doctorCount) {
+        doctorCount = compactTable(&doctorTable, doctors, doctorCount);
+    }
+    saveTable(&doctorTable, doctors, doctorCount);
+    saveTable(&appointmentTable, appointments, appointmentCount);
+    if (medicineTable.tombstones * 4 > medicineCount) {
+        medicineCount = compactTable(&medicineTable, medicines, medicineCount);
+    }
+    saveTable(&medicineTable, medicines, medicineCount);
+}
+
+// Function to read a table file into memory
+int loadTable(TableFile *table, void *records, int maxRecords) {
+    FILE *file = fopen(table->filename, "rb");
+    if (file == NULL) {
+        table->savedCount = -1;
+        return 0;
+    }
+    
+    int count = fread(records, table->recordSize, maxRecords, file);
+    table->savedCount = fgetc(file) == EOF ? count : -1;
+    fclose(file);
     
-    // Save patients to file
-    file = fopen(FILENAME_PATIENTS, "wb");
-    if (file != NULL) {
-        fwrite(patients, sizeof(Patient), patientCount, file);
-        fclose(file);
+    table->tombstones = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            table->tombstones++;
+        }
+    }
+    return count;
+}
+
+// Reads a file in the layout used before amounts were stored in cents and
+// converts each record. The next save writes the table under its new name
+// and the legacy file is no longer read. A file that is not a whole number
+// of legacy records is refused rather than read as garbage and overwritten.
+int loadLegacyTable(TableFile *table, const char *filename, size_t legacySize, void *records, int maxRecords,
+                    void (*convert)(const void *legacy, void *record)) {
+    table->savedCount = -1;
+    table->tombstones = 0;
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    if (size < 0 || size % legacySize != 0) {
+        printf("%s has an unknown record layout; move it aside to continue.\n", filename);
+        exit(1);
+    }
+    
+    union {
+        LegacyDoctor doctor;
+        LegacyAppointment appointment;
+        LegacyMedicine medicine;
+    } legacy;
+    unsigned char *bytes = records;
+    int count = 0;
+    while (count < maxRecords && fread(&legacy, legacySize, 1, file) == 1) {
+        convert(&legacy, bytes + count * table->recordSize);
+        if (isTombstone(table, records, count)) {
+            table->tombstones++;
+        }
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+void convertLegacyDoctor(const void *legacy, void *record) {
+    const LegacyDoctor *old = legacy;
+    Doctor *doctor = record;
+    memset(doctor, 0, sizeof(*doctor));
+    doctor->id = old->id;
+    memcpy(doctor->name, old->name, sizeof(doctor->name));
+    memcpy(doctor->specialization, old->specialization, sizeof(doctor->specialization));
+    memcpy(doctor->phone, old->phone, sizeof(doctor->phone));
+    memcpy(doctor->schedule, old->schedule, sizeof(doctor->schedule));
+    doctor->consultationFee = (Money)old->consultationFee * 100;
+}
+
+void convertLegacyAppointment(const void *legacy, void *record) {
+    const LegacyAppointment *old = legacy;
+    Appointment *appointment = record;
+    memset(appointment, 0, sizeof(*appointment));
+    appointment->id = old->id;
+    appointment->patientId = old->patientId;
+    appointment->doctorId = old->doctorId;
+    memcpy(appointment->date, old->date, sizeof(appointment->date));
+    memcpy(appointment->time, old->time, sizeof(appointment->time));
+    memcpy(appointment->diagnosis, old->diagnosis, sizeof(appointment->diagnosis));
+    memcpy(appointment->prescription, old->prescription, sizeof(appointment->prescription));
+    appointment->fee = moneyFromFloat(old->fee);
+    memcpy(appointment->status, old->status, sizeof(appointment->status));
+}
+
+void convertLegacyMedicine(const void *legacy, void *record) {
+    const LegacyMedicine *old = legacy;
+    Medicine *medicine = record;
+    memset(medicine, 0, sizeof(*medicine));
+    medicine->id = old->id;
+    memcpy(medicine->name, old->name, sizeof(medicine->name));
+    memcpy(medicine->manufacturer, old->manufacturer, sizeof(medicine->manufacturer));
+    medicine->price = moneyFromFloat(old->price);
+    medicine->quantity = old->quantity;
+    memcpy(medicine->expiryDate, old->expiryDate, sizeof(medicine->expiryDate));
+}
+
+// Only for converting legacy records; new amounts are parsed exactly
+Money moneyFromFloat(float amount) {
+    double cents = (double)amount * 100;
+    return (Money)(cents < 0 ? cents - 0.5 : cents + 0.5);
+}
+
+void markDirty(TableFile *table, int index) {
+    table->dirty[index] = true;
+}
+
+// Function to write the changed records of one table
+void saveTable(TableFile *table, const void *records, int count) {
+    const unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    
+    int fd = -1;
+    if (table->savedCount >= 0 && count >= table->savedCount) {
+        fd = open(table->filename, O_WRONLY);
+    }
+    if (fd != -1) {
+        bool ok = true;
+        int i = 0;
+        while (i < count && ok) {
+            if (i < table->savedCount && !table->dirty[i]) {
+                i++;
+                continue;
+            }
+            
+            int end = i + 1;
+            while (end < count && (end >= table->savedCount || table->dirty[end])) {
+                end++;
+            }
+            size_t length = (end - i) * size;
+            ok = pwrite(fd, bytes + i * size, length, (off_t)i * size) == (ssize_t)length;
+            i = end;
+        }
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        
+        if (ok) {
+            memset(table->dirty, 0, count * sizeof(bool));
+            table->savedCount = count;
+            return;
+        }
     }
     
-    // Save doctors to file
-    file = fopen(FILENAME_DOCTORS, "wb");
-    if (file != NULL) {
-        fwrite(doctors, sizeof(Doctor), doctorCount, file);
-        fclose(file);
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", table->filename);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return;
+    }
+    fwrite(records, size, count, file);
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempName, table->filename) != 0) {
+        remove(tempName);
+        return;
     }
     
-    // Save appointments to file
-    file = fopen(FILENAME_APPOINTMENTS, "wb");
-    if (file != NULL) {
-        fwrite(appointments, sizeof(Appointment), appointmentCount, file);
-        fclose(file);
+    memset(table->dirty, 0, count * sizeof(bool));
+    table->savedCount = count;
+}
+
+bool isTombstone(const TableFile *table, const void *records, int index) {
+    int id;
+    memcpy(&id, (const unsigned char *)records + index * table->recordSize + table->idOffset, sizeof(id));
+    return id == TOMBSTONE_ID;
+}
+
+// Function to flag a record as deleted without moving the others
+void deleteRecord(TableFile *table, void *records, int index) {
+    int id = TOMBSTONE_ID;
+    memcpy((unsigned char *)records + index * table->recordSize + table->idOffset, &id, sizeof(id));
+    table->tombstones++;
+    markDirty(table, index);
+}
+
+// Function to squeeze deleted records out of a table
+int compactTable(TableFile *table, void *records, int count) {
+    unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    int live = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            continue;
+        }
+        if (live != i) {
+            memcpy(bytes + live * size, bytes + i * size, size);
+        }
+        live++;
+    }
+    table->tombstones = 0;
+    table->savedCount = -1;
+    return live;
+}
+
+// Function to read the saved counter
+void loadIdSequence(IdSequence *sequence) {
+    int reservedEnd = 0;
+    int fd = open(FILENAME_IDS, O_RDONLY);
+    if (fd != -1) {
+        if (read(fd, &reservedEnd, sizeof(reservedEnd)) != sizeof(reservedEnd)) {
+            reservedEnd = 0;
+        }
+        close(fd);
     }
     
-    // Save medicines to file (new)
-    file = fopen(FILENAME_MEDICINES, "wb");
-    if (file != NULL) {
-        fwrite(medicines, sizeof(Medicine), medicineCount, file);
-        fclose(file);
+    sequence->next = reservedEnd > sequence->firstId ? reservedEnd : sequence->firstId;
+    sequence->reservedEnd = reservedEnd;
+}
+
+// Function to skip ids already used in a table, e.g. one saved before the counter
+void skipUsedIds(IdSequence *sequence, const TableFile *table, const void *records, int count) {
+    for (int i = 0; i < count; i++) {
+        int id;
+        memcpy(&id, (const unsigned char *)records + i * table->recordSize + table->idOffset, sizeof(id));
+        if (id != TOMBSTONE_ID && id >= sequence->next) {
+            sequence->next = id + 1;
+        }
     }
 }
 
+// Function to take the next id; the file is only written once per block
+int allocateId(IdSequence *sequence) {
+    if (sequence->next >= sequence->reservedEnd) {
+        int reservedEnd = sequence->next + ID_BLOCK_SIZE;
+        int fd = open(FILENAME_IDS, O_WRONLY | O_CREAT, 0644);
+        if (fd == -1) {
+            return -1;
+        }
+        bool ok = pwrite(fd, &reservedEnd, sizeof(reservedEnd), 0) == sizeof(reservedEnd);
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        if (!ok) {
+            return -1;
+        }
+        sequence->reservedEnd = reservedEnd;
+    }
+    return sequence->next++;
+}
+
 // Function to authenticate admin user
 int authenticateAdmin() {
     char username[50];
@@ -498,6 +836,9 @@ void receptionistMenu() {
 
 // Function to add a new patient
 void addPatient() {
+    if (patientCount >= MAX_PATIENTS && patientTable.tombstones > 0) {
+        patientCount = compactTable(&patientTable, patients, patientCount); // reuse deleted slots
+    }
     if (patientCount >= MAX_PATIENTS) {
         printf("Maximum number of patients reached!\n");
         return;
@@ -507,8 +848,11 @@ void addPatient() {
     
     printf("\nEnter patient details:\n");
     
-    // Generate a simple ID (starts from 1000)
-    newPatient.id = 1000 + patientCount; 
+    newPatient.id = allocateId(&recordIds);
+    if (newPatient.id == -1) {
+        printf("Could not reserve a new patient ID!\n");
+        return;
+    }
     
     printf("Name: ");
     fgets(newPatient.name, sizeof(newPatient.name), stdin);
@@ -544,6 +888,7 @@ void addPatient() {
     newPatient.medicalHistory[strcspn(newPatient.medicalHistory, "\n")] = '\0';
     
     // Add the new patient to the array and increment count
+    markDirty(&patientTable, patientCount);
     patients[patientCount++] = newPatient;
     
     printf("\nPatient added successfully!\n");
@@ -563,15 +908,28 @@ void displayAllPatients() {
            "ID", "Name", "Age", "Gen", "Phone", "Address");
     printf("------------------------------------------------------------------------\n");
     
+    int total = patientCount - patientTable.tombstones;
+    int shown = 0;
     for (int i = 0; i < patientCount; i++) {
-        printf("%-6d %-20s %-5d %-5c %-15s %-30s\n", 
-               patients[i].id,
-               patients[i].name,
-               patients[i].age,
-               patients[i].gender,
-               patients[i].phone,
-               patients[i].address); // Displaying address
-    }
+        if (patients[i].id == TOMBSTONE_ID) {
+            continue;
+        }
+        if (shown > 0 && shown % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(shown, total)) {
+                return;
+            }
+        }
+        tableInt(&tableOut, patients[i].id, 6);
+        tableText(&tableOut, patients[i].name, 20);
+        tableInt(&tableOut, patients[i].age, 5);
+        tableChar(&tableOut, patients[i].gender, 5);
+        tableText(&tableOut, patients[i].phone, 15);
+        tableText(&tableOut, patients[i].address, 0);
+        tableEndRow(&tableOut);
+        shown++;
+    }
+    tableFlush(&tableOut);
 }
 
 // Function to search for a patient
@@ -593,6 +951,9 @@ void searchPatient() {
     
     bool found = false;
     for (int i = 0; i < patientCount; i++) {
+        if (patients[i].id == TOMBSTONE_ID) {
+            continue;
+        }
         // Search by name (substring) or by ID (if input is numeric)
         if (strstr(patients[i].name, searchTerm) != NULL || 
             (isdigit(searchTerm[0]) && patients[i].id == atoi(searchTerm))) {
@@ -701,6 +1062,7 @@ void updatePatient() {
         strcpy(patients[index].medicalHistory, input);
     }
     
+    markDirty(&patientTable, index);
     printf("\nPatient record updated successfully!\n");
 }
 
@@ -726,17 +1088,16 @@ void deletePatient() {
     printf("Name: %s\n", patients[index].name);
     printf("ID: %d\n", patients[index].id);
     
-    // Shift elements to the left to overwrite the deleted patient
-    for (int i = index; i < patientCount - 1; i++) {
-        patients[i] = patients[i + 1];
-    }
-    patientCount--; // Decrement patient count
+    deleteRecord(&patientTable, patients, index);
     
     printf("\nPatient deleted successfully!\n");
 }
 
 // Function to add a new doctor
 void addDoctor() {
+    if (doctorCount >= MAX_DOCTORS && doctorTable.tombstones > 0) {
+        doctorCount = compactTable(&doctorTable, doctors, doctorCount); // reuse deleted slots
+    }
     if (doctorCount >= MAX_DOCTORS) {
         printf("Maximum number of doctors reached!\n");
         return;
@@ -746,8 +1107,11 @@ void addDoctor() {
     
     printf("\nEnter doctor details:\n");
     
-    // Generate a simple ID (starts from 2000)
-    newDoctor.id = 2000 + doctorCount; 
+    newDoctor.id = allocateId(&recordIds);
+    if (newDoctor.id == -1) {
+        printf("Could not reserve a new doctor ID!\n");
+        return;
+    }
     
     printf("Name: ");
     fgets(newDoctor.name, sizeof(newDoctor.name), stdin);
@@ -766,9 +1130,12 @@ void addDoctor() {
     newDoctor.schedule[strcspn(newDoctor.schedule, "\n")] = '\0';
     
     printf("Consultation Fee: "); // Updated field name
-    scanf("%d", &newDoctor.consultationFee);
-    clearInputBuffer();
+    if (!readMoney(&newDoctor.consultationFee) || newDoctor.consultationFee < 0) {
+        printf("Invalid fee, doctor not added!\n");
+        return;
+    }
     
+    markDirty(&doctorTable, doctorCount);
     doctors[doctorCount++] = newDoctor; // Add new doctor and increment count
     
     printf("\nDoctor added successfully!\n");
@@ -787,13 +1154,17 @@ void displayAllDoctors() {
            "ID", "Name", "Specialization", "Phone", "Fee", "Schedule"); // Updated header
     printf("----------------------------------------------------------------\n");
     
+    char fee[MONEY_TEXT_SIZE];
     for (int i = 0; i < doctorCount; i++) {
-        printf("%-6d %-20s %-20s %-15s $%-9d %s\n", 
+        if (doctors[i].id == TOMBSTONE_ID) {
+            continue;
+        }
+        printf("%-6d %-20s %-20s %-15s $%-9s %s\n", 
                doctors[i].id,
                doctors[i].name,
                doctors[i].specialization,
                doctors[i].phone,
-               doctors[i].consultationFee, // Updated field name
+               formatMoney(doctors[i].consultationFee, fee), // Updated field name
                doctors[i].schedule);      // Updated field name
     }
 }
@@ -816,17 +1187,21 @@ void searchDoctor() {
     printf("----------------------------------------------------------------\n");
     
     bool found = false;
+    char fee[MONEY_TEXT_SIZE];
     for (int i = 0; i < doctorCount; i++) {
+        if (doctors[i].id == TOMBSTONE_ID) {
+            continue;
+        }
         // Search by name, specialization (substrings), or by ID
         if (strstr(doctors[i].name, searchTerm) != NULL || 
             strstr(doctors[i].specialization, searchTerm) != NULL ||
             (isdigit(searchTerm[0]) && doctors[i].id == atoi(searchTerm))) {
-            printf("%-6d %-20s %-20s %-15s $%-9d %s\n", 
+            printf("%-6d %-20s %-20s %-15s $%-9s %s\n", 
                    doctors[i].id,
                    doctors[i].name,
                    doctors[i].specialization,
                    doctors[i].phone,
-                   doctors[i].consultationFee, // Updated field name
+                   formatMoney(doctors[i].consultationFee, fee), // Updated field name
                    doctors[i].schedule);      // Updated field name
             found = true;
         }
@@ -860,12 +1235,13 @@ void updateDoctor() {
     printf("Specialization: %s\n", doctors[index].specialization);
     printf("Phone: %s\n", doctors[index].phone);
     printf("Schedule: %s\n", doctors[index].schedule);           // Updated field
-    printf("Consultation Fee: %d\n", doctors[index].consultationFee); // Updated field name
+    char fee[MONEY_TEXT_SIZE];
+    printf("Consultation Fee: %s\n", formatMoney(doctors[index].consultationFee, fee)); // Updated field name
     
     printf("\nEnter new details (leave blank to keep current):\n");
     
     char input[100];
-    int intInput;
+    Money amountInput;
     
     printf("Name [%s]: ", doctors[index].name);
     fgets(input, sizeof(input), stdin);
@@ -895,13 +1271,18 @@ void updateDoctor() {
         strcpy(doctors[index].schedule, input);
     }
     
-    printf("Consultation Fee [%d]: ", doctors[index].consultationFee); // Update fee
-    // Check if scanf successfully read an integer
-    if (scanf("%d", &intInput) == 1) {
-        doctors[index].consultationFee = intInput;
+    printf("Consultation Fee [%s]: ", fee); // Update fee
+    fgets(input, sizeof(input), stdin);
+    input[strcspn(input, "\n")] = '\0';
+    if (strlen(input) > 0) {
+        if (parseMoney(input, &amountInput) && amountInput >= 0) {
+            doctors[index].consultationFee = amountInput;
+        } else {
+            printf("Invalid fee, keeping the current one.\n");
+        }
     }
-    clearInputBuffer();
     
+    markDirty(&doctorTable, index);
     printf("\nDoctor record updated successfully!\n");
 }
 
@@ -927,17 +1308,16 @@ void deleteDoctor() {
     printf("Name: %s\n", doctors[index].name);
     printf("ID: %d\n", doctors[index].id);
     
-    // Shift elements to the left to overwrite the deleted doctor
-    for (int i = index; i < doctorCount - 1; i++) {
-        doctors[i] = doctors[i + 1];
-    }
-    doctorCount--; // Decrement doctor count
+    deleteRecord(&doctorTable, doctors, index);
     
     printf("\nDoctor deleted successfully!\n");
 }
 
 // Function to add a new medicine (new)
 void addMedicine() {
+    if (medicineCount >= MAX_MEDICINES && medicineTable.tombstones > 0) {
+        medicineCount = compactTable(&medicineTable, medicines, medicineCount); // reuse deleted slots
+    }
     if (medicineCount >= MAX_MEDICINES) {
         printf("Maximum number of medicines reached!\n");
         return;
@@ -947,7 +1327,11 @@ void addMedicine() {
     
     printf("\nEnter medicine details:\n");
     
-    newMedicine.id = 3000 + medicineCount; // Simple ID generation for medicines
+    newMedicine.id = allocateId(&recordIds);
+    if (newMedicine.id == -1) {
+        printf("Could not reserve a new medicine ID!\n");
+        return;
+    }
     
     printf("Name: ");
     fgets(newMedicine.name, sizeof(newMedicine.name), stdin);
@@ -958,8 +1342,10 @@ void addMedicine() {
     newMedicine.manufacturer[strcspn(newMedicine.manufacturer, "\n")] = '\0';
     
     printf("Price: ");
-    scanf("%f", &newMedicine.price);
-    clearInputBuffer();
+    if (!readMoney(&newMedicine.price) || newMedicine.price < 0) {
+        printf("Invalid price, medicine not added!\n");
+        return;
+    }
     
     printf("Quantity: ");
     scanf("%d", &newMedicine.quantity);
@@ -969,6 +1355,7 @@ void addMedicine() {
     fgets(newMedicine.expiryDate, sizeof(newMedicine.expiryDate), stdin);
     newMedicine.expiryDate[strcspn(newMedicine.expiryDate, "\n")] = '\0';
     
+    markDirty(&medicineTable, medicineCount);
     medicines[medicineCount++] = newMedicine; // Add new medicine and increment count
     
     printf("\nMedicine added successfully!\n");
@@ -987,12 +1374,16 @@ void displayAllMedicines() {
            "ID", "Name", "Manufacturer", "Price", "Qty", "Expiry Date");
     printf("------------------------------------------------------------\n");
     
+    char price[MONEY_TEXT_SIZE];
     for (int i = 0; i < medicineCount; i++) {
-        printf("%-6d %-20s %-20s $%-9.2f %-8d %s\n", 
+        if (medicines[i].id == TOMBSTONE_ID) {
+            continue;
+        }
+        printf("%-6d %-20s %-20s $%-9s %-8d %s\n", 
                medicines[i].id,
                medicines[i].name,
                medicines[i].manufacturer,
-               medicines[i].price,
+               formatMoney(medicines[i].price, price),
                medicines[i].quantity,
                medicines[i].expiryDate);
     }
@@ -1016,14 +1407,18 @@ void searchMedicine() {
     printf("------------------------------------------------------------\n");
     
     bool found = false;
+    char price[MONEY_TEXT_SIZE];
     for (int i = 0; i < medicineCount; i++) {
+        if (medicines[i].id == TOMBSTONE_ID) {
+            continue;
+        }
         if (strstr(medicines[i].name, searchTerm) != NULL || 
             (isdigit(searchTerm[0]) && medicines[i].id == atoi(searchTerm))) {
-            printf("%-6d %-20s %-20s $%-9.2f %-8d %s\n", 
+            printf("%-6d %-20s %-20s $%-9s %-8d %s\n", 
                    medicines[i].id,
                    medicines[i].name,
                    medicines[i].manufacturer,
-                   medicines[i].price,
+                   formatMoney(medicines[i].price, price),
                    medicines[i].quantity,
                    medicines[i].expiryDate);
             found = true;
@@ -1056,14 +1451,15 @@ void updateMedicine() {
     printf("\nCurrent medicine details:\n");
     printf("Name: %s\n", medicines[index].name);
     printf("Manufacturer: %s\n", medicines[index].manufacturer);
-    printf("Price: %.2f\n", medicines[index].price);
+    char price[MONEY_TEXT_SIZE];
+    printf("Price: %s\n", formatMoney(medicines[index].price, price));
     printf("Quantity: %d\n", medicines[index].quantity);
     printf("Expiry Date: %s\n", medicines[index].expiryDate);
     
     printf("\nEnter new details (leave blank to keep current):\n");
     
     char input[100];
-    float floatInput;
+    Money amountInput;
     int intInput;
     
     printf("Name [%s]: ", medicines[index].name);
@@ -1080,11 +1476,16 @@ void updateMedicine() {
         strcpy(medicines[index].manufacturer, input);
     }
     
-    printf("Price [%.2f]: ", medicines[index].price);
-    if (scanf("%f", &floatInput) == 1) {
-        medicines[index].price = floatInput;
+    printf("Price [%s]: ", price);
+    fgets(input, sizeof(input), stdin);
+    input[strcspn(input, "\n")] = '\0';
+    if (strlen(input) > 0) {
+        if (parseMoney(input, &amountInput) && amountInput >= 0) {
+            medicines[index].price = amountInput;
+        } else {
+            printf("Invalid price, keeping the current one.\n");
+        }
     }
-    clearInputBuffer();
     
     printf("Quantity [%d]: ", medicines[index].quantity);
     if (scanf("%d", &intInput) == 1) {
@@ -1099,6 +1500,7 @@ void updateMedicine() {
         strcpy(medicines[index].expiryDate, input);
     }
     
+    markDirty(&medicineTable, index);
     printf("\nMedicine record updated successfully!\n");
 }
 
@@ -1132,11 +1534,7 @@ void deleteMedicine() {
     clearInputBuffer();
     
     if (tolower(confirm) == 'y') {
-        // Shift all medicines after this one forward
-        for (int i = index; i < medicineCount - 1; i++) {
-            medicines[i] = medicines[i + 1];
-        }
-        medicineCount--; // Decrement medicine count
+        deleteRecord(&medicineTable, medicines, index);
         printf("\nMedicine deleted successfully!\n");
     } else {
         printf("\nMedicine deletion cancelled.\n");
@@ -1159,8 +1557,11 @@ void scheduleAppointment() {
     
     printf("\nEnter appointment details:\n");
     
-    // Generate a simple ID (starts from 4000 for appointments now, to avoid conflict with medicines)
-    newAppointment.id = 4000 + appointmentCount; 
+    newAppointment.id = allocateId(&recordIds);
+    if (newAppointment.id == -1) {
+        printf("Could not reserve a new appointment ID!\n");
+        return;
+    }
     
     printf("Patient ID: ");
     scanf("%d", &newAppointment.patientId);
@@ -1198,6 +1599,7 @@ void scheduleAppointment() {
     newAppointment.fee = doctors[doctorIndex].consultationFee; // Set initial fee from doctor's consultation fee
     strcpy(newAppointment.status, "Scheduled"); // Default status for new appointments
     
+    markDirty(&appointmentTable, appointmentCount);
     appointments[appointmentCount++] = newAppointment; // Add new appointment and increment count
     
     printf("\nAppointment scheduled successfully!\n");
@@ -1217,30 +1619,27 @@ void viewAppointments() {
     printf("------------------------------------------------------------------------------------------------\n");
     
     for (int i = 0; i < appointmentCount; i++) {
+        if (i > 0 && i % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(i, appointmentCount)) {
+                return;
+            }
+        }
         int patientIndex = findPatientById(appointments[i].patientId);
         int doctorIndex = findDoctorById(appointments[i].doctorId);
         
-        // Get patient and doctor names, default to "Unknown" if not found (e.g., if deleted)
-        char patientName[50] = "Unknown";
-        char doctorName[50] = "Unknown";
-        
-        if (patientIndex != -1) {
-            strcpy(patientName, patients[patientIndex].name);
-        }
-        if (doctorIndex != -1) {
-            strcpy(doctorName, doctors[doctorIndex].name);
-        }
-
-        printf("%-6d %-8d %-20s %-20s %-12s %-8s $%-9.2f %s\n", // Format fee as float
-               appointments[i].id,
-               appointments[i].patientId,
-               patientName,
-               doctorName,
-               appointments[i].date,
-               appointments[i].time,
-               appointments[i].fee, // Display appointment fee
-               appointments[i].status);
-    }
+        // Show "Unknown" for a patient or doctor that no longer exists
+        tableInt(&tableOut, appointments[i].id, 6);
+        tableInt(&tableOut, appointments[i].patientId, 8);
+        tableText(&tableOut, patientIndex != -1 ? patients[patientIndex].name : "Unknown", 20);
+        tableText(&tableOut, doctorIndex != -1 ? doctors[doctorIndex].name : "Unknown", 20);
+        tableText(&tableOut, appointments[i].date, 12);
+        tableText(&tableOut, appointments[i].time, 8);
+        tableMoney(&tableOut, appointments[i].fee, 10);
+        tableText(&tableOut, appointments[i].status, 0);
+        tableEndRow(&tableOut);
+    }
+    tableFlush(&tableOut);
 }
 
 // Function for doctor to complete an appointment (new)
@@ -1271,6 +1670,7 @@ void completeAppointment(int appointmentId) {
 
     // Update status to Completed
     strcpy(appointments[index].status, "Completed");
+    markDirty(&appointmentTable, index);
     printf("\nAppointment ID %d completed successfully!\n", appointmentId);
 }
 
@@ -1307,6 +1707,7 @@ void cancelAppointment() {
     if (tolower(confirm) == 'y') {
         // Change status to cancelled instead of deleting the record entirely
         strcpy(appointments[index].status, "Cancelled"); 
+        markDirty(&appointmentTable, index);
         printf("\nAppointment cancelled successfully!\n");
     } else {
         printf("\nAppointment cancellation aborted.\n");
@@ -1344,16 +1745,17 @@ void generateBill(int appointmentId) {
     printf("Patient Name: %s (ID: %d)\n", patientName, appointments[index].patientId);
     printf("Doctor Name: %s (ID: %d)\n", doctorName, appointments[index].doctorId);
     printf("----------------------------------------\n");
-    printf("Consultation Fee: $%.2f\n", doctors[doctorIndex].consultationFee); // Get fee from doctor record
+    char amount[MONEY_TEXT_SIZE];
+    printf("Consultation Fee: $%s\n", formatMoney(doctors[doctorIndex].consultationFee, amount)); // Get fee from doctor record
 
     // Here you could add logic to parse the prescription and add medicine costs
     // For simplicity, we'll just display a placeholder total for now.
-    float totalBill = doctors[doctorIndex].consultationFee;
+    Money totalBill = doctors[doctorIndex].consultationFee;
     
     // Basic medicine cost estimation (you would typically parse the prescription for actual medicines)
     // For now, let's assume a fixed "medicine charge" if prescription is not "N/A"
     if (strcmp(appointments[index].prescription, "N/A") != 0 && strlen(appointments[index].prescription) > 0) {
-        float medicineCharge = 0.0;
+        Money medicineCharge = 0;
         printf("Prescription: %s\n", appointments[index].prescription);
         printf("Do you want to add medicine charges to the bill? (y/n): ");
         char choice;
@@ -1361,18 +1763,21 @@ void generateBill(int appointmentId) {
         clearInputBuffer();
         if (tolower(choice) == 'y') {
             printf("Enter estimated medicine cost: $");
-            scanf("%f", &medicineCharge);
-            clearInputBuffer();
-            totalBill += medicineCharge;
-            printf("Medicine Charge: $%.2f\n", medicineCharge);
+            if (!readMoney(&medicineCharge) || medicineCharge < 0 ||
+                !moneyAdd(totalBill, medicineCharge, &totalBill)) {
+                printf("Invalid medicine cost, bill not generated!\n");
+                return;
+            }
+            printf("Medicine Charge: $%s\n", formatMoney(medicineCharge, amount));
         }
     }
 
     printf("----------------------------------------\n");
-    printf("Total Amount Due: $%.2f\n", totalBill);
+    printf("Total Amount Due: $%s\n", formatMoney(totalBill, amount));
     printf("========================================\n");
     // Update the appointment's stored fee with the final calculated bill amount
     appointments[index].fee = totalBill; 
+    markDirty(&appointmentTable, index);
     printf("Bill generated. Total fee updated in appointment record.\n");
 }
 
@@ -1460,6 +1865,9 @@ void viewPatientHistory(int patientId) {
 
 // Helper function to find a patient by ID and return their index
 int findPatientById(int id) {
+    if (id == TOMBSTONE_ID) {
+        return -1; // a deleted record has no id
+    }
     for (int i = 0; i < patientCount; i++) {
         if (patients[i].id == id) {
             return i; // Return index if found
@@ -1470,6 +1878,9 @@ int findPatientById(int id) {
 
 // Helper function to find a doctor by ID and return their index
 int findDoctorById(int id) {
+    if (id == TOMBSTONE_ID) {
+        return -1; // a deleted record has no id
+    }
     for (int i = 0; i < doctorCount; i++) {
         if (doctors[i].id == id) {
             return i; // Return index if found
@@ -1490,6 +1901,9 @@ int findAppointmentById(int id) {
 
 // Helper function to find a medicine by ID and return its index (new)
 int findMedicineById(int id) {
+    if (id == TOMBSTONE_ID) {
+        return -1; // a deleted record has no id
+    }
     for (int i = 0; i < medicineCount; i++) {
         if (medicines[i].id == id) {
             return i; // Return index if found
@@ -1503,3 +1917,171 @@ void clearInputBuffer() {
     int c;
     while ((c = getchar()) != '\n' && c != EOF);
 }
+
+// Function to add one column, flushing first when the buffer is full
+void tableText(TableBuffer *out, const char *text, int width) {
+    size_t length = strlen(text);
+    size_t padded = length < (size_t)width ? (size_t)width : length;
+    if (out->length + padded + 1 > sizeof(out->data)) {
+        tableFlush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    memset(out->data + out->length + length, ' ', padded - length + 1);
+    out->length += padded + 1;
+}
+
+void tableInt(TableBuffer *out, long long value, int width) {
+    char digits[24];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    *--cursor = '\0';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    tableText(out, cursor, width);
+}
+
+void tableChar(TableBuffer *out, char value, int width) {
+    char text[2] = { value, '\0' };
+    tableText(out, text, width);
+}
+
+// Function to finish a row with a newline
+void tableEndRow(TableBuffer *out) {
+    if (out->length > 0) {
+        out->data[out->length - 1] = '\n';
+    }
+}
+
+void tableFlush(TableBuffer *out) {
+    fflush(stdout); // keep earlier printf output in order
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t result = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    out->length = 0;
+}
+
+bool nextPage(int shown, int total) {
+    printf("-- %d of %d shown, Enter for more, q to stop -- ", shown, total);
+    char line[16];
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(line, '\n') == NULL && !feof(stdin)) {
+        clearInputBuffer();
+    }
+    return line[0] != 'q' && line[0] != 'Q';
+}
+
+void tableMoney(TableBuffer *out, Money amount, int width) {
+    char text[MONEY_TEXT_SIZE + 1] = "$";
+    formatMoney(amount, text + 1);
+    tableText(out, text, width);
+}
+
+// Overflow-checked addition; *result is left untouched on overflow
+bool moneyAdd(Money a, Money b, Money *result) {
+    Money sum;
+    if (__builtin_add_overflow(a, b, &sum)) {
+        return false;
+    }
+    *result = sum;
+    return true;
+}
+
+// Accepts an optional sign, digits and at most two decimals ("150", "12.5")
+bool parseMoney(const char *text, Money *amount) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    bool negative = *text == '-';
+    if (*text == '-' || *text == '+') {
+        text++;
+    }
+    
+    Money value = 0;
+    int digits = 0;
+    for (; isdigit((unsigned char)*text); text++, digits++) {
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            __builtin_add_overflow(value, *text - '0', &value)) {
+            return false;
+        }
+    }
+    
+    int decimals = 0;
+    if (*text == '.') {
+        for (text++; isdigit((unsigned char)*text); text++, decimals++) {
+            if (decimals == 2) {
+                return false; // sub-cent amounts are not representable
+            }
+            if (__builtin_mul_overflow(value, 10, &value) ||
+                __builtin_add_overflow(value, *text - '0', &value)) {
+                return false;
+            }
+        }
+    }
+    if (digits == 0 && decimals == 0) {
+        return false;
+    }
+    for (; decimals < 2; decimals++) {
+        if (__builtin_mul_overflow(value, 10, &value)) {
+            return false;
+        }
+    }
+    
+    while (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n') {
+        text++;
+    }
+    if (*text != '\0') {
+        return false;
+    }
+    *amount = negative ? -value : value;
+    return true;
+}
+
+// Reads a whole input line and parses it as an amount
+bool readMoney(Money *amount) {
+    char text[32];
+    if (fgets(text, sizeof(text), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(text, '\n') == NULL) {
+        clearInputBuffer(); // line longer than any valid amount
+        return false;
+    }
+    return parseMoney(text, amount);
+}
+
+// Writes the amount as "1234.56" into buffer (MONEY_TEXT_SIZE bytes) and returns it
+char *formatMoney(Money amount, char *buffer) {
+    char digits[MONEY_TEXT_SIZE];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = amount < 0 ? 0ULL - (unsigned long long)amount : (unsigned long long)amount;
+    
+    *--cursor = '\0';
+    *--cursor = '0' + magnitude % 10;
+    magnitude /= 10;
+    *--cursor = '0' + magnitude % 10;
+    magnitude /= 10;
+    *--cursor = '.';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (amount < 0) {
+        *--cursor = '-';
+    }
+    
+    memcpy(buffer, cursor, digits + sizeof(digits) - cursor);
+    return buffer;
+}
@@ -4,6 +4,9 @@
 #include <time.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 // Define maximum capacities for patients, doctors, and appointments
 #define MAX_PATIENTS 100
@@ -15,9 +18,18 @@
 #define FILENAME_DOCTORS "doctors.dat"
 #define FILENAME_APPOINTMENTS "appointments.dat"
 
+// Deleted records keep their slot with this id until the table is compacted
+#define TOMBSTONE_ID 0
+
+// Next-id counter; each write reserves ID_BLOCK_SIZE ids
+#define FILENAME_IDS "hospital_ids.dat"
+#define ID_BLOCK_SIZE 32
+
 // Admin credentials for system login
 #define ADMIN_USERNAME "admin"
 #define ADMIN_PASSWORD "admin123"
+#define TABLE_BUFFER_SIZE 65536 // formatted rows handed to each write()
+#define PAGE_ROWS 20 // rows per page in list views
 
 // Structure to hold patient information
 typedef struct {
@@ -55,6 +67,30 @@ typedef struct {
     char status[20]; // "Scheduled", "Completed", "Cancelled"
 } Appointment;
 
+// Structure to track unsaved changes to one table
+typedef struct {
+    const char *filename;
+    size_t recordSize;
+    int savedCount; // Records in the file, -1 to rewrite it
+    bool *dirty;    // Records changed since the last save
+    size_t idOffset; // Id field, TOMBSTONE_ID marks a deleted record
+    int tombstones;  // Deleted records not yet compacted
+} TableFile;
+
+// Structure to hand out record ids; one counter serves all tables and an id
+// is never given out twice, even after a delete
+typedef struct {
+    int firstId;     // First id on a fresh install
+    int next;        // Next id to hand out
+    int reservedEnd; // Ids below this are reserved on disk
+} IdSequence;
+
+// Structure to collect list rows for a single write()
+typedef struct {
+    char data[TABLE_BUFFER_SIZE];
+    size_t length;
+} TableBuffer;
+
 // Global arrays to store data in memory
 Patient patients[MAX_PATIENTS];
 Doctor doctors[MAX_DOCTORS];
@@ -65,11 +101,32 @@ int patientCount = 0;
 int doctorCount = 0;
 int appointmentCount = 0;
 
+// Dirty flags and file bookkeeping for incremental saves
+bool patientDirty[MAX_PATIENTS];
+bool doctorDirty[MAX_DOCTORS];
+bool appointmentDirty[MAX_APPOINTMENTS];
+TableFile patientTable = { FILENAME_PATIENTS, sizeof(Patient), -1, patientDirty, offsetof(Patient, id), 0 };
+TableFile doctorTable = { FILENAME_DOCTORS, sizeof(Doctor), -1, doctorDirty, offsetof(Doctor, id), 0 };
+TableFile appointmentTable = { FILENAME_APPOINTMENTS, sizeof(Appointment), -1, appointmentDirty, offsetof(Appointment, id), 0 };
+
+// Id counter for new records
+IdSequence recordIds = { 1000, 0, 0 };
+TableBuffer tableOut; // shared by all list views
+
 // --- Function Prototypes ---
 
 // Data management functions
 void loadData(); // Loads data from binary files into memory
 void saveData(); // Saves data from memory to binary files
+int loadTable(TableFile *table, void *records, int maxRecords); // Reads one table file
+void markDirty(TableFile *table, int index); // Flags a record for the next save
+void saveTable(TableFile *table, const void *records, int count); // Writes changed records only
+bool isTombstone(const TableFile *table, const void *records, int index); // True for a deleted slot
+void deleteRecord(TableFile *table, void *records, int index); // Tombstones a record in place
+int compactTable(TableFile *table, void *records, int count); // Drops tombstones, returns the new count
+void loadIdSequence(IdSequence *sequence); // Restores the counter
+void skipUsedIds(IdSequence *sequence, const TableFile *table, const void *records, int count); // Moves it past a table's ids
+int allocateId(IdSequence *sequence); // Next unused id, or -1 if it cannot be reserved
 
 // Authentication and menu functions
 int authenticateAdmin(); // Authenticates the admin user
@@ -109,6 +166,12 @@ int findAppointmentById(int id); // Finds an appointment's index by its ID
 
 // Utility functions
 void clearInputBuffer(); // Clears the standard input buffer
+void tableText(TableBuffer *out, const char *text, int width); // Appends a left-aligned column
+void tableInt(TableBuffer *out, long long value, int width); // Appends an integer column
+void tableChar(TableBuffer *out, char value, int width); // Appends a one-character column
+void tableEndRow(TableBuffer *out); // Terminates the current row
+void tableFlush(TableBuffer *out); // Writes the buffered rows with one write()
+bool nextPage(int shown, int total); // Asks whether to show the next page of a list
 void printWelcomeArt();  // Prints ASCII art for welcome message
 
 // --- Helper Menu Functions (for better menu navigation) ---
@@ -149,56 +212,185 @@ void printWelcomeArt() {
 
 // Function to load data from binary files
 void loadData() {
-    FILE *file;
-    
-    // Load patients from file
-    file = fopen(FILENAME_PATIENTS, "rb");
-    if (file != NULL) {
-        patientCount = fread(patients, sizeof(Patient), MAX_PATIENTS, file);
-        fclose(file);
+    patientCount = loadTable(&patientTable, patients, MAX_PATIENTS);
+    doctorCount = loadTable(&doctorTable, doctors, MAX_DOCTORS);
+    appointmentCount = loadTable(&appointmentTable, appointments, MAX_APPOINTMENTS);
+    loadIdSequence(&recordIds);
+    skipUsedIds(&recordIds, &patientTable, patients, patientCount);
+    skipUsedIds(&recordIds, &doctorTable, doctors, doctorCount);
+    skipUsedIds(&recordIds, &appointmentTable, appointments, appointmentCount);
+}
+
+// Function to save data to binary files
+void saveData() {
+    if (patientTable.tombstones * 4 > patientCount) {
+        patientCount = compactTable(&patientTable, patients, patientCount);
     }
-    
-    // Load doctors from file
-    file = fopen(FILENAME_DOCTORS, "rb");
-    if (file != NULL) {
-        doctorCount = fread(doctors, sizeof(Doctor), MAX_DOCTORS, file);
-        fclose(file);
+    saveTable(&patientTable, patients, patientCount);
+    if (doctorTable.tombstones * 4 > doctorCount) {
+        doctorCount = compactTable(&doctorTable, doctors, doctorCount);
     }
-    
-    // Load appointments from file
-    file = fopen(FILENAME_APPOINTMENTS, "rb");
-    if (file != NULL) {
-        appointmentCount = fread(appointments, sizeof(Appointment), MAX_APPOINTMENTS, file);
-        fclose(file);
+    saveTable(&doctorTable, doctors, doctorCount);
+    saveTable(&appointmentTable, appointments, appointmentCount);
+}
+
+// Function to load one table from its file
+int loadTable(TableFile *table, void *records, int maxRecords) {
+    FILE *file = fopen(table->filename, "rb");
+    if (file == NULL) {
+        table->savedCount = -1;
+        return 0;
+    }
+    
+    int count = fread(records, table->recordSize, maxRecords, file);
+    table->savedCount = fgetc(file) == EOF ? count : -1;
+    fclose(file);
+    
+    table->tombstones = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            table->tombstones++;
+        }
     }
+    return count;
 }
 
-// Function to save data to binary files
-void saveData() {
-    FILE *file;
+void markDirty(TableFile *table, int index) {
+    table->dirty[index] = true;
+}
+
+// Function to save one table, writing only the changed records
+void saveTable(TableFile *table, const void *records, int count) {
+    const unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    
+    int fd = -1;
+    if (table->savedCount >= 0 && count >= table->savedCount) {
+        fd = open(table->filename, O_WRONLY);
+    }
+    if (fd != -1) {
+        bool ok = true;
+        int i = 0;
+        while (i < count && ok) {
+            if (i < table->savedCount && !table->dirty[i]) {
+                i++;
+                continue;
+            }
+            
+            int end = i + 1;
+            while (end < count && (end >= table->savedCount || table->dirty[end])) {
+                end++;
+            }
+            size_t length = (end - i) * size;
+            ok = pwrite(fd, bytes + i * size, length, (off_t)i * size) == (ssize_t)length;
+            i = end;
+        }
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        
+        if (ok) {
+            memset(table->dirty, 0, count * sizeof(bool));
+            table->savedCount = count;
+            return;
+        }
+    }
     
-    // Save patients to file
-    file = fopen(FILENAME_PATIENTS, "wb");
-    if (file != NULL) {
-        fwrite(patients, sizeof(Patient), patientCount, file);
-        fclose(file);
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", table->filename);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return;
+    }
+    fwrite(records, size, count, file);
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempName, table->filename) != 0) {
+        remove(tempName);
+        return;
     }
     
-    // Save doctors to file
-    file = fopen(FILENAME_DOCTORS, "wb");
-    if (file != NULL) {
-        fwrite(doctors, sizeof(Doctor), doctorCount, file);
-        fclose(file);
+    memset(table->dirty, 0, count * sizeof(bool));
+    table->savedCount = count;
+}
+
+bool isTombstone(const TableFile *table, const void *records, int index) {
+    int id;
+    memcpy(&id, (const unsigned char *)records + index * table->recordSize + table->idOffset, sizeof(id));
+    return id == TOMBSTONE_ID;
+}
+
+// Function to mark a record as deleted
+void deleteRecord(TableFile *table, void *records, int index) {
+    int id = TOMBSTONE_ID;
+    memcpy((unsigned char *)records + index * table->recordSize + table->idOffset, &id, sizeof(id));
+    table->tombstones++;
+    markDirty(table, index);
+}
+
+// Function to remove deleted records from a table
+int compactTable(TableFile *table, void *records, int count) {
+    unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    int live = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            continue;
+        }
+        if (live != i) {
+            memcpy(bytes + live * size, bytes + i * size, size);
+        }
+        live++;
+    }
+    table->tombstones = 0;
+    table->savedCount = -1;
+    return live;
+}
+
+// Function to load the id counter
+void loadIdSequence(IdSequence *sequence) {
+    int reservedEnd = 0;
+    int fd = open(FILENAME_IDS, O_RDONLY);
+    if (fd != -1) {
+        if (read(fd, &reservedEnd, sizeof(reservedEnd)) != sizeof(reservedEnd)) {
+            reservedEnd = 0;
+        }
+        close(fd);
     }
     
-    // Save appointments to file
-    file = fopen(FILENAME_APPOINTMENTS, "wb");
-    if (file != NULL) {
-        fwrite(appointments, sizeof(Appointment), appointmentCount, file);
-        fclose(file);
+    sequence->next = reservedEnd > sequence->firstId ? reservedEnd : sequence->firstId;
+    sequence->reservedEnd = reservedEnd;
+}
+
+// Function to keep the counter above the ids already in a table
+void skipUsedIds(IdSequence *sequence, const TableFile *table, const void *records, int count) {
+    for (int i = 0; i < count; i++) {
+        int id;
+        memcpy(&id, (const unsigned char *)records + i * table->recordSize + table->idOffset, sizeof(id));
+        if (id != TOMBSTONE_ID && id >= sequence->next) {
+            sequence->next = id + 1;
+        }
     }
 }
 
+// Function to get a new id, reserving a block of them on disk when needed
+int allocateId(IdSequence *sequence) {
+    if (sequence->next >= sequence->reservedEnd) {
+        int reservedEnd = sequence->next + ID_BLOCK_SIZE;
+        int fd = open(FILENAME_IDS, O_WRONLY | O_CREAT, 0644);
+        if (fd == -1) {
+            return -1;
+        }
+        bool ok = pwrite(fd, &reservedEnd, sizeof(reservedEnd), 0) == sizeof(reservedEnd);
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        if (!ok) {
+            return -1;
+        }
+        sequence->reservedEnd = reservedEnd;
+    }
+    return sequence->next++;
+}
+
 // Function to authenticate admin user
 int authenticateAdmin() {
     char username[50];
@@ -477,6 +669,9 @@ void patientMenu(int patientId) {
 
 // Function to add a new patient
 void addPatient() {
+    if (patientCount >= MAX_PATIENTS && patientTable.tombstones > 0) {
+        patientCount = compactTable(&patientTable, patients, patientCount); // make room from deleted slots
+    }
     if (patientCount >= MAX_PATIENTS) {
         printf("Maximum number of patients reached!\n");
         return;
@@ -486,8 +681,11 @@ void addPatient() {
     
     printf("\nEnter patient details:\n");
     
-    // Generate a simple ID (starts from 1000)
-    newPatient.id = 1000 + patientCount; 
+    newPatient.id = allocateId(&recordIds);
+    if (newPatient.id == -1) {
+        printf("Could not reserve a new patient ID!\n");
+        return;
+    }
     
     printf("Name: ");
     fgets(newPatient.name, sizeof(newPatient.name), stdin);
@@ -523,6 +721,7 @@ void addPatient() {
     newPatient.medicalHistory[strcspn(newPatient.medicalHistory, "\n")] = '\0';
     
     // Add the new patient to the array and increment count
+    markDirty(&patientTable, patientCount);
     patients[patientCount++] = newPatient;
     
     printf("\nPatient added successfully!\n");
@@ -541,15 +740,28 @@ void displayAllPatients() {
            "ID", "Name", "Age", "Gen", "Phone", "Email");
     printf("------------------------------------------------------------------------\n");
     
+    int total = patientCount - patientTable.tombstones;
+    int shown = 0;
     for (int i = 0; i < patientCount; i++) {
-        printf("%-6d %-20s %-5d %-5c %-15s %-30s\n", 
-               patients[i].id,
-               patients[i].name,
-               patients[i].age,
-               patients[i].gender,
-               patients[i].phone,
-               patients[i].email);
-    }
+        if (patients[i].id == TOMBSTONE_ID) {
+            continue;
+        }
+        if (shown > 0 && shown % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(shown, total)) {
+                return;
+            }
+        }
+        tableInt(&tableOut, patients[i].id, 6);
+        tableText(&tableOut, patients[i].name, 20);
+        tableInt(&tableOut, patients[i].age, 5);
+        tableChar(&tableOut, patients[i].gender, 5);
+        tableText(&tableOut, patients[i].phone, 15);
+        tableText(&tableOut, patients[i].email, 0);
+        tableEndRow(&tableOut);
+        shown++;
+    }
+    tableFlush(&tableOut);
 }
 
 // Function to search for a patient
@@ -571,6 +783,9 @@ void searchPatient() {
     
     bool found = false;
     for (int i = 0; i < patientCount; i++) {
+        if (patients[i].id == TOMBSTONE_ID) {
+            continue;
+        }
         // Search by name (substring) or by ID (if input is numeric)
         if (strstr(patients[i].name, searchTerm) != NULL || 
             (isdigit(searchTerm[0]) && patients[i].id == atoi(searchTerm))) {
@@ -679,6 +894,7 @@ void updatePatient() {
         strcpy(patients[index].medicalHistory, input);
     }
     
+    markDirty(&patientTable, index);
     printf("\nPatient record updated successfully!\n");
 }
 
@@ -704,17 +920,16 @@ void deletePatient() {
     printf("Name: %s\n", patients[index].name);
     printf("ID: %d\n", patients[index].id);
     
-    // Shift elements to the left to overwrite the deleted patient
-    for (int i = index; i < patientCount - 1; i++) {
-        patients[i] = patients[i + 1];
-    }
-    patientCount--; // Decrement patient count
+    deleteRecord(&patientTable, patients, index);
     
     printf("\nPatient deleted successfully!\n");
 }
 
 // Function to add a new doctor
 void addDoctor() {
+    if (doctorCount >= MAX_DOCTORS && doctorTable.tombstones > 0) {
+        doctorCount = compactTable(&doctorTable, doctors, doctorCount); // make room from deleted slots
+    }
     if (doctorCount >= MAX_DOCTORS) {
         printf("Maximum number of doctors reached!\n");
         return;
@@ -724,8 +939,11 @@ void addDoctor() {
     
     printf("\nEnter doctor details:\n");
     
-    // Generate a simple ID (starts from 2000)
-    newDoctor.id = 2000 + doctorCount; 
+    newDoctor.id = allocateId(&recordIds);
+    if (newDoctor.id == -1) {
+        printf("Could not reserve a new doctor ID!\n");
+        return;
+    }
     
     printf("Name: ");
     fgets(newDoctor.name, sizeof(newDoctor.name), stdin);
@@ -755,6 +973,7 @@ void addDoctor() {
     scanf("%d", &newDoctor.fee);
     clearInputBuffer();
     
+    markDirty(&doctorTable, doctorCount);
     doctors[doctorCount++] = newDoctor; // Add new doctor and increment count
     
     printf("\nDoctor added successfully!\n");
@@ -774,6 +993,9 @@ void displayAllDoctors() {
     printf("--------------------------------------------------------------------------------\n");
     
     for (int i = 0; i < doctorCount; i++) {
+        if (doctors[i].id == TOMBSTONE_ID) {
+            continue;
+        }
         printf("%-6d %-20s %-20s %-15s $%-9d %-15s %s\n", 
                doctors[i].id,
                doctors[i].name,
@@ -804,6 +1026,9 @@ void searchDoctor() {
     
     bool found = false;
     for (int i = 0; i < doctorCount; i++) {
+        if (doctors[i].id == TOMBSTONE_ID) {
+            continue;
+        }
         // Search by name, specialization (substrings), or by ID
         if (strstr(doctors[i].name, searchTerm) != NULL || 
             strstr(doctors[i].specialization, searchTerm) != NULL ||
@@ -906,6 +1131,7 @@ void updateDoctor() {
     }
     clearInputBuffer();
     
+    markDirty(&doctorTable, index);
     printf("\nDoctor record updated successfully!\n");
 }
 
@@ -931,11 +1157,7 @@ void deleteDoctor() {
     printf("Name: %s\n", doctors[index].name);
     printf("ID: %d\n", doctors[index].id);
     
-    // Shift elements to the left to overwrite the deleted doctor
-    for (int i = index; i < doctorCount - 1; i++) {
-        doctors[i] = doctors[i + 1];
-    }
-    doctorCount--; // Decrement doctor count
+    deleteRecord(&doctorTable, doctors, index);
     
     printf("\nDoctor deleted successfully!\n");
 }
@@ -956,8 +1178,11 @@ void scheduleAppointment() {
     
     printf("\nEnter appointment details:\n");
     
-    // Generate a simple ID (starts from 3000)
-    newAppointment.id = 3000 + appointmentCount; 
+    newAppointment.id = allocateId(&recordIds);
+    if (newAppointment.id == -1) {
+        printf("Could not reserve a new appointment ID!\n");
+        return;
+    }
     
     printf("Patient ID: ");
     scanf("%d", &newAppointment.patientId);
@@ -993,6 +1218,7 @@ void scheduleAppointment() {
     
     strcpy(newAppointment.status, "Scheduled"); // Default status for new appointments
     
+    markDirty(&appointmentTable, appointmentCount);
     appointments[appointmentCount++] = newAppointment; // Add new appointment and increment count
     
     printf("\nAppointment scheduled successfully!\n");
@@ -1012,30 +1238,27 @@ void viewAppointments() {
     printf("------------------------------------------------------------------------------------------------\n");
     
     for (int i = 0; i < appointmentCount; i++) {
+        if (i > 0 && i % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(i, appointmentCount)) {
+                return;
+            }
+        }
         int patientIndex = findPatientById(appointments[i].patientId);
         int doctorIndex = findDoctorById(appointments[i].doctorId);
         
-        // Get patient and doctor names, default to "Unknown" if not found (e.g., if deleted)
-        char patientName[50] = "Unknown";
-        char doctorName[50] = "Unknown";
-        
-        if (patientIndex != -1) {
-            strcpy(patientName, patients[patientIndex].name);
-        }
-        if (doctorIndex != -1) {
-            strcpy(doctorName, doctors[doctorIndex].name);
-        }
-
-        printf("%-6d %-8d %-20s %-20s %-12s %-8s %-20s %s\n", 
-               appointments[i].id,
-               appointments[i].patientId,
-               patientName,
-               doctorName,
-               appointments[i].date,
-               appointments[i].time,
-               appointments[i].purpose,
-               appointments[i].status);
-    }
+        // Show "Unknown" for a patient or doctor that no longer exists
+        tableInt(&tableOut, appointments[i].id, 6);
+        tableInt(&tableOut, appointments[i].patientId, 8);
+        tableText(&tableOut, patientIndex != -1 ? patients[patientIndex].name : "Unknown", 20);
+        tableText(&tableOut, doctorIndex != -1 ? doctors[doctorIndex].name : "Unknown", 20);
+        tableText(&tableOut, appointments[i].date, 12);
+        tableText(&tableOut, appointments[i].time, 8);
+        tableText(&tableOut, appointments[i].purpose, 20);
+        tableText(&tableOut, appointments[i].status, 0);
+        tableEndRow(&tableOut);
+    }
+    tableFlush(&tableOut);
 }
 
 // Function to update the status of an appointment
@@ -1076,6 +1299,7 @@ void updateAppointmentStatus() {
         strcmp(newStatus, "Completed") == 0 || 
         strcmp(newStatus, "Cancelled") == 0) {
         strcpy(appointments[index].status, newStatus);
+        markDirty(&appointmentTable, index);
         printf("\nAppointment status updated successfully!\n");
     } else {
         printf("\nInvalid status. No changes made. Please use 'Scheduled', 'Completed', or 'Cancelled'.\n");
@@ -1109,6 +1333,7 @@ void cancelAppointment() {
     // Shift elements to the left to remove the cancelled appointment
     for (int i = index; i < appointmentCount - 1; i++) {
         appointments[i] = appointments[i + 1];
+        markDirty(&appointmentTable, i);
     }
     appointmentCount--; // Decrement appointment count
     
@@ -1196,6 +1421,9 @@ void viewPatientHistory(int patientId) {
 
 // Helper function to find a patient by ID and return their index
 int findPatientById(int id) {
+    if (id == TOMBSTONE_ID) {
+        return -1; // never match a deleted slot
+    }
     for (int i = 0; i < patientCount; i++) {
         if (patients[i].id == id) {
             return i; // Return index if found
@@ -1206,6 +1434,9 @@ int findPatientById(int id) {
 
 // Helper function to find a doctor by ID and return their index
 int findDoctorById(int id) {
+    if (id == TOMBSTONE_ID) {
+        return -1; // never match a deleted slot
+    }
     for (int i = 0; i < doctorCount; i++) {
         if (doctors[i].id == id) {
             return i; // Return index if found
@@ -1229,3 +1460,68 @@ void clearInputBuffer() {
     int c;
     while ((c = getchar()) != '\n' && c != EOF);
 }
+
+// Function to append a column padded to its width
+void tableText(TableBuffer *out, const char *text, int width) {
+    size_t length = strlen(text);
+    size_t padded = length < (size_t)width ? (size_t)width : length;
+    if (out->length + padded + 1 > sizeof(out->data)) {
+        tableFlush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    memset(out->data + out->length + length, ' ', padded - length + 1);
+    out->length += padded + 1;
+}
+
+void tableInt(TableBuffer *out, long long value, int width) {
+    char digits[24];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    *--cursor = '\0';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    tableText(out, cursor, width);
+}
+
+void tableChar(TableBuffer *out, char value, int width) {
+    char text[2] = { value, '\0' };
+    tableText(out, text, width);
+}
+
+// Function to end the current row
+void tableEndRow(TableBuffer *out) {
+    if (out->length > 0) {
+        out->data[out->length - 1] = '\n';
+    }
+}
+
+void tableFlush(TableBuffer *out) {
+    fflush(stdout); // anything printed with stdio so far goes first
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t result = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    out->length = 0;
+}
+
+bool nextPage(int shown, int total) {
+    printf("-- %d of %d shown, Enter for more, q to stop -- ", shown, total);
+    char line[16];
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(line, '\n') == NULL && !feof(stdin)) {
+        clearInputBuffer();
+    }
+    return line[0] != 'q' && line[0] != 'Q';
+}
@@ -4,6 +4,9 @@
 #include <ctype.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #define MAX_BOOKS 100
 #define MAX_BORROWERS 50
@@ -11,6 +14,11 @@
 #define FILENAME_BOOKS "books.dat"
 #define FILENAME_BORROWERS "borrowers.dat"
 #define FILENAME_USERS "users.dat"
+#define TOMBSTONE_ID 0
+#define NO_TOMBSTONES ((size_t)-1)
+#define TABLE_BUFFER_SIZE 65536
+#define PAGE_ROWS 20
+#define DATE_CACHE_SIZE 64 // must be a power of two
 
 typedef struct {
     int id;
@@ -33,6 +41,20 @@ typedef struct {
     int is_librarian;
 } User;
 
+typedef struct {
+    const char *filename;
+    size_t recordSize;
+    int savedCount;
+    bool *dirty;
+    size_t idOffset; // NO_TOMBSTONES for the users table
+    int tombstones;
+} TableFile;
+
+typedef struct {
+    char data[TABLE_BUFFER_SIZE];
+    size_t length;
+} TableBuffer;
+
 Book books[MAX_BOOKS];
 Borrower borrowers[MAX_BORROWERS];
 User users[MAX_USERS];
@@ -41,8 +63,22 @@ int borrower_count = 0;
 int user_count = 0;
 User current_user;
 
+bool book_dirty[MAX_BOOKS];
+bool borrower_dirty[MAX_BORROWERS];
+bool user_dirty[MAX_USERS];
+TableFile book_table = { FILENAME_BOOKS, sizeof(Book), -1, book_dirty, offsetof(Book, id), 0 };
+TableFile borrower_table = { FILENAME_BORROWERS, sizeof(Borrower), -1, borrower_dirty, offsetof(Borrower, book_id), 0 };
+TableFile user_table = { FILENAME_USERS, sizeof(User), -1, user_dirty, NO_TOMBSTONES, 0 };
+TableBuffer table_out;
+
 void loadData();
 void saveData();
+int loadTable(TableFile *table, void *records, int maxRecords);
+void markDirty(TableFile *table, int index);
+void saveTable(TableFile *table, const void *records, int count);
+bool isTombstone(const TableFile *table, const void *records, int index);
+void deleteRecord(TableFile *table, void *records, int index);
+int compactTable(TableFile *table, void *records, int count);
 int authenticateUser();
 void registerUser();
 void librarianMenu();
@@ -58,6 +94,14 @@ int findBookById(int id);
 int findBookByTitle(const char *title);
 int findBorrowerByBookId(int book_id);
 void clearInputBuffer();
+void tableText(TableBuffer *out, const char *text, int width);
+void tableInt(TableBuffer *out, long long value, int width);
+void tableChar(TableBuffer *out, char value, int width);
+void tableDate(TableBuffer *out, time_t when);
+void tableLoan(TableBuffer *out, const Book *book, const Borrower *loan);
+void tableEndRow(TableBuffer *out);
+void tableFlush(TableBuffer *out);
+bool nextPage(int shown, int total);
 void changePassword();
 void viewUserDetails();
 
@@ -101,59 +145,137 @@ int main() {
 }
 
 void loadData() {
-    FILE *file;
+    book_count = loadTable(&book_table, books, MAX_BOOKS);
+    borrower_count = loadTable(&borrower_table, borrowers, MAX_BORROWERS);
+    user_count = loadTable(&user_table, users, MAX_USERS);
     
-    file = fopen(FILENAME_BOOKS, "rb");
-    if (file != NULL) {
-        book_count = fread(books, sizeof(Book), MAX_BOOKS, file);
-        fclose(file);
-    }
-    
-    file = fopen(FILENAME_BORROWERS, "rb");
-    if (file != NULL) {
-        borrower_count = fread(borrowers, sizeof(Borrower), MAX_BORROWERS, file);
-        fclose(file);
-    }
-    
-    file = fopen(FILENAME_USERS, "rb");
-    if (file != NULL) {
-        user_count = fread(users, sizeof(User), MAX_USERS, file);
-        fclose(file);
-        
-        if (user_count == 0) {
-            strcpy(users[0].username, "admin");
-            strcpy(users[0].password, "admin123");
-            users[0].is_librarian = 1;
-            user_count = 1;
-        }
-    } else {
+    if (user_count == 0) {
         strcpy(users[0].username, "admin");
         strcpy(users[0].password, "admin123");
         users[0].is_librarian = 1;
         user_count = 1;
+        markDirty(&user_table, 0);
     }
 }
 
 void saveData() {
-    FILE *file;
+    saveTable(&book_table, books, book_count);
+    if (borrower_table.tombstones * 4 > borrower_count) {
+        borrower_count = compactTable(&borrower_table, borrowers, borrower_count);
+    }
+    saveTable(&borrower_table, borrowers, borrower_count);
+    saveTable(&user_table, users, user_count);
+}
+
+int loadTable(TableFile *table, void *records, int maxRecords) {
+    FILE *file = fopen(table->filename, "rb");
+    if (file == NULL) {
+        table->savedCount = -1;
+        return 0;
+    }
+    
+    int count = fread(records, table->recordSize, maxRecords, file);
+    table->savedCount = fgetc(file) == EOF ? count : -1;
+    fclose(file);
     
-    file = fopen(FILENAME_BOOKS, "wb");
-    if (file != NULL) {
-        fwrite(books, sizeof(Book), book_count, file);
-        fclose(file);
+    table->tombstones = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            table->tombstones++;
+        }
     }
+    return count;
+}
+
+void markDirty(TableFile *table, int index) {
+    table->dirty[index] = true;
+}
+
+void saveTable(TableFile *table, const void *records, int count) {
+    const unsigned char *bytes = records;
+    size_t size = table->recordSize;
     
-    file = fopen(FILENAME_BORROWERS, "wb");
-    if (file != NULL) {
-        fwrite(borrowers, sizeof(Borrower), borrower_count, file);
-        fclose(file);
+    int fd = -1;
+    if (table->savedCount >= 0 && count >= table->savedCount) {
+        fd = open(table->filename, O_WRONLY);
+    }
+    if (fd != -1) {
+        bool ok = true;
+        int i = 0;
+        while (i < count && ok) {
+            if (i < table->savedCount && !table->dirty[i]) {
+                i++;
+                continue;
+            }
+            
+            int end = i + 1;
+            while (end < count && (end >= table->savedCount || table->dirty[end])) {
+                end++;
+            }
+            size_t length = (end - i) * size;
+            ok = pwrite(fd, bytes + i * size, length, (off_t)i * size) == (ssize_t)length;
+            i = end;
+        }
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        
+        if (ok) {
+            memset(table->dirty, 0, count * sizeof(bool));
+            table->savedCount = count;
+            return;
+        }
+    }
+    
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", table->filename);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return;
+    }
+    fwrite(records, size, count, file);
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempName, table->filename) != 0) {
+        remove(tempName);
+        return;
     }
     
-    file = fopen(FILENAME_USERS, "wb");
-    if (file != NULL) {
-        fwrite(users, sizeof(User), user_count, file);
-        fclose(file);
+    memset(table->dirty, 0, count * sizeof(bool));
+    table->savedCount = count;
+}
+
+bool isTombstone(const TableFile *table, const void *records, int index) {
+    if (table->idOffset == NO_TOMBSTONES) {
+        return false;
+    }
+    int id;
+    memcpy(&id, (const unsigned char *)records + index * table->recordSize + table->idOffset, sizeof(id));
+    return id == TOMBSTONE_ID;
+}
+
+void deleteRecord(TableFile *table, void *records, int index) {
+    int id = TOMBSTONE_ID;
+    memcpy((unsigned char *)records + index * table->recordSize + table->idOffset, &id, sizeof(id));
+    table->tombstones++;
+    markDirty(table, index);
+}
+
+int compactTable(TableFile *table, void *records, int count) {
+    unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    int live = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            continue;
+        }
+        if (live != i) {
+            memcpy(bytes + live * size, bytes + i * size, size);
+        }
+        live++;
     }
+    table->tombstones = 0;
+    table->savedCount = -1;
+    return live;
 }
 
 int authenticateUser() {
@@ -207,6 +329,7 @@ void registerUser() {
     
     newUser.is_librarian = 0;
     
+    markDirty(&user_table, user_count);
     users[user_count++] = newUser;
     printf("Registration successful! You can now login.\n");
 }
@@ -296,6 +419,7 @@ void addBook() {
     
     newBook.is_available = 1;
     
+    markDirty(&book_table, book_count);
     books[book_count++] = newBook;
     printf("Book added successfully with ID: %d\n", newBook.id);
 }
@@ -306,13 +430,20 @@ void displayAllBooks() {
     printf("------------------------------------------------------------\n");
     
     for (int i = 0; i < book_count; i++) {
-        printf("%-5d %-30s %-20s %-6d %s\n", 
-               books[i].id, 
-               books[i].title, 
-               books[i].author, 
-               books[i].year,
-               books[i].is_available ? "Available" : "Borrowed");
+        if (i > 0 && i % PAGE_ROWS == 0) {
+            tableFlush(&table_out);
+            if (!nextPage(i, book_count)) {
+                return;
+            }
+        }
+        tableInt(&table_out, books[i].id, 5);
+        tableText(&table_out, books[i].title, 30);
+        tableText(&table_out, books[i].author, 20);
+        tableInt(&table_out, books[i].year, 6);
+        tableText(&table_out, books[i].is_available ? "Available" : "Borrowed", 0);
+        tableEndRow(&table_out);
     }
+    tableFlush(&table_out);
 }
 
 void searchBook() {
@@ -360,6 +491,9 @@ void borrowBook() {
         return;
     }
     
+    if (borrower_count >= MAX_BORROWERS && borrower_table.tombstones > 0) {
+        borrower_count = compactTable(&borrower_table, borrowers, borrower_count);
+    }
     if (borrower_count >= MAX_BORROWERS) {
         printf("Maximum number of borrowers reached!\n");
         return;
@@ -376,8 +510,10 @@ void borrowBook() {
     time_t now = time(NULL);
     newBorrower.due_date = now + (14 * 24 * 60 * 60);
     
+    markDirty(&borrower_table, borrower_count);
     borrowers[borrower_count++] = newBorrower;
     books[book_index].is_available = 0;
+    markDirty(&book_table, book_index);
     
     printf("Book borrowed successfully!\n");
     printf("Due date: %s", ctime(&newBorrower.due_date));
@@ -406,12 +542,10 @@ void returnBook() {
         return;
     }
     
-    for (int i = borrower_index; i < borrower_count - 1; i++) {
-        borrowers[i] = borrowers[i + 1];
-    }
-    borrower_count--;
+    deleteRecord(&borrower_table, borrowers, borrower_index);
     
     books[book_index].is_available = 1;
+    markDirty(&book_table, book_index);
     printf("Book returned successfully!\n");
 }
 
@@ -420,25 +554,34 @@ void displayBorrowedBooks() {
     printf("%-5s %-30s %-20s %-15s %s\n", "ID", "Title", "Borrower", "Borrower ID", "Due Date");
     printf("--------------------------------------------------------------------\n");
     
+    int total = borrower_count - borrower_table.tombstones;
+    int shown = 0;
     for (int i = 0; i < borrower_count; i++) {
+        if (borrowers[i].book_id == TOMBSTONE_ID) {
+            continue;
+        }
         int book_index = findBookById(borrowers[i].book_id);
         if (book_index != -1) {
-            printf("%-5d %-30s %-20s %-15d %s", 
-                   books[book_index].id,
-                   books[book_index].title,
-                   borrowers[i].borrower_name,
-                   borrowers[i].borrower_id,
-                   ctime(&borrowers[i].due_date));
+            if (shown > 0 && shown % PAGE_ROWS == 0) {
+                tableFlush(&table_out);
+                if (!nextPage(shown, total)) {
+                    return;
+                }
+            }
+            tableLoan(&table_out, &books[book_index], &borrowers[i]);
+            shown++;
         }
     }
+    tableFlush(&table_out);
     
-    if (borrower_count == 0) {
+    if (borrower_count == borrower_table.tombstones) {
         printf("No books are currently borrowed.\n");
     }
 }
 
 void displayOverdueBooks() {
     time_t now = time(NULL);
+    int overdue_total = 0;
     int overdue_count = 0;
     
     printf("\n===== OVERDUE BOOKS =====\n");
@@ -446,19 +589,27 @@ void displayOverdueBooks() {
     printf("--------------------------------------------------------------------\n");
     
     for (int i = 0; i < borrower_count; i++) {
-        if (borrowers[i].due_date < now) {
+        if (borrowers[i].book_id != TOMBSTONE_ID && borrowers[i].due_date < now) {
+            overdue_total++;
+        }
+    }
+    
+    for (int i = 0; i < borrower_count; i++) {
+        if (borrowers[i].book_id != TOMBSTONE_ID && borrowers[i].due_date < now) {
             int book_index = findBookById(borrowers[i].book_id);
             if (book_index != -1) {
-                printf("%-5d %-30s %-20s %-15d %s", 
-                       books[book_index].id,
-                       books[book_index].title,
-                       borrowers[i].borrower_name,
-                       borrowers[i].borrower_id,
-                       ctime(&borrowers[i].due_date));
+                if (overdue_count > 0 && overdue_count % PAGE_ROWS == 0) {
+                    tableFlush(&table_out);
+                    if (!nextPage(overdue_count, overdue_total)) {
+                        return;
+                    }
+                }
+                tableLoan(&table_out, &books[book_index], &borrowers[i]);
                 overdue_count++;
             }
         }
     }
+    tableFlush(&table_out);
     
     if (overdue_count == 0) {
         printf("No books are currently overdue.\n");
@@ -487,6 +638,7 @@ void changePassword() {
     for (int i = 0; i < user_count; i++) {
         if (strcmp(users[i].username, current_user.username) == 0) {
             strcpy(users[i].password, new_password);
+            markDirty(&user_table, i);
             break;
         }
     }
@@ -505,7 +657,8 @@ void viewUserDetails() {
         
         int count = 0;
         for (int i = 0; i < borrower_count; i++) {
-            if (strcmp(borrowers[i].borrower_name, current_user.username) == 0) {
+            if (borrowers[i].book_id != TOMBSTONE_ID &&
+                strcmp(borrowers[i].borrower_name, current_user.username) == 0) {
                 int book_index = findBookById(borrowers[i].book_id);
                 if (book_index != -1) {
                     printf("Book: %s (ID: %d)\n", books[book_index].title, books[book_index].id);
@@ -540,6 +693,9 @@ int findBookByTitle(const char *title) {
 }
 
 int findBorrowerByBookId(int book_id) {
+    if (book_id == TOMBSTONE_ID) {
+        return -1;
+    }
     for (int i = 0; i < borrower_count; i++) {
         if (borrowers[i].book_id == book_id) {
             return i;
@@ -551,3 +707,104 @@ int findBorrowerByBookId(int book_id) {
 void clearInputBuffer() {
     while (getchar() != '\n');
 }
+
+void tableText(TableBuffer *out, const char *text, int width) {
+    size_t length = strlen(text);
+    size_t padded = length < (size_t)width ? (size_t)width : length;
+    if (out->length + padded + 1 > sizeof(out->data)) {
+        tableFlush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    memset(out->data + out->length + length, ' ', padded - length + 1);
+    out->length += padded + 1;
+}
+
+void tableInt(TableBuffer *out, long long value, int width) {
+    char digits[24];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    *--cursor = '\0';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    tableText(out, cursor, width);
+}
+
+void tableChar(TableBuffer *out, char value, int width) {
+    char text[2] = { value, '\0' };
+    tableText(out, text, width);
+}
+
+void tableDate(TableBuffer *out, time_t when) {
+    static struct {
+        bool used;
+        time_t minute;
+        char prefix[24]; // "Sat Oct 17 23:34:"
+        char year[8];    // " 2026"
+    } cache[DATE_CACHE_SIZE];
+    
+    time_t minute = when - ((when % 60) + 60) % 60;
+    int slot = (int)((unsigned long long)(minute / 60) & (DATE_CACHE_SIZE - 1));
+    if (!cache[slot].used || cache[slot].minute != minute) {
+        struct tm local;
+        localtime_r(&minute, &local);
+        strftime(cache[slot].prefix, sizeof(cache[slot].prefix), "%a %b %e %H:%M:", &local);
+        strftime(cache[slot].year, sizeof(cache[slot].year), " %Y", &local);
+        cache[slot].used = true;
+        cache[slot].minute = minute;
+    }
+    
+    char text[40];
+    size_t length = strlen(cache[slot].prefix);
+    int seconds = (int)(when - minute);
+    memcpy(text, cache[slot].prefix, length);
+    text[length++] = '0' + seconds / 10;
+    text[length++] = '0' + seconds % 10;
+    strcpy(text + length, cache[slot].year);
+    tableText(out, text, 0);
+}
+
+void tableLoan(TableBuffer *out, const Book *book, const Borrower *loan) {
+    tableInt(out, book->id, 5);
+    tableText(out, book->title, 30);
+    tableText(out, loan->borrower_name, 20);
+    tableInt(out, loan->borrower_id, 15);
+    tableDate(out, loan->due_date);
+    tableEndRow(out);
+}
+
+void tableEndRow(TableBuffer *out) {
+    if (out->length > 0) {
+        out->data[out->length - 1] = '\n';
+    }
+}
+
+void tableFlush(TableBuffer *out) {
+    fflush(stdout);
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t result = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    out->length = 0;
+}
+
+bool nextPage(int shown, int total) {
+    printf("-- %d of %d shown, Enter for more, q to stop -- ", shown, total);
+    char line[16];
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(line, '\n') == NULL && !feof(stdin)) {
+        clearInputBuffer();
+    }
+    return line[0] != 'q' && line[0] != 'Q';
+}
@@ -3,11 +3,19 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #define MAX_BOOKS 100
 #define MAX_BORROWERS 50
 #define FILENAME_BOOKS "books.dat"
 #define FILENAME_BORROWERS "borrowers.dat"
+#define TOMBSTONE_ID 0 // book_id of a returned loan until the table is compacted
+#define TABLE_BUFFER_SIZE 65536
+#define PAGE_ROWS 20 // rows per page
+#define DATE_CACHE_SIZE 64 // a power of two
 
 typedef struct {
     int id;
@@ -24,14 +32,41 @@ typedef struct {
     time_t due_date;
 } Borrower;
 
+typedef struct {
+    const char *filename;
+    size_t recordSize;
+    int savedCount; // -1 forces a full rewrite
+    bool *dirty;
+    size_t idOffset; // key field, TOMBSTONE_ID once deleted
+    int tombstones;
+} TableFile;
+
+// Buffered output of the list views
+typedef struct {
+    char data[TABLE_BUFFER_SIZE];
+    size_t length;
+} TableBuffer;
+
 Book books[MAX_BOOKS];
 Borrower borrowers[MAX_BORROWERS];
 int book_count = 0;
 int borrower_count = 0;
 
+bool book_dirty[MAX_BOOKS];
+bool borrower_dirty[MAX_BORROWERS];
+TableFile book_table = { FILENAME_BOOKS, sizeof(Book), -1, book_dirty, offsetof(Book, id), 0 };
+TableFile borrower_table = { FILENAME_BORROWERS, sizeof(Borrower), -1, borrower_dirty, offsetof(Borrower, book_id), 0 };
+TableBuffer table_out;
+
 // Function prototypes
 void loadData();
 void saveData();
+int loadTable(TableFile *table, void *records, int maxRecords);
+void markDirty(TableFile *table, int index);
+void saveTable(TableFile *table, const void *records, int count);
+bool isTombstone(const TableFile *table, const void *records, int index);
+void deleteRecord(TableFile *table, void *records, int index);
+int compactTable(TableFile *table, void *records, int count);
 void displayMenu();
 void addBook();
 void displayAllBooks();
@@ -44,6 +79,14 @@ int findBookById(int id);
 int findBookByTitle(const char *title);
 int findBorrowerByBookId(int book_id);
 void clearInputBuffer();
+void tableText(TableBuffer *out, const char *text, int width);
+void tableInt(TableBuffer *out, long long value, int width);
+void tableChar(TableBuffer *out, char value, int width);
+void tableDate(TableBuffer *out, time_t when);
+void tableLoan(TableBuffer *out, const Book *book, const Borrower *loan);
+void tableEndRow(TableBuffer *out);
+void tableFlush(TableBuffer *out);
+bool nextPage(int shown, int total);
 
 int main() {
     loadData();
@@ -73,39 +116,132 @@ int main() {
 }
 
 void loadData() {
-    FILE *file;
-    
     // Load books
-    file = fopen(FILENAME_BOOKS, "rb");
-    if (file != NULL) {
-        book_count = fread(books, sizeof(Book), MAX_BOOKS, file);
-        fclose(file);
-    }
+    book_count = loadTable(&book_table, books, MAX_BOOKS);
     
     // Load borrowers
-    file = fopen(FILENAME_BORROWERS, "rb");
-    if (file != NULL) {
-        borrower_count = fread(borrowers, sizeof(Borrower), MAX_BORROWERS, file);
-        fclose(file);
-    }
+    borrower_count = loadTable(&borrower_table, borrowers, MAX_BORROWERS);
 }
 
 void saveData() {
-    FILE *file;
-    
     // Save books
-    file = fopen(FILENAME_BOOKS, "wb");
-    if (file != NULL) {
-        fwrite(books, sizeof(Book), book_count, file);
-        fclose(file);
+    saveTable(&book_table, books, book_count);
+    
+    // Save borrowers, compacting once a quarter of the slots are returned loans
+    if (borrower_table.tombstones * 4 > borrower_count) {
+        borrower_count = compactTable(&borrower_table, borrowers, borrower_count);
     }
+    saveTable(&borrower_table, borrowers, borrower_count);
+}
+
+int loadTable(TableFile *table, void *records, int maxRecords) {
+    FILE *file = fopen(table->filename, "rb");
+    if (file == NULL) {
+        table->savedCount = -1;
+        return 0;
+    }
+    
+    int count = fread(records, table->recordSize, maxRecords, file);
+    table->savedCount = fgetc(file) == EOF ? count : -1;
+    fclose(file);
     
-    // Save borrowers
-    file = fopen(FILENAME_BORROWERS, "wb");
-    if (file != NULL) {
-        fwrite(borrowers, sizeof(Borrower), borrower_count, file);
-        fclose(file);
+    table->tombstones = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            table->tombstones++;
+        }
     }
+    return count;
+}
+
+void markDirty(TableFile *table, int index) {
+    table->dirty[index] = true;
+}
+
+// Save only what changed, or rewrite the file if it shrank
+void saveTable(TableFile *table, const void *records, int count) {
+    const unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    
+    int fd = -1;
+    if (table->savedCount >= 0 && count >= table->savedCount) {
+        fd = open(table->filename, O_WRONLY);
+    }
+    if (fd != -1) {
+        bool ok = true;
+        int i = 0;
+        while (i < count && ok) {
+            if (i < table->savedCount && !table->dirty[i]) {
+                i++;
+                continue;
+            }
+            
+            int end = i + 1;
+            while (end < count && (end >= table->savedCount || table->dirty[end])) {
+                end++;
+            }
+            size_t length = (end - i) * size;
+            ok = pwrite(fd, bytes + i * size, length, (off_t)i * size) == (ssize_t)length;
+            i = end;
+        }
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        
+        if (ok) {
+            memset(table->dirty, 0, count * sizeof(bool));
+            table->savedCount = count;
+            return;
+        }
+    }
+    
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", table->filename);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return;
+    }
+    fwrite(records, size, count, file);
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempName, table->filename) != 0) {
+        remove(tempName);
+        return;
+    }
+    
+    memset(table->dirty, 0, count * sizeof(bool));
+    table->savedCount = count;
+}
+
+bool isTombstone(const TableFile *table, const void *records, int index) {
+    int id;
+    memcpy(&id, (const unsigned char *)records + index * table->recordSize + table->idOffset, sizeof(id));
+    return id == TOMBSTONE_ID;
+}
+
+void deleteRecord(TableFile *table, void *records, int index) {
+    int id = TOMBSTONE_ID;
+    memcpy((unsigned char *)records + index * table->recordSize + table->idOffset, &id, sizeof(id));
+    table->tombstones++;
+    markDirty(table, index);
+}
+
+// Returned loans leave the table here, on save or when it is full
+int compactTable(TableFile *table, void *records, int count) {
+    unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    int live = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            continue;
+        }
+        if (live != i) {
+            memcpy(bytes + live * size, bytes + i * size, size);
+        }
+        live++;
+    }
+    table->tombstones = 0;
+    table->savedCount = -1;
+    return live;
 }
 
 void displayMenu() {
@@ -146,6 +282,7 @@ void addBook() {
     
     newBook.is_available = 1;
     
+    markDirty(&book_table, book_count);
     books[book_count++] = newBook;
     printf("Book added successfully with ID: %d\n", newBook.id);
 }
@@ -156,13 +293,20 @@ void displayAllBooks() {
     printf("------------------------------------------------------------\n");
     
     for (int i = 0; i < book_count; i++) {
-        printf("%-5d %-30s %-20s %-6d %s\n", 
-               books[i].id, 
-               books[i].title, 
-               books[i].author, 
-               books[i].year,
-               books[i].is_available ? "Available" : "Borrowed");
+        if (i > 0 && i % PAGE_ROWS == 0) {
+            tableFlush(&table_out);
+            if (!nextPage(i, book_count)) {
+                return;
+            }
+        }
+        tableInt(&table_out, books[i].id, 5);
+        tableText(&table_out, books[i].title, 30);
+        tableText(&table_out, books[i].author, 20);
+        tableInt(&table_out, books[i].year, 6);
+        tableText(&table_out, books[i].is_available ? "Available" : "Borrowed", 0);
+        tableEndRow(&table_out);
     }
+    tableFlush(&table_out);
 }
 
 void searchBook() {
@@ -210,6 +354,9 @@ void borrowBook() {
         return;
     }
     
+    if (borrower_count >= MAX_BORROWERS && borrower_table.tombstones > 0) {
+        borrower_count = compactTable(&borrower_table, borrowers, borrower_count); // make room from returned loans
+    }
     if (borrower_count >= MAX_BORROWERS) {
         printf("Maximum number of borrowers reached!\n");
         return;
@@ -230,8 +377,10 @@ void borrowBook() {
     time_t now = time(NULL);
     newBorrower.due_date = now + (14 * 24 * 60 * 60); // 14 days in seconds
     
+    markDirty(&borrower_table, borrower_count);
     borrowers[borrower_count++] = newBorrower;
     books[book_index].is_available = 0;
+    markDirty(&book_table, book_index);
     
     printf("Book borrowed successfully!\n");
     printf("Due date: %s", ctime(&newBorrower.due_date));
@@ -260,13 +409,11 @@ void returnBook() {
         return;
     }
     
-    // Remove borrower record by shifting array
-    for (int i = borrower_index; i < borrower_count - 1; i++) {
-        borrowers[i] = borrowers[i + 1];
-    }
-    borrower_count--;
+    // Tombstone the loan; the slot is reclaimed by the next compaction
+    deleteRecord(&borrower_table, borrowers, borrower_index);
     
     books[book_index].is_available = 1;
+    markDirty(&book_table, book_index);
     printf("Book returned successfully!\n");
 }
 
@@ -275,25 +422,34 @@ void displayBorrowedBooks() {
     printf("%-5s %-30s %-20s %-15s %s\n", "ID", "Title", "Borrower", "Borrower ID", "Due Date");
     printf("--------------------------------------------------------------------\n");
     
+    int total = borrower_count - borrower_table.tombstones;
+    int shown = 0;
     for (int i = 0; i < borrower_count; i++) {
+        if (borrowers[i].book_id == TOMBSTONE_ID) {
+            continue;
+        }
         int book_index = findBookById(borrowers[i].book_id);
         if (book_index != -1) {
-            printf("%-5d %-30s %-20s %-15d %s", 
-                   books[book_index].id,
-                   books[book_index].title,
-                   borrowers[i].borrower_name,
-                   borrowers[i].borrower_id,
-                   ctime(&borrowers[i].due_date));
+            if (shown > 0 && shown % PAGE_ROWS == 0) {
+                tableFlush(&table_out);
+                if (!nextPage(shown, total)) {
+                    return;
+                }
+            }
+            tableLoan(&table_out, &books[book_index], &borrowers[i]);
+            shown++;
         }
     }
+    tableFlush(&table_out);
     
-    if (borrower_count == 0) {
+    if (borrower_count == borrower_table.tombstones) {
         printf("No books are currently borrowed.\n");
     }
 }
 
 void displayOverdueBooks() {
     time_t now = time(NULL);
+    int overdue_total = 0;
     int overdue_count = 0;
     
     printf("\n===== OVERDUE BOOKS =====\n");
@@ -301,19 +457,27 @@ void displayOverdueBooks() {
     printf("--------------------------------------------------------------------\n");
     
     for (int i = 0; i < borrower_count; i++) {
-        if (borrowers[i].due_date < now) {
+        if (borrowers[i].book_id != TOMBSTONE_ID && borrowers[i].due_date < now) {
+            overdue_total++;
+        }
+    }
+    
+    for (int i = 0; i < borrower_count; i++) {
+        if (borrowers[i].book_id != TOMBSTONE_ID && borrowers[i].due_date < now) {
             int book_index = findBookById(borrowers[i].book_id);
             if (book_index != -1) {
-                printf("%-5d %-30s %-20s %-15d %s", 
-                       books[book_index].id,
-                       books[book_index].title,
-                       borrowers[i].borrower_name,
-                       borrowers[i].borrower_id,
-                       ctime(&borrowers[i].due_date));
+                if (overdue_count > 0 && overdue_count % PAGE_ROWS == 0) {
+                    tableFlush(&table_out);
+                    if (!nextPage(overdue_count, overdue_total)) {
+                        return;
+                    }
+                }
+                tableLoan(&table_out, &books[book_index], &borrowers[i]);
                 overdue_count++;
             }
         }
     }
+    tableFlush(&table_out);
     
     if (overdue_count == 0) {
         printf("No books are currently overdue.\n");
@@ -339,6 +503,9 @@ int findBookByTitle(const char *title) {
 }
 
 int findBorrowerByBookId(int book_id) {
+    if (book_id == TOMBSTONE_ID) {
+        return -1; // never match a returned loan
+    }
     for (int i = 0; i < borrower_count; i++) {
         if (borrowers[i].book_id == book_id) {
             return i;
@@ -350,3 +517,107 @@ int findBorrowerByBookId(int book_id) {
 void clearInputBuffer() {
     while (getchar() != '\n');
 }
+
+void tableText(TableBuffer *out, const char *text, int width) {
+    size_t length = strlen(text);
+    size_t padded = length < (size_t)width ? (size_t)width : length;
+    if (out->length + padded + 1 > sizeof(out->data)) {
+        tableFlush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    memset(out->data + out->length + length, ' ', padded - length + 1);
+    out->length += padded + 1;
+}
+
+void tableInt(TableBuffer *out, long long value, int width) {
+    char digits[24];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    *--cursor = '\0';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    tableText(out, cursor, width);
+}
+
+void tableChar(TableBuffer *out, char value, int width) {
+    char text[2] = { value, '\0' };
+    tableText(out, text, width);
+}
+
+// ctime() layout ("Sat Oct 17 23:34:45 2026") without a localtime() call per
+// row: all but the seconds is cached per minute in a direct-mapped table
+void tableDate(TableBuffer *out, time_t when) {
+    static struct {
+        bool used;
+        time_t minute;
+        char prefix[24]; // "Sat Oct 17 23:34:"
+        char year[8];    // " 2026"
+    } cache[DATE_CACHE_SIZE];
+    
+    time_t minute = when - ((when % 60) + 60) % 60;
+    int slot = (int)((unsigned long long)(minute / 60) & (DATE_CACHE_SIZE - 1));
+    if (!cache[slot].used || cache[slot].minute != minute) {
+        struct tm local;
+        localtime_r(&minute, &local);
+        strftime(cache[slot].prefix, sizeof(cache[slot].prefix), "%a %b %e %H:%M:", &local);
+        strftime(cache[slot].year, sizeof(cache[slot].year), " %Y", &local);
+        cache[slot].used = true;
+        cache[slot].minute = minute;
+    }
+    
+    char text[40];
+    size_t length = strlen(cache[slot].prefix);
+    int seconds = (int)(when - minute);
+    memcpy(text, cache[slot].prefix, length);
+    text[length++] = '0' + seconds / 10;
+    text[length++] = '0' + seconds % 10;
+    strcpy(text + length, cache[slot].year);
+    tableText(out, text, 0);
+}
+
+void tableLoan(TableBuffer *out, const Book *book, const Borrower *loan) {
+    tableInt(out, book->id, 5);
+    tableText(out, book->title, 30);
+    tableText(out, loan->borrower_name, 20);
+    tableInt(out, loan->borrower_id, 15);
+    tableDate(out, loan->due_date);
+    tableEndRow(out);
+}
+
+// The last separator becomes the newline
+void tableEndRow(TableBuffer *out) {
+    if (out->length > 0) {
+        out->data[out->length - 1] = '\n';
+    }
+}
+
+void tableFlush(TableBuffer *out) {
+    fflush(stdout);
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t result = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    out->length = 0;
+}
+
+bool nextPage(int shown, int total) {
+    printf("-- %d of %d shown, Enter for more, q to stop -- ", shown, total);
+    char line[16];
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(line, '\n') == NULL && !feof(stdin)) {
+        clearInputBuffer();
+    }
+    return line[0] != 'q' && line[0] != 'Q';
+}
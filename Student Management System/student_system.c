@@ -3,12 +3,39 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <strings.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
 
-#define MAX_STUDENTS 100
-#define MAX_SUBJECTS 5
-#define FILENAME "student_data.dat"
+#define MAX_STUDENTS 100000
+#define MAX_COURSES 100
+#define MAX_COURSE_SUBJECTS 12
+#define LEGACY_SUBJECTS 5 // marks held inline by records in LEGACY_FILENAME
+#define FILENAME "student_records.dat"
+#define LEGACY_FILENAME "student_data.dat"
+#define MARKS_FILENAME "student_marks.dat"
+#define MARKS_BACKUP_FILENAME "student_marks.old" // pool before a compaction, until the records are saved
+#define CATALOGUE_FILENAME "course_subjects.dat"
+#define MARKS_MAGIC 0x324B4D53U // "SMK2"
+#define TOMBSTONE_ID 0 // roll number of a deleted record until the table is compacted
 #define ADMIN_USERNAME "admin"
 #define ADMIN_PASSWORD "admin123"
+#define TABLE_BUFFER_SIZE 65536
+#define PAGE_ROWS 20 // students per page in list views
+#define IMPORT_READ_BUFFER (1 << 20)
+#define IMPORT_BLOCK 4096 // imported rows graded together
+#define RANK_BUCKETS 10001 // percentages in hundredths, 0.00 to 100.00
+#define STATS_MAX_THREADS 16
+#define STATS_MIN_ROWS 16384 // students per thread worth starting one for
+#define HISTOGRAM_BANDS 10 // marks in bands of ten, 90-100 in the last
+#define GRADE_KINDS 7 // A to F, then no marks
+#define ROLL_LEAF_SIZE 64
+#define ROLL_LEAF_FILL 48 // entries per leaf after a rebuild, leaving room for inserts
 
 typedef struct {
     int rollNumber;
@@ -17,18 +44,219 @@ typedef struct {
     char gender;
     char course[50];
     int semester;
-    float marks[MAX_SUBJECTS];
     int attendance;
     char grade;
+    unsigned char markCount; // marks entered, in the order of the course's subjects
+    unsigned short marksGeneration; // pool generation marksOffset points into
+    int marksOffset;         // first of them in markPool
 } Student;
+_Static_assert(sizeof(Student) == 128, "marksGeneration fits in former padding");
+
+// Records as stored before marks moved out of them
+typedef struct {
+    int rollNumber;
+    char name[50];
+    int age;
+    char gender;
+    char course[50];
+    int semester;
+    float marks[LEGACY_SUBJECTS];
+    int attendance;
+    char grade;
+} LegacyStudent;
+
+// Subjects taken in one course, in report card order. Clearing the list
+// removes the course, so subjectCount doubles as the table's key field.
+typedef struct {
+    char course[50];
+    int subjectCount;
+    char subjects[MAX_COURSE_SUBJECTS][30];
+} CourseSubjects;
+
+typedef struct {
+    unsigned int magic;
+    int count; // marks in the pool
+    unsigned int generation; // bumped by every compaction
+} MarksFileHeader;
+
+typedef struct {
+    const char *filename;
+    size_t recordSize;
+    int savedCount; // -1 when the file must be rewritten
+    bool *dirty;
+    size_t idOffset; // int key, TOMBSTONE_ID once deleted
+    int tombstones;
+} TableFile;
+
+// Rows of a list view, written out in one go
+typedef struct {
+    char data[TABLE_BUFFER_SIZE];
+    size_t length;
+} TableBuffer;
+
+// Imported rows waiting to be graded. Marks are stored subject by subject so
+// each subject's column is contiguous for the grade kernel; subjects a row's
+// course does not have are zero.
+typedef struct {
+    unsigned short marks[MAX_COURSE_SUBJECTS][IMPORT_BLOCK]; // hundredths
+    int subjectCounts[IMPORT_BLOCK];
+    int totals[IMPORT_BLOCK];
+    float percentages[IMPORT_BLOCK];
+    char grades[IMPORT_BLOCK];
+    int targets[IMPORT_BLOCK]; // student index per row
+    int count;
+    int subjectRows; // most subjects of any row in the block
+} MarksBlock;
+
+typedef struct {
+    int rollNumber;
+    int index;
+} RollEntry;
+
+// One leaf of the roll number index: roll numbers ascending, each with the
+// student's slot. Keys and slots are kept apart so a search touches only keys.
+typedef struct {
+    int count;
+    int rolls[ROLL_LEAF_SIZE];
+    int indexes[ROLL_LEAF_SIZE];
+} RollLeaf;
+
+// Position in the roll number index; leaf == rollLeafCount is past the end
+typedef struct {
+    int leaf;
+    int position;
+} RollCursor;
+
+// Students of one course and semester who have marks. The Fenwick tree counts
+// them per percentage bucket, so a rank is one prefix sum and a changed mark
+// is one update instead of re-sorting the class.
+typedef struct {
+    char course[50];
+    int semester;
+    int size;
+    int *tree; // RANK_BUCKETS + 1 counters, 1-based
+} Cohort;
+
+typedef struct {
+    long long read;
+    long long imported;
+    long long malformed;
+    long long unknownStudent;
+    long long wrongSubjectCount;
+    long long outOfRange;
+    double percentageSum;
+} ImportStats;
 
 Student students[MAX_STUDENTS];
 int studentCount = 0;
-const char *subjects[MAX_SUBJECTS] = {"Math", "Science", "English", "History", "Programming"};
+bool studentDirty[MAX_STUDENTS];
+TableFile studentTable = { FILENAME, sizeof(Student), -1, studentDirty, offsetof(Student, rollNumber), 0 };
+CourseSubjects courses[MAX_COURSES];
+int courseCount = 0;
+bool courseDirty[MAX_COURSES];
+TableFile courseTable = { CATALOGUE_FILENAME, sizeof(CourseSubjects), -1, courseDirty,
+                          offsetof(CourseSubjects, subjectCount), 0 };
+// Subjects of any course without its own entry in the catalogue
+const CourseSubjects defaultSubjects = { "", 5, {"Math", "Science", "English", "History", "Programming"} };
+
+// Marks of all students, packed back to back in hundredths (CSR style: each
+// student holds an offset and a count into the pool). Replaced or removed
+// marks leave holes that are squeezed out at save time.
+unsigned short *markPool = NULL;
+int markPoolCount = 0;
+int markPoolCapacity = 0;
+int markPoolHoles = 0;
+bool markPoolDirty = false;
+unsigned short markPoolGeneration = 0;
+bool markPoolMoved = false;    // compacted since the last save
+bool markPoolBackedUp = false; // MARKS_BACKUP_FILENAME may still be needed by saved records
+TableBuffer tableOut;
+
+// Running mean and spread (Welford); partial results from several threads
+// are combined with mergeStats
+typedef struct {
+    long long count;
+    double mean;
+    double m2; // sum of squared deviations from the mean
+    double min;
+    double max;
+} RunningStats;
+
+// Attendance against percentage, accumulated the same way
+typedef struct {
+    long long count;
+    double meanX;
+    double meanY;
+    double m2X;
+    double m2Y;
+    double coMoment; // sum of products of both deviations
+} RunningCorrelation;
+
+// Statistics of one cohort over one slice of students[]. Each thread fills
+// its own and the slices are merged afterwards, so the pass takes no locks.
+typedef struct {
+    const char *course; // NULL for every course
+    int semester;       // 0 for every semester
+    int begin;
+    int end;
+    long long studentsMatched;
+    RunningStats subjects[MAX_COURSE_SUBJECTS];
+    long long histograms[MAX_COURSE_SUBJECTS][HISTOGRAM_BANDS];
+    RunningStats percentage;
+    RunningCorrelation attendance;
+    long long grades[GRADE_KINDS];
+} CohortStats;
+
+// Class ranks, built on first use and then kept up to date as marks, courses
+// and semesters change. Positions follow students[], so compacting the table
+// drops them until the next rank lookup.
+Cohort *cohorts = NULL;
+int cohortCount = 0;
+int cohortCapacity = 0;
+int *cohortSlots = NULL; // hash of course and semester, cohort index + 1 (0 = empty)
+int cohortSlotCount = 0;
+bool ranksBuilt = false;
+int rankCohort[MAX_STUDENTS]; // cohort a student is counted in, -1 if none
+unsigned short rankBucket[MAX_STUDENTS];
+
+// Roll number index, a two-level B+-tree: leaves in key order under a fence
+// array holding each leaf's first roll number. Like the ranks it is built on
+// first use, kept up to date by adds and deletes, and dropped by compaction.
+RollLeaf **rollLeaves = NULL;
+int *rollFences = NULL;
+int rollLeafCount = 0;
+int rollLeafCapacity = 0;
+bool rollIndexBuilt = false;
 
 // Function prototypes
 void loadData();
 void saveData();
+int loadLegacyStudents();
+void loadMarks();
+bool saveMarks();
+unsigned short *readMarksFile(const char *filename, MarksFileHeader *header);
+bool storeMarks(int studentIndex, const unsigned short *marks, int count);
+void clearMarks(int studentIndex);
+void compactMarks();
+const CourseSubjects *findCourse(const char *course);
+void buildRanks();
+void dropRanks();
+void rankStudent(int studentIndex);
+void unrankStudent(int studentIndex);
+bool studentRank(int studentIndex, int *rank, int *classSize, double *percentile);
+int findCohort(const char *course, int semester);
+unsigned int hashCohort(const char *course, int semester);
+int percentageBucket(int studentIndex);
+void fenwickAdd(int *tree, int bucket, int delta);
+int fenwickPrefix(const int *tree, int bucket);
+void manageSubjectCatalogue();
+int loadTable(TableFile *table, void *records, int maxRecords);
+void markDirty(TableFile *table, int index);
+bool saveTable(TableFile *table, const void *records, int count);
+bool isTombstone(const TableFile *table, const void *records, int index);
+void deleteRecord(TableFile *table, void *records, int index);
+int compactTable(TableFile *table, void *records, int count);
+void compactStudents();
 int authenticateAdmin();
 void mainMenu();
 void adminMenu();
@@ -36,18 +264,63 @@ void studentMenu(int studentIndex);
 void addStudent();
 void displayAllStudents();
 void searchStudent();
+void listStudentsByRollRange();
 void updateStudent();
 void deleteStudent();
 void addMarks(int studentIndex);
 void viewReportCard(int studentIndex);
 void updateAttendance(int studentIndex);
 void calculateGrade(int studentIndex);
+char gradeForPercentage(float percentage);
+int importMarks(const char *path);
+const char *stageMarksRow(MarksBlock *block, char *line, ImportStats *stats);
+int splitFields(char *line, char **fields, int maxFields);
+bool parseMark(const char *text, float *mark);
+void applyMarksBlock(MarksBlock *block, ImportStats *stats);
+void computeGrades(MarksBlock *block);
+void printImportSummary(const ImportStats *stats, double seconds, const char *rejectsPath);
+void cohortReport();
+int collectCohortStats(CohortStats *total, const char *course, int semester);
+void *cohortStatsWorker(void *arg);
+void addStat(RunningStats *stats, double value);
+void mergeStats(RunningStats *into, const RunningStats *from);
+void addCorrelation(RunningCorrelation *corr, double x, double y);
+void mergeCorrelation(RunningCorrelation *into, const RunningCorrelation *from);
+void printStatsRow(const char *label, const RunningStats *stats);
 int findStudentByRollNumber(int rollNumber);
+bool rebuildRollIndex();
+void dropRollIndex();
+void rollIndexInsert(int rollNumber, int studentIndex);
+void rollIndexRemove(int rollNumber, int studentIndex);
+RollCursor rollIndexSeek(int rollNumber);
+void rollCursorNext(RollCursor *cursor);
+bool insertRollLeaf(int position);
+void removeRollLeaf(int position);
+int compareRollEntries(const void *a, const void *b);
 void clearInputBuffer();
+void tableText(TableBuffer *out, const char *text, int width);
+void tableInt(TableBuffer *out, long long value, int width);
+void tableChar(TableBuffer *out, char value, int width);
+void tableEndRow(TableBuffer *out);
+void tableStudentRow(TableBuffer *out, int index);
+void printStudentTableHeader(const char *title);
+void tableFlush(TableBuffer *out);
+bool nextPage(int shown, int total);
 void printStudentDetails(int index);
 void printWelcomeArt();
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (argc == 3 && strcmp(argv[1], "--import-marks") == 0) {
+        loadData();
+        int status = importMarks(argv[2]);
+        saveData();
+        return status;
+    }
+    if (argc != 1) {
+        printf("Usage: %s [--import-marks <marks.csv>]\n", argv[0]);
+        return 1;
+    }
+    
     loadData();
     printWelcomeArt();
     
@@ -75,19 +348,546 @@ void printWelcomeArt() {
 }
 
 void loadData() {
-    FILE *file = fopen(FILENAME, "rb");
-    if (file != NULL) {
-        studentCount = fread(students, sizeof(Student), MAX_STUDENTS, file);
-        fclose(file);
+    courseCount = loadTable(&courseTable, courses, MAX_COURSES);
+    if (access(FILENAME, F_OK) != 0) {
+        studentCount = loadLegacyStudents(); // records from before the marks store, if any
+        return;
     }
+    studentCount = loadTable(&studentTable, students, MAX_STUDENTS);
+    loadMarks();
 }
 
 void saveData() {
-    FILE *file = fopen(FILENAME, "wb");
-    if (file != NULL) {
-        fwrite(students, sizeof(Student), studentCount, file);
-        fclose(file);
+    // Reclaim deleted slots once they make up a quarter of the table
+    if (studentTable.tombstones * 4 > studentCount) {
+        compactStudents();
+    }
+    if (courseTable.tombstones * 4 > courseCount) {
+        courseCount = compactTable(&courseTable, courses, courseCount);
+    }
+    if (markPoolHoles * 4 > markPoolCount && !markPoolBackedUp) {
+        compactMarks();
+    }
+    // Marks first: saved records may point at marks added since the last save
+    if (!saveMarks()) {
+        printf("Could not write %s, student records not saved!\n", MARKS_FILENAME);
+    } else if (saveTable(&studentTable, students, studentCount) && markPoolBackedUp) {
+        remove(MARKS_BACKUP_FILENAME); // every saved record points into the current pool
+        markPoolBackedUp = false;
+    }
+    saveTable(&courseTable, courses, courseCount);
+}
+
+// Converts records that still hold five marks inline; those belong to the
+// default subjects. The next save writes the new files and the legacy file
+// is no longer read.
+int loadLegacyStudents() {
+    FILE *file = fopen(LEGACY_FILENAME, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    LegacyStudent legacy;
+    int count = 0;
+    while (count < MAX_STUDENTS && fread(&legacy, sizeof(legacy), 1, file) == 1) {
+        Student *student = &students[count];
+        memset(student, 0, sizeof(*student));
+        student->rollNumber = legacy.rollNumber;
+        memcpy(student->name, legacy.name, sizeof(student->name));
+        student->age = legacy.age;
+        student->gender = legacy.gender;
+        memcpy(student->course, legacy.course, sizeof(student->course));
+        student->semester = legacy.semester;
+        student->attendance = legacy.attendance;
+        student->grade = legacy.grade;
+        
+        if (student->rollNumber == TOMBSTONE_ID) {
+            studentTable.tombstones++;
+        } else if (legacy.grade != 'N') { // 'N': marks were never entered
+            unsigned short marks[LEGACY_SUBJECTS];
+            for (int s = 0; s < LEGACY_SUBJECTS; s++) {
+                float mark = legacy.marks[s] < 0 ? 0 : legacy.marks[s] > 100 ? 100 : legacy.marks[s];
+                marks[s] = (unsigned short)(mark * 100 + 0.5f);
+            }
+            storeMarks(count, marks, LEGACY_SUBJECTS);
+        }
+        count++;
+    }
+    fclose(file);
+    studentTable.savedCount = -1;
+    return count;
+}
+
+// Reads the pool. Each record names the pool generation its offset points
+// into; records saved before a compaction reached them (a save interrupted
+// between the two files) take their marks from the previous pool, which is
+// kept until the records are saved. Marks found in neither are dropped
+// rather than read from another student's place.
+void loadMarks() {
+    MarksFileHeader header;
+    markPool = readMarksFile(MARKS_FILENAME, &header);
+    if (markPool == NULL && access(MARKS_FILENAME, F_OK) != 0) {
+        markPool = readMarksFile(MARKS_BACKUP_FILENAME, &header); // stopped between the two renames
+        markPoolDirty = markPool != NULL;
+    }
+    markPoolCount = markPool != NULL ? header.count : 0;
+    markPoolCapacity = markPoolCount;
+    markPoolGeneration = header.generation;
+    markPoolBackedUp = access(MARKS_BACKUP_FILENAME, F_OK) == 0;
+    
+    unsigned short *backup = NULL;
+    MarksFileHeader backupHeader = { 0, 0, 0 };
+    bool backupRead = false;
+    int used = 0;
+    int lost = 0;
+    for (int i = 0; i < studentCount; i++) {
+        Student *student = &students[i];
+        if (student->markCount == 0 || isTombstone(&studentTable, students, i)) {
+            continue;
+        }
+        int count = student->markCount;
+        if (student->marksGeneration != markPoolGeneration) {
+            if (!backupRead) {
+                backup = readMarksFile(MARKS_BACKUP_FILENAME, &backupHeader);
+                backupRead = true;
+            }
+            if (backup != NULL && student->marksGeneration == backupHeader.generation &&
+                student->marksOffset >= 0 && student->marksOffset <= backupHeader.count - count) {
+                student->markCount = 0;
+                if (storeMarks(i, backup + student->marksOffset, count)) {
+                    used += count;
+                    continue;
+                }
+                student->markCount = count;
+            }
+            clearMarks(i);
+            lost++;
+            continue;
+        }
+        if (student->marksOffset < 0 || student->marksOffset > markPoolCount - count) {
+            clearMarks(i);
+            lost++;
+            continue;
+        }
+        used += count;
+    }
+    free(backup);
+    markPoolHoles = markPoolCount - used;
+    if (lost > 0) {
+        printf("Warning: marks of %d students could not be found and were cleared.\n", lost);
+    }
+}
+
+// A marks file's pool, or NULL if it is missing or damaged
+unsigned short *readMarksFile(const char *filename, MarksFileHeader *header) {
+    memset(header, 0, sizeof(*header));
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    unsigned short *pool = NULL;
+    bool ok = fread(header, sizeof(*header), 1, file) == 1 && header->magic == MARKS_MAGIC && header->count >= 0;
+    if (ok) {
+        pool = malloc((header->count > 0 ? header->count : 1) * sizeof(unsigned short));
+        ok = pool != NULL && fread(pool, sizeof(unsigned short), header->count, file) == (size_t)header->count;
+    }
+    fclose(file);
+    if (!ok) {
+        free(pool);
+        memset(header, 0, sizeof(*header));
+        return NULL;
+    }
+    return pool;
+}
+
+// After a compaction the previous file is moved aside rather than replaced,
+// since saved records point into it until saveData writes them
+bool saveMarks() {
+    if (!markPoolDirty) {
+        return true;
+    }
+    
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", MARKS_FILENAME);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    MarksFileHeader header = { MARKS_MAGIC, markPoolCount, markPoolGeneration };
+    fwrite(&header, sizeof(header), 1, file);
+    if (markPoolCount > 0) {
+        fwrite(markPool, sizeof(unsigned short), markPoolCount, file);
+    }
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (ok && markPoolMoved && access(MARKS_FILENAME, F_OK) == 0) {
+        ok = rename(MARKS_FILENAME, MARKS_BACKUP_FILENAME) == 0;
+        markPoolBackedUp = markPoolBackedUp || ok;
+    }
+    if (!ok || rename(tempName, MARKS_FILENAME) != 0) {
+        remove(tempName);
+        return false;
+    }
+    markPoolDirty = false;
+    markPoolMoved = false;
+    return true;
+}
+
+bool storeMarks(int studentIndex, const unsigned short *marks, int count) {
+    Student *student = &students[studentIndex];
+    unrankStudent(studentIndex);
+    if (count > student->markCount) {
+        if (markPoolCount + count > markPoolCapacity) {
+            int newCapacity = markPoolCapacity > 0 ? markPoolCapacity * 2 : 1024;
+            while (newCapacity < markPoolCount + count) {
+                newCapacity *= 2;
+            }
+            unsigned short *grown = realloc(markPool, newCapacity * sizeof(unsigned short));
+            if (grown == NULL) {
+                rankStudent(studentIndex);
+                return false;
+            }
+            markPool = grown;
+            markPoolCapacity = newCapacity;
+        }
+        markPoolHoles += student->markCount;
+        student->marksOffset = markPoolCount;
+        markPoolCount += count;
+    } else {
+        markPoolHoles += student->markCount - count;
+    }
+    
+    memcpy(markPool + student->marksOffset, marks, count * sizeof(unsigned short));
+    student->markCount = count;
+    student->marksGeneration = markPoolGeneration;
+    markPoolDirty = true;
+    markDirty(&studentTable, studentIndex);
+    rankStudent(studentIndex);
+    return true;
+}
+
+void clearMarks(int studentIndex) {
+    unrankStudent(studentIndex);
+    markPoolHoles += students[studentIndex].markCount;
+    students[studentIndex].markCount = 0;
+    students[studentIndex].grade = 'N';
+    markDirty(&studentTable, studentIndex);
+}
+
+// Packs live students' marks into a fresh pool of the next generation; every
+// student with marks is saved again with the new offset and generation
+void compactMarks() {
+    int live = markPoolCount - markPoolHoles;
+    unsigned short *pool = malloc((live > 0 ? live : 1) * sizeof(unsigned short));
+    if (pool == NULL) {
+        return; // keep the holes until there is memory to spare
+    }
+    
+    int count = 0;
+    for (int i = 0; i < studentCount; i++) {
+        Student *student = &students[i];
+        if (student->markCount == 0 || isTombstone(&studentTable, students, i)) {
+            continue;
+        }
+        memcpy(pool + count, markPool + student->marksOffset, student->markCount * sizeof(unsigned short));
+        student->marksOffset = count;
+        student->marksGeneration = markPoolGeneration + 1;
+        markDirty(&studentTable, i);
+        count += student->markCount;
+    }
+    
+    free(markPool);
+    markPool = pool;
+    markPoolCount = count;
+    markPoolCapacity = live > 0 ? live : 1;
+    markPoolHoles = 0;
+    markPoolDirty = true;
+    markPoolGeneration++;
+    markPoolMoved = true;
+}
+
+// Subjects of a course, falling back to the default list
+const CourseSubjects *findCourse(const char *course) {
+    for (int i = 0; i < courseCount; i++) {
+        if (!isTombstone(&courseTable, courses, i) && strcasecmp(courses[i].course, course) == 0) {
+            return &courses[i];
+        }
+    }
+    return &defaultSubjects;
+}
+
+// Counts every student with marks in their class
+void buildRanks() {
+    for (int i = 0; i < cohortCount; i++) {
+        memset(cohorts[i].tree, 0, (RANK_BUCKETS + 1) * sizeof(int));
+        cohorts[i].size = 0;
+    }
+    for (int i = 0; i < MAX_STUDENTS; i++) {
+        rankCohort[i] = -1; // including slots students added later will take
+    }
+    ranksBuilt = true;
+    for (int i = 0; i < studentCount; i++) {
+        rankStudent(i);
+    }
+}
+
+void dropRanks() {
+    ranksBuilt = false;
+}
+
+// Adds a student to their class under their current percentage. Callers
+// unrank first, so the counts never hold a student twice.
+void rankStudent(int studentIndex) {
+    const Student *student = &students[studentIndex];
+    if (!ranksBuilt || student->markCount == 0 || isTombstone(&studentTable, students, studentIndex)) {
+        return;
+    }
+    int cohort = findCohort(student->course, student->semester);
+    if (cohort == -1) {
+        dropRanks(); // out of memory: rebuild on the next lookup
+        return;
+    }
+    int bucket = percentageBucket(studentIndex);
+    fenwickAdd(cohorts[cohort].tree, bucket, 1);
+    cohorts[cohort].size++;
+    rankCohort[studentIndex] = cohort;
+    rankBucket[studentIndex] = bucket;
+}
+
+// Takes a student out of the class they were counted in, before their marks,
+// course or semester change
+void unrankStudent(int studentIndex) {
+    if (!ranksBuilt || rankCohort[studentIndex] == -1) {
+        return;
     }
+    Cohort *cohort = &cohorts[rankCohort[studentIndex]];
+    fenwickAdd(cohort->tree, rankBucket[studentIndex], -1);
+    cohort->size--;
+    rankCohort[studentIndex] = -1;
+}
+
+// Rank is one more than the classmates with a higher percentage (equal
+// percentages share a rank); percentile is the share of the class at or
+// below the student. False if the student has no marks.
+bool studentRank(int studentIndex, int *rank, int *classSize, double *percentile) {
+    if (!ranksBuilt) {
+        buildRanks();
+    }
+    if (!ranksBuilt || rankCohort[studentIndex] == -1) {
+        return false;
+    }
+    const Cohort *cohort = &cohorts[rankCohort[studentIndex]];
+    int atOrBelow = fenwickPrefix(cohort->tree, rankBucket[studentIndex]);
+    *rank = cohort->size - atOrBelow + 1;
+    *classSize = cohort->size;
+    *percentile = 100.0 * atOrBelow / cohort->size;
+    return true;
+}
+
+// Index of the class for a course (any case) and semester, created on first
+// use; -1 if out of memory
+int findCohort(const char *course, int semester) {
+    if (cohortCount * 2 >= cohortSlotCount) {
+        int slotCount = cohortSlotCount > 0 ? cohortSlotCount * 2 : 64;
+        int *slots = calloc(slotCount, sizeof(int));
+        if (slots == NULL) {
+            return -1;
+        }
+        for (int i = 0; i < cohortCount; i++) {
+            unsigned int slot = hashCohort(cohorts[i].course, cohorts[i].semester) & (slotCount - 1);
+            while (slots[slot] != 0) {
+                slot = (slot + 1) & (slotCount - 1);
+            }
+            slots[slot] = i + 1;
+        }
+        free(cohortSlots);
+        cohortSlots = slots;
+        cohortSlotCount = slotCount;
+    }
+    
+    unsigned int slot = hashCohort(course, semester) & (cohortSlotCount - 1);
+    while (cohortSlots[slot] != 0) {
+        const Cohort *cohort = &cohorts[cohortSlots[slot] - 1];
+        if (cohort->semester == semester && strcasecmp(cohort->course, course) == 0) {
+            return cohortSlots[slot] - 1;
+        }
+        slot = (slot + 1) & (cohortSlotCount - 1);
+    }
+    
+    if (cohortCount == cohortCapacity) {
+        int newCapacity = cohortCapacity > 0 ? cohortCapacity * 2 : 16;
+        Cohort *grown = realloc(cohorts, newCapacity * sizeof(Cohort));
+        if (grown == NULL) {
+            return -1;
+        }
+        cohorts = grown;
+        cohortCapacity = newCapacity;
+    }
+    int *tree = calloc(RANK_BUCKETS + 1, sizeof(int));
+    if (tree == NULL) {
+        return -1;
+    }
+    Cohort *cohort = &cohorts[cohortCount];
+    snprintf(cohort->course, sizeof(cohort->course), "%s", course);
+    cohort->semester = semester;
+    cohort->size = 0;
+    cohort->tree = tree;
+    cohortSlots[slot] = ++cohortCount;
+    return cohortCount - 1;
+}
+
+// FNV-1a over the lower-cased course name, mixed with the semester
+unsigned int hashCohort(const char *course, int semester) {
+    unsigned int hash = 2166136261U;
+    for (; *course != '\0'; course++) {
+        hash = (hash ^ (unsigned char)tolower((unsigned char)*course)) * 16777619U;
+    }
+    return (hash ^ (unsigned int)semester) * 16777619U;
+}
+
+// Percentage in hundredths, which is the average mark since marks are
+// stored in hundredths of 100
+int percentageBucket(int studentIndex) {
+    const Student *student = &students[studentIndex];
+    int total = 0;
+    for (int i = 0; i < student->markCount; i++) {
+        total += markPool[student->marksOffset + i];
+    }
+    int bucket = total / student->markCount;
+    return bucket < RANK_BUCKETS ? bucket : RANK_BUCKETS - 1;
+}
+
+void fenwickAdd(int *tree, int bucket, int delta) {
+    for (int i = bucket + 1; i <= RANK_BUCKETS; i += i & -i) {
+        tree[i] += delta;
+    }
+}
+
+// Students in buckets 0..bucket
+int fenwickPrefix(const int *tree, int bucket) {
+    int sum = 0;
+    for (int i = bucket + 1; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+// Students move to new slots, so the indexes over them are rebuilt on next use
+void compactStudents() {
+    studentCount = compactTable(&studentTable, students, studentCount);
+    dropRanks();
+    dropRollIndex();
+}
+
+int loadTable(TableFile *table, void *records, int maxRecords) {
+    FILE *file = fopen(table->filename, "rb");
+    if (file == NULL) {
+        table->savedCount = -1;
+        return 0;
+    }
+    
+    int count = fread(records, table->recordSize, maxRecords, file);
+    table->savedCount = fgetc(file) == EOF ? count : -1;
+    fclose(file);
+    
+    table->tombstones = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            table->tombstones++;
+        }
+    }
+    return count;
+}
+
+void markDirty(TableFile *table, int index) {
+    table->dirty[index] = true;
+}
+
+// Patches changed records in place; rewrites the file when it shrank
+bool saveTable(TableFile *table, const void *records, int count) {
+    const unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    
+    int fd = -1;
+    if (table->savedCount >= 0 && count >= table->savedCount) {
+        fd = open(table->filename, O_WRONLY);
+    }
+    if (fd != -1) {
+        bool ok = true;
+        int i = 0;
+        while (i < count && ok) {
+            if (i < table->savedCount && !table->dirty[i]) {
+                i++;
+                continue;
+            }
+            
+            int end = i + 1;
+            while (end < count && (end >= table->savedCount || table->dirty[end])) {
+                end++;
+            }
+            size_t length = (end - i) * size;
+            ok = pwrite(fd, bytes + i * size, length, (off_t)i * size) == (ssize_t)length;
+            i = end;
+        }
+        ok = fsync(fd) == 0 && ok;
+        close(fd);
+        
+        if (ok) {
+            memset(table->dirty, 0, count * sizeof(bool));
+            table->savedCount = count;
+            return true;
+        }
+    }
+    
+    char tempName[256];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", table->filename);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    fwrite(records, size, count, file);
+    bool ok = !ferror(file) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempName, table->filename) != 0) {
+        remove(tempName);
+        return false;
+    }
+    
+    memset(table->dirty, 0, count * sizeof(bool));
+    table->savedCount = count;
+    return true;
+}
+
+bool isTombstone(const TableFile *table, const void *records, int index) {
+    int id;
+    memcpy(&id, (const unsigned char *)records + index * table->recordSize + table->idOffset, sizeof(id));
+    return id == TOMBSTONE_ID;
+}
+
+void deleteRecord(TableFile *table, void *records, int index) {
+    int id = TOMBSTONE_ID;
+    memcpy((unsigned char *)records + index * table->recordSize + table->idOffset, &id, sizeof(id));
+    table->tombstones++;
+    markDirty(table, index);
+}
+
+// Positions change, so the next save rewrites the file
+int compactTable(TableFile *table, void *records, int count) {
+    unsigned char *bytes = records;
+    size_t size = table->recordSize;
+    int live = 0;
+    for (int i = 0; i < count; i++) {
+        if (isTombstone(table, records, i)) {
+            continue;
+        }
+        if (live != i) {
+            memcpy(bytes + live * size, bytes + i * size, size);
+        }
+        live++;
+    }
+    table->tombstones = 0;
+    table->savedCount = -1;
+    return live;
 }
 
 int authenticateAdmin() {
@@ -157,7 +957,10 @@ void adminMenu() {
         printf("5. Delete Student Record\n");
         printf("6. Add/Update Marks\n");
         printf("7. Update Attendance\n");
-        printf("8. Back to Main Menu\n");
+        printf("8. Subject Catalogue\n");
+        printf("9. Cohort Statistics\n");
+        printf("10. List Students by Roll Number Range\n");
+        printf("11. Back to Main Menu\n");
         printf("======================\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
@@ -197,10 +1000,102 @@ void adminMenu() {
                 }
                 break;
             }
-            case 8: printf("Returning to main menu...\n"); break;
+            case 8: manageSubjectCatalogue(); break;
+            case 9: cohortReport(); break;
+            case 10: listStudentsByRollRange(); break;
+            case 11: printf("Returning to main menu...\n"); break;
             default: printf("Invalid choice. Please try again.\n");
         }
-    } while(choice != 8);
+    } while(choice != 11);
+}
+
+void manageSubjectCatalogue() {
+    printf("\n===== SUBJECT CATALOGUE =====\n");
+    printf("%-20s", "(default)");
+    for (int s = 0; s < defaultSubjects.subjectCount; s++) {
+        printf("%s%s", s > 0 ? ", " : "", defaultSubjects.subjects[s]);
+    }
+    printf("\n");
+    for (int i = 0; i < courseCount; i++) {
+        if (isTombstone(&courseTable, courses, i)) {
+            continue;
+        }
+        printf("%-20s", courses[i].course);
+        for (int s = 0; s < courses[i].subjectCount; s++) {
+            printf("%s%s", s > 0 ? ", " : "", courses[i].subjects[s]);
+        }
+        printf("\n");
+    }
+    
+    char course[50];
+    printf("\nCourse to set up (blank to go back): ");
+    if (fgets(course, sizeof(course), stdin) == NULL) {
+        return;
+    }
+    if (strchr(course, '\n') == NULL) {
+        clearInputBuffer();
+    }
+    course[strcspn(course, "\n")] = '\0';
+    if (course[0] == '\0') {
+        return;
+    }
+    
+    int count = -1;
+    printf("Number of subjects (1-%d, 0 to remove the course): ", MAX_COURSE_SUBJECTS);
+    scanf("%d", &count);
+    clearInputBuffer();
+    if (count < 0 || count > MAX_COURSE_SUBJECTS) {
+        printf("Invalid number of subjects!\n");
+        return;
+    }
+    
+    int index = -1;
+    for (int i = 0; i < courseCount; i++) {
+        if (!isTombstone(&courseTable, courses, i) && strcasecmp(courses[i].course, course) == 0) {
+            index = i;
+        }
+    }
+    if (count == 0) {
+        if (index == -1) {
+            printf("Course not found!\n");
+            return;
+        }
+        deleteRecord(&courseTable, courses, index);
+        printf("Course removed; its students now take the default subjects.\n");
+        return;
+    }
+    
+    CourseSubjects entry;
+    memset(&entry, 0, sizeof(entry));
+    strcpy(entry.course, course);
+    entry.subjectCount = count;
+    for (int s = 0; s < count; s++) {
+        printf("Subject %d: ", s + 1);
+        if (fgets(entry.subjects[s], sizeof(entry.subjects[s]), stdin) == NULL) {
+            return;
+        }
+        if (strchr(entry.subjects[s], '\n') == NULL) {
+            clearInputBuffer();
+        }
+        entry.subjects[s][strcspn(entry.subjects[s], "\n")] = '\0';
+        if (entry.subjects[s][0] == '\0') {
+            snprintf(entry.subjects[s], sizeof(entry.subjects[s]), "Subject %d", s + 1);
+        }
+    }
+    
+    if (index == -1) {
+        if (courseCount >= MAX_COURSES && courseTable.tombstones > 0) {
+            courseCount = compactTable(&courseTable, courses, courseCount);
+        }
+        if (courseCount >= MAX_COURSES) {
+            printf("Maximum number of courses reached!\n");
+            return;
+        }
+        index = courseCount++;
+    }
+    courses[index] = entry;
+    markDirty(&courseTable, index);
+    printf("Subjects saved. Marks already entered stay matched to subjects by position.\n");
 }
 
 void studentMenu(int studentIndex) {
@@ -231,6 +1126,9 @@ void studentMenu(int studentIndex) {
 }
 
 void addStudent() {
+    if (studentCount >= MAX_STUDENTS && studentTable.tombstones > 0) {
+        compactStudents(); // make room from deleted slots
+    }
     if (studentCount >= MAX_STUDENTS) {
         printf("Maximum number of students reached!\n");
         return;
@@ -244,6 +1142,11 @@ void addStudent() {
     scanf("%d", &newStudent.rollNumber);
     clearInputBuffer();
     
+    if (newStudent.rollNumber <= 0) {
+        printf("Roll number must be positive!\n");
+        return;
+    }
+    
     // Check if roll number already exists
     if (findStudentByRollNumber(newStudent.rollNumber) != -1) {
         printf("Student with this roll number already exists!\n");
@@ -271,36 +1174,97 @@ void addStudent() {
     scanf("%d", &newStudent.semester);
     clearInputBuffer();
     
-    // Initialize marks to 0
-    for (int i = 0; i < MAX_SUBJECTS; i++) {
-        newStudent.marks[i] = 0;
-    }
-    
     newStudent.attendance = 0;
     newStudent.grade = 'N'; // 'N' for Not Available
+    newStudent.markCount = 0; // no space in the marks store until marks are entered
+    newStudent.marksGeneration = 0;
+    newStudent.marksOffset = 0;
     
+    markDirty(&studentTable, studentCount);
     students[studentCount++] = newStudent;
+    rollIndexInsert(newStudent.rollNumber, studentCount - 1);
     
     printf("\nStudent added successfully!\n");
 }
 
 void displayAllStudents() {
-    printf("\n===== ALL STUDENTS =====\n");
-    printf("%-10s %-20s %-5s %-5s %-15s %-5s %-5s %s\n", 
-           "Roll No.", "Name", "Age", "Gen", "Course", "Sem", "Att%", "Grade");
-    printf("--------------------------------------------------------------------\n");
+    printStudentTableHeader("ALL STUDENTS");
     
+    int total = studentCount - studentTable.tombstones;
+    int shown = 0;
     for (int i = 0; i < studentCount; i++) {
-        printf("%-10d %-20s %-5d %-5c %-15s %-5d %-5d %c\n", 
-               students[i].rollNumber,
-               students[i].name,
-               students[i].age,
-               students[i].gender,
-               students[i].course,
-               students[i].semester,
-               students[i].attendance,
-               students[i].grade);
+        if (students[i].rollNumber == TOMBSTONE_ID) {
+            continue;
+        }
+        if (shown > 0 && shown % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(shown, total)) {
+                return;
+            }
+        }
+        tableStudentRow(&tableOut, i);
+        shown++;
     }
+    tableFlush(&tableOut);
+}
+
+// Students whose roll numbers fall in a range (a batch such as 2024000 to
+// 2024999), in roll number order, walked off the index
+void listStudentsByRollRange() {
+    int from = 0;
+    int to = -1;
+    printf("\nFrom roll number: ");
+    scanf("%d", &from);
+    clearInputBuffer();
+    printf("To roll number: ");
+    scanf("%d", &to);
+    clearInputBuffer();
+    if (from > to) {
+        printf("Invalid range!\n");
+        return;
+    }
+    if (!rollIndexBuilt && !rebuildRollIndex()) {
+        printf("Out of memory!\n");
+        return;
+    }
+    
+    // Count first so pages can show the total; leaves wholly inside the
+    // range are counted without looking at their keys
+    RollCursor start = rollIndexSeek(from);
+    int total = 0;
+    for (RollCursor cursor = start; cursor.leaf < rollLeafCount; ) {
+        const RollLeaf *leaf = rollLeaves[cursor.leaf];
+        if (cursor.position == 0 && leaf->rolls[leaf->count - 1] <= to) {
+            total += leaf->count;
+            cursor.leaf++;
+            continue;
+        }
+        if (leaf->rolls[cursor.position] > to) {
+            break;
+        }
+        total++;
+        rollCursorNext(&cursor);
+    }
+    if (total == 0) {
+        printf("No students found in this range.\n");
+        return;
+    }
+    
+    char title[64];
+    snprintf(title, sizeof(title), "STUDENTS %d TO %d", from, to);
+    printStudentTableHeader(title);
+    int shown = 0;
+    for (RollCursor cursor = start; shown < total; rollCursorNext(&cursor)) {
+        if (shown > 0 && shown % PAGE_ROWS == 0) {
+            tableFlush(&tableOut);
+            if (!nextPage(shown, total)) {
+                return;
+            }
+        }
+        tableStudentRow(&tableOut, rollLeaves[cursor.leaf]->indexes[cursor.position]);
+        shown++;
+    }
+    tableFlush(&tableOut);
 }
 
 void searchStudent() {
@@ -334,6 +1298,8 @@ void updateStudent() {
         int intInput;
         float floatInput;
         
+        unrankStudent(index); // course and semester pick the class
+        
         printf("Name [%s]: ", students[index].name);
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = '\0';
@@ -357,7 +1323,12 @@ void updateStudent() {
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = '\0';
         if (strlen(input) > 0) {
+            const CourseSubjects *before = findCourse(students[index].course);
             strcpy(students[index].course, input);
+            if (findCourse(students[index].course) != before && students[index].markCount > 0) {
+                clearMarks(index);
+                printf("Marks cleared: the new course has different subjects.\n");
+            }
         }
         
         printf("Semester [%d]: ", students[index].semester);
@@ -366,6 +1337,8 @@ void updateStudent() {
         }
         clearInputBuffer();
         
+        markDirty(&studentTable, index);
+        rankStudent(index);
         printf("\nStudent record updated successfully!\n");
     } else {
         printf("Student not found!\n");
@@ -380,11 +1353,9 @@ void deleteStudent() {
     
     int index = findStudentByRollNumber(rollNumber);
     if (index != -1) {
-        // Shift all students after this one forward
-        for (int i = index; i < studentCount - 1; i++) {
-            students[i] = students[i + 1];
-        }
-        studentCount--;
+        clearMarks(index);
+        rollIndexRemove(rollNumber, index);
+        deleteRecord(&studentTable, students, index);
         printf("Student deleted successfully!\n");
     } else {
         printf("Student not found!\n");
@@ -392,43 +1363,73 @@ void deleteStudent() {
 }
 
 void addMarks(int studentIndex) {
+    const CourseSubjects *course = findCourse(students[studentIndex].course);
     printf("\n===== ENTER MARKS FOR %s =====\n", students[studentIndex].name);
     
-    for (int i = 0; i < MAX_SUBJECTS; i++) {
-        printf("%s: ", subjects[i]);
-        scanf("%f", &students[studentIndex].marks[i]);
+    unsigned short marks[MAX_COURSE_SUBJECTS];
+    for (int i = 0; i < course->subjectCount; i++) {
+        float mark = -1;
+        printf("%s: ", course->subjects[i]);
+        scanf("%f", &mark);
         clearInputBuffer();
         
         // Validate marks (0-100)
-        while (students[studentIndex].marks[i] < 0 || students[studentIndex].marks[i] > 100) {
+        while (!(mark >= 0 && mark <= 100)) {
             printf("Invalid marks! Enter again (0-100): ");
-            scanf("%f", &students[studentIndex].marks[i]);
+            scanf("%f", &mark);
             clearInputBuffer();
         }
+        marks[i] = (unsigned short)(mark * 100 + 0.5f);
     }
     
+    if (!storeMarks(studentIndex, marks, course->subjectCount)) {
+        printf("Out of memory!\n");
+        return;
+    }
     calculateGrade(studentIndex);
     printf("\nMarks added successfully!\n");
 }
 
 void viewReportCard(int studentIndex) {
+    const Student *student = &students[studentIndex];
+    const CourseSubjects *course = findCourse(student->course);
     printf("\n===== REPORT CARD =====\n");
-    printf("Name: %s\n", students[studentIndex].name);
-    printf("Roll Number: %d\n", students[studentIndex].rollNumber);
-    printf("Course: %s, Semester: %d\n", students[studentIndex].course, students[studentIndex].semester);
+    printf("Name: %s\n", student->name);
+    printf("Roll Number: %d\n", student->rollNumber);
+    printf("Course: %s, Semester: %d\n", student->course, student->semester);
     printf("\n%-15s %s\n", "Subject", "Marks");
     printf("----------------------\n");
     
-    float total = 0;
-    for (int i = 0; i < MAX_SUBJECTS; i++) {
-        printf("%-15s %.2f\n", subjects[i], students[studentIndex].marks[i]);
-        total += students[studentIndex].marks[i];
+    // Marks follow the course's subjects by position; if the list changed
+    // after marks were entered, subjects without one show "-"
+    int rows = course->subjectCount > student->markCount ? course->subjectCount : student->markCount;
+    int total = 0;
+    for (int i = 0; i < rows; i++) {
+        char label[30];
+        snprintf(label, sizeof(label), "%s", i < course->subjectCount ? course->subjects[i] : "Other");
+        if (i < student->markCount) {
+            unsigned short mark = markPool[student->marksOffset + i];
+            printf("%-15s %.2f\n", label, mark / 100.0);
+            total += mark;
+        } else {
+            printf("%-15s -\n", label);
+        }
+    }
+    
+    if (student->markCount == 0) {
+        printf("\nNo marks entered yet.\n");
+        return;
     }
+    printf("\nTotal Marks: %.2f/%d\n", total / 100.0, student->markCount * 100);
+    printf("Percentage: %.2f%%\n", total / (student->markCount * 100.0));
+    printf("Grade: %c\n", student->grade);
     
-    float percentage = total / MAX_SUBJECTS;
-    printf("\nTotal Marks: %.2f/500\n", total);
-    printf("Percentage: %.2f%%\n", percentage);
-    printf("Grade: %c\n", students[studentIndex].grade);
+    int rank, classSize;
+    double percentile;
+    if (studentRank(studentIndex, &rank, &classSize, &percentile)) {
+        printf("Class Rank: %d of %d\n", rank, classSize);
+        printf("Percentile: %.2f\n", percentile);
+    }
 }
 
 void updateAttendance(int studentIndex) {
@@ -447,25 +1448,582 @@ void updateAttendance(int studentIndex) {
     }
     
     students[studentIndex].attendance = attendance;
+    markDirty(&studentTable, studentIndex);
     printf("Attendance updated successfully!\n");
 }
 
 void calculateGrade(int studentIndex) {
-    float total = 0;
-    for (int i = 0; i < MAX_SUBJECTS; i++) {
-        total += students[studentIndex].marks[i];
+    const Student *student = &students[studentIndex];
+    int total = 0;
+    for (int i = 0; i < student->markCount; i++) {
+        total += markPool[student->marksOffset + i];
+    }
+    
+    if (student->markCount == 0) {
+        students[studentIndex].grade = 'N';
+    } else {
+        float percentage = total / (student->markCount * 100.0f);
+        students[studentIndex].grade = gradeForPercentage(percentage);
+    }
+    markDirty(&studentTable, studentIndex);
+}
+
+// Letter grade as a sum of comparisons instead of a branch chain, so the grade
+// kernel can evaluate it for many students at once
+char gradeForPercentage(float percentage) {
+    return 'F' - (percentage >= 50) - (percentage >= 60) - (percentage >= 70) -
+           (percentage >= 80) - (percentage >= 90);
+}
+
+// Non-interactive marks entry: one "roll,mark1,...,markN" row per student,
+// with the marks in the order of the student's course subjects. A first line
+// that does not start with a digit is taken as a header; blank lines and '#'
+// comments are skipped. Rejected rows go to <path>.rejected with the reason.
+int importMarks(const char *path) {
+    FILE *input = fopen(path, "rb");
+    if (input == NULL) {
+        printf("Could not open %s!\n", path);
+        return 1;
+    }
+    
+    char rejectsPath[512];
+    snprintf(rejectsPath, sizeof(rejectsPath), "%s.rejected", path);
+    FILE *rejects = fopen(rejectsPath, "w");
+    
+    static MarksBlock block;
+    char *buffer = malloc(IMPORT_READ_BUFFER + 1);
+    if (buffer == NULL || (!rollIndexBuilt && !rebuildRollIndex())) {
+        printf("Out of memory!\n");
+        free(buffer);
+        fclose(input);
+        if (rejects != NULL) {
+            fclose(rejects);
+        }
+        return 1;
+    }
+    
+    ImportStats stats;
+    memset(&stats, 0, sizeof(stats));
+    block.count = 0;
+    block.subjectRows = 0;
+    
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    // Split complete lines in place, carry the trailing partial line over
+    long long lineNumber = 0;
+    size_t filled = fread(buffer, 1, IMPORT_READ_BUFFER, input);
+    size_t used = 0;
+    for (;;) {
+        bool atEof = filled < IMPORT_READ_BUFFER;
+        for (;;) {
+            char *lineStart = buffer + used;
+            char *newline = memchr(lineStart, '\n', filled - used);
+            if (newline == NULL) {
+                if (!atEof || used == filled) {
+                    break;
+                }
+                newline = buffer + filled; // last line without a newline
+            }
+            *newline = '\0';
+            used = newline - buffer + (newline < buffer + filled ? 1 : 0);
+            lineNumber++;
+            
+            char *trimmed = lineStart;
+            while (*trimmed == ' ' || *trimmed == '\t' || *trimmed == '\r') {
+                trimmed++;
+            }
+            if (*trimmed == '\0' || *trimmed == '#' || (lineNumber == 1 && !isdigit((unsigned char)*trimmed))) {
+                continue;
+            }
+            
+            stats.read++;
+            const char *reason = stageMarksRow(&block, trimmed, &stats);
+            if (reason != NULL) {
+                if (rejects != NULL) {
+                    for (char *c = trimmed; c < newline; c++) {
+                        if (*c == '\0') {
+                            *c = ','; // undo the field splitting for the report
+                        }
+                    }
+                    fprintf(rejects, "%lld,%s,%s\n", lineNumber, reason, trimmed);
+                }
+                continue;
+            }
+            if (block.count == IMPORT_BLOCK) {
+                applyMarksBlock(&block, &stats);
+            }
+        }
+        if (atEof) {
+            break;
+        }
+        
+        size_t leftover = filled - used;
+        if (leftover == IMPORT_READ_BUFFER) {
+            // A single line longer than the whole buffer: skip to its end, so it
+            // is counted once and the line numbers after it stay right
+            lineNumber++;
+            stats.read++;
+            stats.malformed++;
+            if (rejects != NULL) {
+                fprintf(rejects, "%lld,line too long,\n", lineNumber);
+            }
+            char *newline = NULL;
+            leftover = 0;
+            while (newline == NULL && (filled = fread(buffer, 1, IMPORT_READ_BUFFER, input)) > 0) {
+                newline = memchr(buffer, '\n', filled);
+            }
+            if (newline != NULL) {
+                used = newline + 1 - buffer;
+                leftover = filled - used;
+            }
+        }
+        memmove(buffer, buffer + used, leftover);
+        filled = leftover + fread(buffer + leftover, 1, IMPORT_READ_BUFFER - leftover, input);
+        used = 0;
+    }
+    applyMarksBlock(&block, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printImportSummary(&stats, seconds, rejects != NULL ? rejectsPath : NULL);
+    
+    free(buffer);
+    fclose(input);
+    if (rejects != NULL) {
+        fclose(rejects);
+    }
+    return 0;
+}
+
+// Checks one row and adds it to the block; returns why it was rejected, or
+// NULL. Marks go straight into their subject rows of the block.
+const char *stageMarksRow(MarksBlock *block, char *line, ImportStats *stats) {
+    char *fields[MAX_COURSE_SUBJECTS + 1];
+    int fieldCount = splitFields(line, fields, MAX_COURSE_SUBJECTS + 1);
+    char *end;
+    long number = fieldCount >= 2 ? strtol(fields[0], &end, 10) : 0;
+    if (fieldCount < 2 || end == fields[0] || *end != '\0' || number <= 0 || number > INT_MAX) {
+        stats->malformed++;
+        return "malformed";
+    }
+    
+    int studentIndex = findStudentByRollNumber((int)number);
+    if (studentIndex == -1) {
+        stats->unknownStudent++;
+        return "unknown student";
+    }
+    const CourseSubjects *course = findCourse(students[studentIndex].course);
+    if (fieldCount - 1 != course->subjectCount) {
+        stats->wrongSubjectCount++;
+        return "wrong number of marks";
+    }
+    
+    int row = block->count;
+    bool inRange = true;
+    for (int s = 0; s < MAX_COURSE_SUBJECTS; s++) {
+        float mark = 0;
+        if (s < course->subjectCount && !parseMark(fields[s + 1], &mark)) {
+            stats->malformed++;
+            return "malformed";
+        }
+        inRange = inRange && mark >= 0 && mark <= 100;
+        block->marks[s][row] = inRange ? (unsigned short)(mark * 100 + 0.5f) : 0;
+    }
+    if (!inRange) {
+        stats->outOfRange++;
+        return "marks out of range";
+    }
+    
+    block->subjectCounts[row] = course->subjectCount;
+    block->targets[row] = studentIndex;
+    if (course->subjectCount > block->subjectRows) {
+        block->subjectRows = course->subjectCount;
+    }
+    block->count++;
+    return NULL;
+}
+
+// Splits a line at commas in place; -1 if it has more than maxFields fields
+int splitFields(char *line, char **fields, int maxFields) {
+    int fieldCount = 0;
+    char *cursor = line;
+    for (;;) {
+        if (fieldCount == maxFields) {
+            return -1;
+        }
+        fields[fieldCount++] = cursor;
+        char *comma = strchr(cursor, ',');
+        if (comma == NULL) {
+            return fieldCount;
+        }
+        *comma = '\0';
+        cursor = comma + 1;
+    }
+}
+
+bool parseMark(const char *text, float *mark) {
+    char *end;
+    float value = strtof(text, &end);
+    while (*end == ' ' || *end == '\r') {
+        end++;
+    }
+    if (end == text || *end != '\0' || value != value) {
+        return false;
+    }
+    *mark = value;
+    return true;
+}
+
+// Grades a block of imported rows and stores the results with the students
+void applyMarksBlock(MarksBlock *block, ImportStats *stats) {
+    computeGrades(block);
+    for (int i = 0; i < block->count; i++) {
+        int index = block->targets[i];
+        unsigned short marks[MAX_COURSE_SUBJECTS];
+        for (int s = 0; s < block->subjectCounts[i]; s++) {
+            marks[s] = block->marks[s][i];
+        }
+        if (!storeMarks(index, marks, block->subjectCounts[i])) {
+            continue; // out of memory: counted as read but not imported
+        }
+        students[index].grade = block->grades[i];
+        stats->percentageSum += block->percentages[i];
+        stats->imported++;
+    }
+    block->count = 0;
+    block->subjectRows = 0;
+}
+
+// Totals, percentages and grades for a whole block. Marks are stored subject
+// by subject and every loop runs the full fixed length with no branches, so
+// the compiler turns each into SIMD code; rows past block->count are ignored.
+// The arithmetic matches calculateGrade() for identical results.
+void computeGrades(MarksBlock *block) {
+    for (int i = 0; i < IMPORT_BLOCK; i++) {
+        block->totals[i] = 0;
+    }
+    for (int s = 0; s < block->subjectRows; s++) {
+        for (int i = 0; i < IMPORT_BLOCK; i++) {
+            block->totals[i] += block->marks[s][i];
+        }
+    }
+    for (int i = 0; i < IMPORT_BLOCK; i++) {
+        int subjects = block->subjectCounts[i] > 0 ? block->subjectCounts[i] : 1;
+        block->percentages[i] = block->totals[i] / (subjects * 100.0f);
+        block->grades[i] = gradeForPercentage(block->percentages[i]);
+    }
+}
+
+void printImportSummary(const ImportStats *stats, double seconds, const char *rejectsPath) {
+    long long rejected = stats->read - stats->imported;
+    
+    printf("\n===== MARKS IMPORT SUMMARY =====\n");
+    printf("Rows read: %lld\n", stats->read);
+    printf("Imported: %lld\n", stats->imported);
+    printf("Rejected: %lld\n", rejected);
+    printf("  Malformed: %lld\n", stats->malformed);
+    printf("  Unknown student: %lld\n", stats->unknownStudent);
+    printf("  Wrong number of marks: %lld\n", stats->wrongSubjectCount);
+    printf("  Marks out of range: %lld\n", stats->outOfRange);
+    if (stats->imported > 0) {
+        printf("Average percentage: %.2f%%\n", stats->percentageSum / stats->imported);
+    }
+    printf("Elapsed: %.3f s\n", seconds);
+    printf("Throughput: %.0f rows/s\n", seconds > 0 ? stats->read / seconds : 0.0);
+    if (rejected > 0 && rejectsPath != NULL) {
+        printf("Rejected rows written to %s\n", rejectsPath);
+    }
+}
+
+// Admin report for a course (or every course) and optionally one semester.
+// Per-subject figures need a single course, since subjects differ between
+// courses.
+void cohortReport() {
+    char course[50];
+    printf("\nCourse (blank for all courses): ");
+    if (fgets(course, sizeof(course), stdin) == NULL) {
+        return;
+    }
+    if (strchr(course, '\n') == NULL) {
+        clearInputBuffer();
+    }
+    course[strcspn(course, "\n")] = '\0';
+    
+    int semester = -1;
+    printf("Semester (0 for all semesters): ");
+    scanf("%d", &semester);
+    clearInputBuffer();
+    if (semester < 0) {
+        printf("Invalid semester!\n");
+        return;
+    }
+    
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CohortStats stats;
+    int threads = collectCohortStats(&stats, course[0] != '\0' ? course : NULL, semester);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    if (stats.studentsMatched == 0) {
+        printf("No students found in this cohort.\n");
+        return;
+    }
+    
+    printf("\n===== COHORT STATISTICS =====\n");
+    printf("Course: %s\n", course[0] != '\0' ? course : "All courses");
+    if (semester != 0) {
+        printf("Semester: %d\n", semester);
+    } else {
+        printf("Semester: All semesters\n");
+    }
+    printf("Students: %lld (%lld with marks)\n", stats.studentsMatched, stats.percentage.count);
+    
+    printf("\n%-15s %8s %8s %9s %8s %8s %8s\n", "", "Count", "Mean", "Variance", "Std Dev", "Min", "Max");
+    if (course[0] != '\0') {
+        const CourseSubjects *subjects = findCourse(course);
+        for (int s = 0; s < subjects->subjectCount; s++) {
+            printStatsRow(subjects->subjects[s], &stats.subjects[s]);
+        }
+    }
+    printStatsRow("Percentage", &stats.percentage);
+    
+    if (course[0] != '\0') {
+        const CourseSubjects *subjects = findCourse(course);
+        printf("\nMarks by band:\n%-15s", "Subject");
+        for (int b = 0; b < HISTOGRAM_BANDS; b++) {
+            char band[16];
+            snprintf(band, sizeof(band), b < HISTOGRAM_BANDS - 1 ? "%d-%d" : "%d-100", b * 10, b * 10 + 9);
+            printf(" %7s", band);
+        }
+        printf("\n");
+        for (int s = 0; s < subjects->subjectCount; s++) {
+            printf("%-15s", subjects->subjects[s]);
+            for (int b = 0; b < HISTOGRAM_BANDS; b++) {
+                printf(" %7lld", stats.histograms[s][b]);
+            }
+            printf("\n");
+        }
+    }
+    
+    printf("\nGrade distribution:\n");
+    for (int g = 0; g < GRADE_KINDS; g++) {
+        char label[16];
+        if (g < GRADE_KINDS - 1) {
+            snprintf(label, sizeof(label), "%c", 'A' + g);
+        } else {
+            snprintf(label, sizeof(label), "No marks");
+        }
+        double share = 100.0 * stats.grades[g] / stats.studentsMatched;
+        printf("%-9s %7lld %6.2f%% ", label, stats.grades[g], share);
+        for (int bar = 0; bar < (int)(share * 0.4 + 0.5); bar++) {
+            putchar('#');
+        }
+        printf("\n");
+    }
+    
+    const RunningCorrelation *corr = &stats.attendance;
+    if (corr->count > 1 && corr->m2X > 0 && corr->m2Y > 0) {
+        printf("\nAttendance vs percentage correlation: %.3f\n", corr->coMoment / sqrt(corr->m2X * corr->m2Y));
+    } else {
+        printf("\nAttendance vs percentage correlation: n/a\n");
+    }
+    printf("Computed in %.3f s using %d thread%s\n", seconds, threads, threads == 1 ? "" : "s");
+}
+
+// One pass over students[], split into a slice per thread with separate
+// accumulators that are merged afterwards. Returns the threads used.
+int collectCohortStats(CohortStats *total, const char *course, int semester) {
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > STATS_MAX_THREADS) {
+        threads = STATS_MAX_THREADS;
+    }
+    if (threads > studentCount / STATS_MIN_ROWS) {
+        threads = studentCount / STATS_MIN_ROWS;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    
+    CohortStats slices[STATS_MAX_THREADS];
+    pthread_t workers[STATS_MAX_THREADS];
+    bool started[STATS_MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        memset(&slices[t], 0, sizeof(CohortStats));
+        slices[t].course = course;
+        slices[t].semester = semester;
+        slices[t].begin = (int)((long long)studentCount * t / threads);
+        slices[t].end = (int)((long long)studentCount * (t + 1) / threads);
+    }
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&workers[t], NULL, cohortStatsWorker, &slices[t]) == 0;
+        if (!started[t]) {
+            cohortStatsWorker(&slices[t]); // no thread to spare: do the slice here
+        }
+    }
+    cohortStatsWorker(&slices[0]);
+    
+    *total = slices[0];
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(workers[t], NULL);
+        }
+        const CohortStats *slice = &slices[t];
+        total->studentsMatched += slice->studentsMatched;
+        for (int s = 0; s < MAX_COURSE_SUBJECTS; s++) {
+            mergeStats(&total->subjects[s], &slice->subjects[s]);
+            for (int b = 0; b < HISTOGRAM_BANDS; b++) {
+                total->histograms[s][b] += slice->histograms[s][b];
+            }
+        }
+        mergeStats(&total->percentage, &slice->percentage);
+        mergeCorrelation(&total->attendance, &slice->attendance);
+        for (int g = 0; g < GRADE_KINDS; g++) {
+            total->grades[g] += slice->grades[g];
+        }
+    }
+    return threads;
+}
+
+// Accumulates one slice locally and writes it back at the end, so threads
+// do not share cache lines while they run
+void *cohortStatsWorker(void *arg) {
+    CohortStats *slice = arg;
+    CohortStats stats = *slice;
+    const CourseSubjects *subjects = stats.course != NULL ? findCourse(stats.course) : NULL;
+    
+    for (int i = stats.begin; i < stats.end; i++) {
+        const Student *student = &students[i];
+        if (isTombstone(&studentTable, students, i) ||
+            (stats.semester != 0 && student->semester != stats.semester) ||
+            (stats.course != NULL && strcasecmp(student->course, stats.course) != 0)) {
+            continue;
+        }
+        stats.studentsMatched++;
+        if (student->markCount == 0) {
+            stats.grades[GRADE_KINDS - 1]++;
+            continue;
+        }
+        
+        // Marks past the course's subjects (the list shrank after they were
+        // entered) count towards the percentage only
+        const unsigned short *marks = markPool + student->marksOffset;
+        int subjectMarks = subjects == NULL ? 0 :
+                           student->markCount < subjects->subjectCount ? student->markCount : subjects->subjectCount;
+        int total = 0;
+        for (int s = 0; s < student->markCount; s++) {
+            total += marks[s];
+            if (s < subjectMarks) {
+                int band = marks[s] / 1000;
+                addStat(&stats.subjects[s], marks[s] / 100.0);
+                stats.histograms[s][band < HISTOGRAM_BANDS ? band : HISTOGRAM_BANDS - 1]++;
+            }
+        }
+        double percentage = total / (student->markCount * 100.0);
+        addStat(&stats.percentage, percentage);
+        addCorrelation(&stats.attendance, student->attendance, percentage);
+        
+        int grade = student->grade - 'A';
+        stats.grades[grade >= 0 && grade < GRADE_KINDS - 1 ? grade : GRADE_KINDS - 1]++;
     }
-    float percentage = total / MAX_SUBJECTS;
     
-    if (percentage >= 90) students[studentIndex].grade = 'A';
-    else if (percentage >= 80) students[studentIndex].grade = 'B';
-    else if (percentage >= 70) students[studentIndex].grade = 'C';
-    else if (percentage >= 60) students[studentIndex].grade = 'D';
-    else if (percentage >= 50) students[studentIndex].grade = 'E';
-    else students[studentIndex].grade = 'F';
+    *slice = stats;
+    return NULL;
+}
+
+void addStat(RunningStats *stats, double value) {
+    if (stats->count == 0 || value < stats->min) {
+        stats->min = value;
+    }
+    if (stats->count == 0 || value > stats->max) {
+        stats->max = value;
+    }
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+// Combines two partial results (Chan et al.), as if one pass had seen both
+void mergeStats(RunningStats *into, const RunningStats *from) {
+    if (from->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *from;
+        return;
+    }
+    long long count = into->count + from->count;
+    double delta = from->mean - into->mean;
+    into->m2 += from->m2 + delta * delta * ((double)into->count * from->count / count);
+    into->mean += delta * from->count / count;
+    if (from->min < into->min) {
+        into->min = from->min;
+    }
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+    into->count = count;
+}
+
+void addCorrelation(RunningCorrelation *corr, double x, double y) {
+    corr->count++;
+    double deltaX = x - corr->meanX;
+    double deltaY = y - corr->meanY;
+    corr->meanX += deltaX / corr->count;
+    corr->meanY += deltaY / corr->count;
+    corr->m2X += deltaX * (x - corr->meanX);
+    corr->m2Y += deltaY * (y - corr->meanY);
+    corr->coMoment += deltaX * (y - corr->meanY);
+}
+
+void mergeCorrelation(RunningCorrelation *into, const RunningCorrelation *from) {
+    if (from->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *from;
+        return;
+    }
+    long long count = into->count + from->count;
+    double deltaX = from->meanX - into->meanX;
+    double deltaY = from->meanY - into->meanY;
+    double weight = (double)into->count * from->count / count;
+    into->m2X += from->m2X + deltaX * deltaX * weight;
+    into->m2Y += from->m2Y + deltaY * deltaY * weight;
+    into->coMoment += from->coMoment + deltaX * deltaY * weight;
+    into->meanX += deltaX * from->count / count;
+    into->meanY += deltaY * from->count / count;
+    into->count = count;
 }
 
+// Variance over the whole cohort (population, not sample)
+void printStatsRow(const char *label, const RunningStats *stats) {
+    if (stats->count == 0) {
+        printf("%-15s %8d %8s %9s %8s %8s %8s\n", label, 0, "-", "-", "-", "-", "-");
+        return;
+    }
+    double variance = stats->m2 / stats->count;
+    printf("%-15s %8lld %8.2f %9.2f %8.2f %8.2f %8.2f\n", label, stats->count, stats->mean,
+           variance, sqrt(variance), stats->min, stats->max);
+}
+
+// Looks the roll number up in the index, falling back to a scan only if
+// there is no memory to build it
 int findStudentByRollNumber(int rollNumber) {
+    if (rollNumber == TOMBSTONE_ID) {
+        return -1;
+    }
+    if (rollIndexBuilt || rebuildRollIndex()) {
+        RollCursor cursor = rollIndexSeek(rollNumber);
+        if (cursor.leaf < rollLeafCount && rollLeaves[cursor.leaf]->rolls[cursor.position] == rollNumber) {
+            return rollLeaves[cursor.leaf]->indexes[cursor.position];
+        }
+        return -1;
+    }
     for (int i = 0; i < studentCount; i++) {
         if (students[i].rollNumber == rollNumber) {
             return i;
@@ -474,6 +2032,224 @@ int findStudentByRollNumber(int rollNumber) {
     return -1;
 }
 
+// Sorts the live students and packs them into leaves ROLL_LEAF_FILL at a time
+bool rebuildRollIndex() {
+    dropRollIndex();
+    RollEntry *entries = malloc((studentCount > 0 ? studentCount : 1) * sizeof(RollEntry));
+    if (entries == NULL) {
+        return false;
+    }
+    int count = 0;
+    for (int i = 0; i < studentCount; i++) {
+        if (students[i].rollNumber != TOMBSTONE_ID) {
+            entries[count].rollNumber = students[i].rollNumber;
+            entries[count].index = i;
+            count++;
+        }
+    }
+    qsort(entries, count, sizeof(RollEntry), compareRollEntries);
+    
+    int leafCount = (count + ROLL_LEAF_FILL - 1) / ROLL_LEAF_FILL;
+    for (int l = 0; l < leafCount; l++) {
+        if (!insertRollLeaf(l)) {
+            free(entries);
+            dropRollIndex();
+            return false;
+        }
+        RollLeaf *leaf = rollLeaves[l];
+        const RollEntry *first = entries + l * ROLL_LEAF_FILL;
+        leaf->count = count - l * ROLL_LEAF_FILL < ROLL_LEAF_FILL ? count - l * ROLL_LEAF_FILL : ROLL_LEAF_FILL;
+        for (int e = 0; e < leaf->count; e++) {
+            leaf->rolls[e] = first[e].rollNumber;
+            leaf->indexes[e] = first[e].index;
+        }
+        rollFences[l] = leaf->rolls[0];
+    }
+    free(entries);
+    rollIndexBuilt = true;
+    return true;
+}
+
+void dropRollIndex() {
+    for (int l = 0; l < rollLeafCount; l++) {
+        free(rollLeaves[l]);
+    }
+    free(rollLeaves);
+    free(rollFences);
+    rollLeaves = NULL;
+    rollFences = NULL;
+    rollLeafCount = 0;
+    rollLeafCapacity = 0;
+    rollIndexBuilt = false;
+}
+
+// A full leaf splits in two, so no insert moves more than one leaf's entries
+void rollIndexInsert(int rollNumber, int studentIndex) {
+    if (!rollIndexBuilt) {
+        return;
+    }
+    RollCursor cursor = rollIndexSeek(rollNumber);
+    if (rollLeafCount == 0) {
+        if (!insertRollLeaf(0)) {
+            dropRollIndex(); // rebuilt on the next lookup
+            return;
+        }
+    } else if (cursor.leaf == rollLeafCount) {
+        cursor.leaf--; // past every key: append to the last leaf
+        cursor.position = rollLeaves[cursor.leaf]->count;
+    }
+    
+    RollLeaf *leaf = rollLeaves[cursor.leaf];
+    if (leaf->count == ROLL_LEAF_SIZE) {
+        if (!insertRollLeaf(cursor.leaf + 1)) {
+            dropRollIndex();
+            return;
+        }
+        int half = ROLL_LEAF_SIZE / 2;
+        RollLeaf *upper = rollLeaves[cursor.leaf + 1];
+        memcpy(upper->rolls, leaf->rolls + half, (ROLL_LEAF_SIZE - half) * sizeof(int));
+        memcpy(upper->indexes, leaf->indexes + half, (ROLL_LEAF_SIZE - half) * sizeof(int));
+        upper->count = ROLL_LEAF_SIZE - half;
+        leaf->count = half;
+        rollFences[cursor.leaf + 1] = upper->rolls[0];
+        if (cursor.position > half) {
+            cursor.leaf++;
+            cursor.position -= half;
+            leaf = upper;
+        }
+    }
+    
+    int moved = leaf->count - cursor.position;
+    memmove(leaf->rolls + cursor.position + 1, leaf->rolls + cursor.position, moved * sizeof(int));
+    memmove(leaf->indexes + cursor.position + 1, leaf->indexes + cursor.position, moved * sizeof(int));
+    leaf->rolls[cursor.position] = rollNumber;
+    leaf->indexes[cursor.position] = studentIndex;
+    leaf->count++;
+    rollFences[cursor.leaf] = leaf->rolls[0];
+}
+
+// Removes the entry for this slot; records loaded from older files may
+// share a roll number, so the slot picks the right one
+void rollIndexRemove(int rollNumber, int studentIndex) {
+    if (!rollIndexBuilt) {
+        return;
+    }
+    RollCursor cursor = rollIndexSeek(rollNumber);
+    for (; cursor.leaf < rollLeafCount; rollCursorNext(&cursor)) {
+        const RollLeaf *leaf = rollLeaves[cursor.leaf];
+        if (leaf->rolls[cursor.position] != rollNumber) {
+            return;
+        }
+        if (leaf->indexes[cursor.position] == studentIndex) {
+            break;
+        }
+    }
+    if (cursor.leaf == rollLeafCount) {
+        return;
+    }
+    
+    RollLeaf *leaf = rollLeaves[cursor.leaf];
+    int moved = leaf->count - cursor.position - 1;
+    memmove(leaf->rolls + cursor.position, leaf->rolls + cursor.position + 1, moved * sizeof(int));
+    memmove(leaf->indexes + cursor.position, leaf->indexes + cursor.position + 1, moved * sizeof(int));
+    leaf->count--;
+    if (leaf->count == 0) {
+        removeRollLeaf(cursor.leaf);
+    } else {
+        rollFences[cursor.leaf] = leaf->rolls[0];
+    }
+}
+
+// First entry whose roll number is not below rollNumber. Only the last leaf
+// starting below it can hold that entry, unless it is the next leaf's first.
+RollCursor rollIndexSeek(int rollNumber) {
+    int low = 0;
+    int high = rollLeafCount;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (rollFences[mid] < rollNumber) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    RollCursor cursor = { low > 0 ? low - 1 : 0, 0 };
+    if (cursor.leaf == rollLeafCount) {
+        return cursor;
+    }
+    
+    const RollLeaf *leaf = rollLeaves[cursor.leaf];
+    low = 0;
+    high = leaf->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (leaf->rolls[mid] < rollNumber) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == leaf->count) {
+        cursor.leaf++;
+        low = 0;
+    }
+    cursor.position = low;
+    return cursor;
+}
+
+void rollCursorNext(RollCursor *cursor) {
+    if (++cursor->position == rollLeaves[cursor->leaf]->count) {
+        cursor->leaf++;
+        cursor->position = 0;
+    }
+}
+
+// Adds an empty leaf at position, shifting later leaves along
+bool insertRollLeaf(int position) {
+    if (rollLeafCount == rollLeafCapacity) {
+        int newCapacity = rollLeafCapacity > 0 ? rollLeafCapacity * 2 : 64;
+        RollLeaf **leaves = realloc(rollLeaves, newCapacity * sizeof(RollLeaf *));
+        if (leaves == NULL) {
+            return false;
+        }
+        rollLeaves = leaves;
+        int *fences = realloc(rollFences, newCapacity * sizeof(int));
+        if (fences == NULL) {
+            return false;
+        }
+        rollFences = fences;
+        rollLeafCapacity = newCapacity;
+    }
+    RollLeaf *leaf = malloc(sizeof(RollLeaf));
+    if (leaf == NULL) {
+        return false;
+    }
+    leaf->count = 0;
+    memmove(rollLeaves + position + 1, rollLeaves + position, (rollLeafCount - position) * sizeof(RollLeaf *));
+    memmove(rollFences + position + 1, rollFences + position, (rollLeafCount - position) * sizeof(int));
+    rollLeaves[position] = leaf;
+    rollLeafCount++;
+    return true;
+}
+
+void removeRollLeaf(int position) {
+    free(rollLeaves[position]);
+    memmove(rollLeaves + position, rollLeaves + position + 1, (rollLeafCount - position - 1) * sizeof(RollLeaf *));
+    memmove(rollFences + position, rollFences + position + 1, (rollLeafCount - position - 1) * sizeof(int));
+    rollLeafCount--;
+}
+
+// Roll number order; a shared roll number keeps slot order, so lookups
+// find the same record a scan of the table would
+int compareRollEntries(const void *a, const void *b) {
+    const RollEntry *left = a;
+    const RollEntry *right = b;
+    if (left->rollNumber != right->rollNumber) {
+        return (left->rollNumber > right->rollNumber) - (left->rollNumber < right->rollNumber);
+    }
+    return (left->index > right->index) - (left->index < right->index);
+}
+
 void printStudentDetails(int index) {
     printf("\n===== STUDENT DETAILS =====\n");
     printf("Roll Number: %d\n", students[index].rollNumber);
@@ -487,3 +2263,87 @@ void printStudentDetails(int index) {
 void clearInputBuffer() {
     while (getchar() != '\n');
 }
+
+// Flushes first when the padded column would not fit
+void tableText(TableBuffer *out, const char *text, int width) {
+    size_t length = strlen(text);
+    size_t padded = length < (size_t)width ? (size_t)width : length;
+    if (out->length + padded + 1 > sizeof(out->data)) {
+        tableFlush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    memset(out->data + out->length + length, ' ', padded - length + 1);
+    out->length += padded + 1;
+}
+
+void tableInt(TableBuffer *out, long long value, int width) {
+    char digits[24];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    *--cursor = '\0';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    tableText(out, cursor, width);
+}
+
+void tableChar(TableBuffer *out, char value, int width) {
+    char text[2] = { value, '\0' };
+    tableText(out, text, width);
+}
+
+void tableEndRow(TableBuffer *out) {
+    if (out->length > 0) {
+        out->data[out->length - 1] = '\n';
+    }
+}
+
+void tableStudentRow(TableBuffer *out, int index) {
+    const Student *student = &students[index];
+    tableInt(out, student->rollNumber, 10);
+    tableText(out, student->name, 20);
+    tableInt(out, student->age, 5);
+    tableChar(out, student->gender, 5);
+    tableText(out, student->course, 15);
+    tableInt(out, student->semester, 5);
+    tableInt(out, student->attendance, 5);
+    tableChar(out, student->grade, 0);
+    tableEndRow(out);
+}
+
+void printStudentTableHeader(const char *title) {
+    printf("\n===== %s =====\n", title);
+    printf("%-10s %-20s %-5s %-5s %-15s %-5s %-5s %s\n", 
+           "Roll No.", "Name", "Age", "Gen", "Course", "Sem", "Att%", "Grade");
+    printf("--------------------------------------------------------------------\n");
+}
+
+void tableFlush(TableBuffer *out) {
+    fflush(stdout);
+    size_t written = 0;
+    while (written < out->length) {
+        ssize_t result = write(STDOUT_FILENO, out->data + written, out->length - written);
+        if (result <= 0) {
+            break;
+        }
+        written += result;
+    }
+    out->length = 0;
+}
+
+bool nextPage(int shown, int total) {
+    printf("-- %d of %d shown, Enter for more, q to stop -- ", shown, total);
+    char line[16];
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return false;
+    }
+    if (strchr(line, '\n') == NULL && !feof(stdin)) {
+        clearInputBuffer();
+    }
+    return line[0] != 'q' && line[0] != 'Q';
+}
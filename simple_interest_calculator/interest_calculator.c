@@ -1,11 +1,24 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <stdbool.h>
 
+#define MONEY_TEXT_SIZE 24 // "-92233720368547758.08" and the terminator
+
+// Amounts in whole paise. Rate and time are read with two decimals as well,
+// so the whole calculation stays in exact integer arithmetic.
+typedef long long Money;
+
 // Function prototypes
 void displayWelcomeMessage();
-float calculateSimpleInterest(float principal, float rate, float time);
-void displayResult(float principal, float rate, float time, float interest, float total);
+Money readPositiveAmount();
+bool calculateSimpleInterest(Money principal, long long rate, long long time, Money *interest);
+void displayResult(Money principal, long long rate, long long time, Money interest, Money total);
 bool calculateAgain();
+bool moneyAdd(Money a, Money b, Money *result);
+bool parseMoney(const char *text, Money *amount);
+char *formatMoney(Money amount, char *buffer);
 
 int main() {
     printf("Simple Interest Calculator (Indian Rupees ₹)\n\n");
@@ -13,33 +26,29 @@ int main() {
     do {
         displayWelcomeMessage();
         
-        // Input variables
-        float principal, rate, time;
+        // Input variables, all scaled by 100
+        Money principal;
+        long long rate, time;
         
         // Get principal amount
         printf("Enter Principal Amount (₹): ");
-        while(scanf("%f", &principal) != 1 || principal <= 0) {
-            printf("Invalid input. Please enter a positive number: ");
-            while(getchar() != '\n'); // Clear input buffer
-        }
+        principal = readPositiveAmount();
         
         // Get annual interest rate
         printf("Enter Annual Interest Rate (%%): ");
-        while(scanf("%f", &rate) != 1 || rate <= 0) {
-            printf("Invalid input. Please enter a positive number: ");
-            while(getchar() != '\n');
-        }
+        rate = readPositiveAmount();
         
         // Get time period
         printf("Enter Time Period (in years): ");
-        while(scanf("%f", &time) != 1 || time <= 0) {
-            printf("Invalid input. Please enter a positive number: ");
-            while(getchar() != '\n');
-        }
+        time = readPositiveAmount();
         
         // Calculate simple interest
-        float interest = calculateSimpleInterest(principal, rate, time);
-        float total = principal + interest;
+        Money interest, total;
+        if (!calculateSimpleInterest(principal, rate, time, &interest) ||
+            !moneyAdd(principal, interest, &total)) {
+            printf("\nThe result is too large to calculate.\n");
+            continue;
+        }
         
         // Display results
         displayResult(principal, rate, time, interest, total);
@@ -56,19 +65,48 @@ void displayWelcomeMessage() {
     printf("================================\n");
 }
 
-float calculateSimpleInterest(float principal, float rate, float time) {
-    return (principal * rate * time) / 100;
+// Reads lines until one holds a positive number with at most two decimals
+Money readPositiveAmount() {
+    char line[64];
+    Money amount;
+    
+    for (;;) {
+        if (fgets(line, sizeof(line), stdin) == NULL) {
+            printf("\n");
+            exit(0);
+        }
+        if (strchr(line, '\n') == NULL) {
+            while(getchar() != '\n' && !feof(stdin)); // Clear input buffer
+        } else if (parseMoney(line, &amount) && amount > 0) {
+            return amount;
+        }
+        printf("Invalid input. Please enter a positive number (up to 2 decimals): ");
+    }
+}
+
+// principal * (rate / 100)% * (time / 100) years, rounded to the nearest paisa;
+// false if the intermediate product does not fit
+bool calculateSimpleInterest(Money principal, long long rate, long long time, Money *interest) {
+    long long product;
+    if (__builtin_mul_overflow(principal, rate, &product) ||
+        __builtin_mul_overflow(product, time, &product) ||
+        __builtin_add_overflow(product, 500000, &product)) {
+        return false;
+    }
+    *interest = product / 1000000;
+    return true;
 }
 
-void displayResult(float principal, float rate, float time, float interest, float total) {
+void displayResult(Money principal, long long rate, long long time, Money interest, Money total) {
+    char text[MONEY_TEXT_SIZE];
     printf("\nCalculation Results:\n");
     printf("--------------------------------\n");
-    printf("Principal Amount:      ₹%.2f\n", principal);
-    printf("Annual Interest Rate:  %.2f%%\n", rate);
-    printf("Time Period:           %.2f years\n", time);
+    printf("Principal Amount:      ₹%s\n", formatMoney(principal, text));
+    printf("Annual Interest Rate:  %s%%\n", formatMoney(rate, text));
+    printf("Time Period:           %s years\n", formatMoney(time, text));
     printf("--------------------------------\n");
-    printf("Simple Interest:       ₹%.2f\n", interest);
-    printf("Total Amount:          ₹%.2f\n", total);
+    printf("Simple Interest:       ₹%s\n", formatMoney(interest, text));
+    printf("Total Amount:          ₹%s\n", formatMoney(total, text));
     printf("--------------------------------\n");
 }
 
@@ -80,3 +118,87 @@ bool calculateAgain() {
     
     return (response == 'y' || response == 'Y');
 }
+
+// Overflow-checked addition; *result is left untouched on overflow
+bool moneyAdd(Money a, Money b, Money *result) {
+    Money sum;
+    if (__builtin_add_overflow(a, b, &sum)) {
+        return false;
+    }
+    *result = sum;
+    return true;
+}
+
+// Accepts an optional sign, digits and at most two decimals ("5000", "7.5")
+bool parseMoney(const char *text, Money *amount) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    bool negative = *text == '-';
+    if (*text == '-' || *text == '+') {
+        text++;
+    }
+    
+    Money value = 0;
+    int digits = 0;
+    for (; isdigit((unsigned char)*text); text++, digits++) {
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            __builtin_add_overflow(value, *text - '0', &value)) {
+            return false;
+        }
+    }
+    
+    int decimals = 0;
+    if (*text == '.') {
+        for (text++; isdigit((unsigned char)*text); text++, decimals++) {
+            if (decimals == 2) {
+                return false; // finer than one paisa
+            }
+            if (__builtin_mul_overflow(value, 10, &value) ||
+                __builtin_add_overflow(value, *text - '0', &value)) {
+                return false;
+            }
+        }
+    }
+    if (digits == 0 && decimals == 0) {
+        return false;
+    }
+    for (; decimals < 2; decimals++) {
+        if (__builtin_mul_overflow(value, 10, &value)) {
+            return false;
+        }
+    }
+    
+    while (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n') {
+        text++;
+    }
+    if (*text != '\0') {
+        return false;
+    }
+    *amount = negative ? -value : value;
+    return true;
+}
+
+// Writes the amount as "1234.56" into buffer (MONEY_TEXT_SIZE bytes) and returns it
+char *formatMoney(Money amount, char *buffer) {
+    char digits[MONEY_TEXT_SIZE];
+    char *cursor = digits + sizeof(digits);
+    unsigned long long magnitude = amount < 0 ? 0ULL - (unsigned long long)amount : (unsigned long long)amount;
+    
+    *--cursor = '\0';
+    *--cursor = '0' + magnitude % 10;
+    magnitude /= 10;
+    *--cursor = '0' + magnitude % 10;
+    magnitude /= 10;
+    *--cursor = '.';
+    do {
+        *--cursor = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (amount < 0) {
+        *--cursor = '-';
+    }
+    
+    memcpy(buffer, cursor, digits + sizeof(digits) - cursor);
+    return buffer;
+}